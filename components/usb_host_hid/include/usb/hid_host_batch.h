@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+#include "usb/hid_host.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Maximum number of input reports delivered in one batch
+ */
+#define HID_HOST_REPORT_BATCH_MAX   (16)
+
+/**
+ * @brief Input report descriptor in a batch
+ *
+ * @note data points to the IN transfer buffer of the interface and is valid only until the batch callback returns
+ */
+typedef struct {
+    hid_host_device_handle_t hid_device_handle; /**< Interface the report was received on */
+    void *arg;                                  /**< Interface callback arg given to hid_host_device_open() */
+    int64_t timestamp_us;                       /**< Transfer completion time, esp_timer_get_time() */
+    const uint8_t *data;                        /**< Report data, NULL if the interface was stopped during delivery */
+    size_t length;                              /**< Report length */
+} hid_host_report_t;
+
+/**
+ * @brief Batched input report callback
+ *
+ * @param[in] reports   Reports in completion order
+ * @param[in] count     Number of reports
+ * @param[in] arg       Argument given to hid_host_set_report_batch_callback()
+ */
+typedef void (*hid_host_report_batch_cb_t)(const hid_host_report_t *reports, size_t count, void *arg);
+
+/**
+ * @brief Deliver input reports in batches instead of one interface callback per report
+ *
+ * While enabled, HID_HOST_INTERFACE_EVENT_INPUT_REPORT is not sent to the interface callbacks. Completed reports
+ * are collected and passed to the batch callback once per hid_host_handle_events() call, or as soon as threshold
+ * reports are pending. The IN transfers of collected reports are relaunched after the batch callback returns, so
+ * no report data is copied. Pending reports are always delivered before any other driver or interface event.
+ *
+ * @note Call before starting any interface. The batch callback runs in the context of hid_host_handle_events()
+ *       and must not close or stop interfaces.
+ *
+ * @param[in] callback   Batch callback, NULL to go back to per-report interface callbacks
+ * @param[in] arg        Batch callback argument
+ * @param[in] threshold  Deliver when this many reports are pending, 1 .. HID_HOST_REPORT_BATCH_MAX
+ * @return esp_err_t
+ */
+esp_err_t hid_host_set_report_batch_callback(hid_host_report_batch_cb_t callback, void *arg, size_t threshold);
+
+/**
+ * @brief Get the completion time of the input report being delivered
+ *
+ * The time is taken when the IN transfer completes, before the report is passed to any callback. Use it from the
+ * HID_HOST_INTERFACE_EVENT_INPUT_REPORT callback; batched reports carry it in hid_host_report_t::timestamp_us.
+ *
+ * @param[in]  hid_dev_handle  HID Device handle
+ * @param[out] timestamp_us    Transfer completion time, esp_timer_get_time()
+ * @return esp_err_t
+ */
+esp_err_t hid_host_device_get_input_report_timestamp(hid_host_device_handle_t hid_dev_handle,
+                                                     int64_t *timestamp_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,55 @@
+/*
+ * SPDX-FileCopyrightText: 2026 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Heap usage of one owner
+ *
+ * Sizes are the requested sizes, without heap block headers or alignment padding.
+ */
+typedef struct {
+    size_t current;     /**< Bytes currently allocated */
+    size_t peak;        /**< Highest value of current since boot */
+    uint32_t allocs;    /**< Number of allocations */
+    uint32_t frees;     /**< Number of frees */
+} hid_host_mem_usage_t;
+
+/**
+ * @brief Heap usage of the HID Host driver, split by the layer that owns the memory
+ */
+typedef struct {
+    hid_host_mem_usage_t driver;    /**< Driver context, device and interface structures, semaphores, report descriptors */
+    hid_host_mem_usage_t usb;       /**< Transfers allocated from the USB Host library: EP0 control and interrupt IN */
+    uint32_t devices;               /**< Connected HID devices */
+    size_t device_bytes;            /**< Memory held for connected devices: device and interface structures, report descriptors and IN transfers */
+    size_t device_max_bytes;        /**< Memory held for the connected device that uses the most */
+    size_t ep0_bytes;               /**< Shared EP0 control transfer pool: transfers and semaphores, independent of the number of devices */
+} hid_host_mem_stats_t;
+
+/**
+ * @brief Get the heap usage of the HID Host driver
+ *
+ * Counters are updated with atomic operations at every allocation and free, and kept across driver reinstalls.
+ * Reading them does not walk the heap and can be done from any task. Per-device figures are computed from the
+ * device and interface lists, and are zero when the driver is not installed.
+ *
+ * @param[out] stats  Heap usage
+ * @return esp_err_t
+ */
+esp_err_t hid_host_get_mem_stats(hid_host_mem_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,168 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "chain.h"
+
+#define CHAIN_RX_CHUNK 64
+
+static uart_port_t rx_port = UART_NUM_1;
+static uint32_t char_us = 87;          // 一个字符 (10 位) 的传输时间
+static TaskHandle_t consumer_task = NULL;
+static event_queue_t upstream_queue;
+static frame_parser_t rx_parser;
+static uint32_t rx_seq = 0;            // 上游事件的本地序号, 用于归并时保持到达顺序
+static int32_t last_upstream_seq = -1;
+static chain_stats_t stats;
+
+bool chain_decode_event(const frame_parser_t *frame, uint32_t ts_us, key_event_t *event)
+{
+    if (frame->type != FRAME_TYPE_CHAIN_EVENT || frame->len != FRAME_CHAIN_EVENT_PAYLOAD_LEN)
+    {
+        return false;
+    }
+    const uint8_t *p = frame->payload;
+    event->ts_us = ts_us;
+    event->seq = p[0] | (p[1] << 8); // 先保存上游序号, 由调用者替换
+    event->bridge = p[2];
+    event->hops = p[3] + 1;
+    event->dev = p[4];
+    event->flags = p[5];
+    event->modifier = p[6];
+    event->key_code = p[7];
+    event->age = p[8] | (p[9] << 8);
+    return true;
+}
+
+size_t chain_encode_event(const key_event_t *event, uint16_t seq, uint32_t now_us, size_t tx_pending, uint8_t *out)
+{
+    uint32_t residence_us = now_us - event->ts_us + (uint32_t)tx_pending * char_us;
+    uint32_t age_us = event->age * 100u + residence_us;
+    key_event_t fwd = *event;
+    fwd.age = age_us / 100 > 0xFFFF ? 0xFFFF : (uint16_t)(age_us / 100);
+
+    if (event->hops > 0)
+    {
+        stats.hop_sum_us += residence_us;
+        stats.hop_count++;
+        if (residence_us > stats.hop_max_us)
+        {
+            stats.hop_max_us = residence_us;
+        }
+    }
+    if (event->bridge < CHAIN_MAX_BRIDGES)
+    {
+        stats.forwarded[event->bridge]++;
+        if (age_us > stats.age_max_us[event->bridge])
+        {
+            stats.age_max_us[event->bridge] = age_us;
+        }
+    }
+    if (tx_pending > stats.tx_pending_max)
+    {
+        stats.tx_pending_max = tx_pending;
+    }
+    return frame_encode_chain_event(&fwd, seq, out);
+}
+
+static void chain_rx_frame(uint32_t now_us)
+{
+    key_event_t event;
+    if (!chain_decode_event(&rx_parser, now_us, &event))
+    {
+        stats.rx_ignored++;
+        return;
+    }
+    stats.rx_frames++;
+    uint16_t upstream_seq = (uint16_t)event.seq;
+    if (last_upstream_seq >= 0)
+    {
+        stats.rx_lost += (uint16_t)(upstream_seq - (uint16_t)last_upstream_seq - 1);
+    }
+    last_upstream_seq = upstream_seq;
+    event.seq = rx_seq++;
+    event_queue_push(&upstream_queue, &event);
+    uint32_t depth = upstream_queue.head - upstream_queue.tail;
+    if (depth > stats.queue_max)
+    {
+        stats.queue_max = depth;
+    }
+}
+
+static void chain_rx_task(void *pvParameters)
+{
+    uint8_t buf[CHAIN_RX_CHUNK];
+    while (1)
+    {
+        // 先阻塞等待第一个字节, 再取走已到达的全部数据, 不等满一个 tick:
+        int n = uart_read_bytes(rx_port, buf, 1, portMAX_DELAY);
+        if (n <= 0)
+        {
+            continue;
+        }
+        size_t buffered = 0;
+        uart_get_buffered_data_len(rx_port, &buffered);
+        if (buffered + 1 > stats.rx_buffered_max)
+        {
+            stats.rx_buffered_max = buffered + 1;
+        }
+        if (buffered > 0)
+        {
+            int more = uart_read_bytes(rx_port, buf + 1, buffered < sizeof(buf) - 1 ? buffered : sizeof(buf) - 1, 0);
+            n += more > 0 ? more : 0;
+        }
+        uint32_t now_us = (uint32_t)esp_timer_get_time();
+        bool received = false;
+        for (int i = 0; i < n; i++)
+        {
+            if (frame_parse_byte(&rx_parser, buf[i]))
+            {
+                chain_rx_frame(now_us);
+                received = true;
+            }
+        }
+        if (received && consumer_task != NULL)
+        {
+            xTaskNotifyGive(consumer_task);
+        }
+    }
+}
+
+void chain_start(uart_port_t port, int baud_rate, TaskHandle_t consumer)
+{
+    rx_port = port;
+    char_us = 10000000u / (uint32_t)baud_rate;
+    consumer_task = consumer;
+    xTaskCreate(chain_rx_task, "chain_rx_task", 4096, NULL, 11, NULL);
+    ESP_LOGI("CHAIN", "Receiving upstream events on UART %d", port);
+}
+
+event_queue_t *chain_upstream_queue(void)
+{
+    return &upstream_queue;
+}
+
+const chain_stats_t *chain_get_stats(void)
+{
+    return &stats;
+}
+
+void chain_log_stats(void)
+{
+    ESP_LOGI("CHAIN", "rx: frames=%" PRIu32 " lost=%" PRIu32 " ignored=%" PRIu32 " crc_errors=%" PRIu32
+                      " dropped=%" PRIu32 " hop us avg/max=%" PRIu64 "/%" PRIu32
+                      " max occupancy rx=%" PRIu32 "B queue=%" PRIu32 " tx=%" PRIu32 "B",
+             stats.rx_frames, stats.rx_lost, stats.rx_ignored, rx_parser.crc_errors, upstream_queue.dropped,
+             stats.hop_count ? stats.hop_sum_us / stats.hop_count : 0, stats.hop_max_us,
+             stats.rx_buffered_max, stats.queue_max, stats.tx_pending_max);
+    for (int i = 0; i < CHAIN_MAX_BRIDGES; i++)
+    {
+        if (stats.forwarded[i] > 0)
+        {
+            ESP_LOGI("CHAIN", "bridge %d: forwarded=%" PRIu32 " max age us=%" PRIu32,
+                     i, stats.forwarded[i], stats.age_max_us[i]);
+        }
+    }
+}
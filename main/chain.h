@@ -0,0 +1,50 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/uart.h"
+#include "event_queue.h"
+#include "frame.h"
+
+// 级联聚合: 每个桥从 RX 接收上游桥的 FRAME_TYPE_CHAIN_EVENT 帧, 与本机键盘事件归并后,
+// 按本机的全局序号重新编号从 TX 转发, 链路末端看到的是一个连续的端到端序号空间.
+// 上游序号的缺口计入 rx_lost, 帧中的累计延迟 (age) 每经过一跳加上本机的停留时间.
+
+#define CHAIN_MAX_BRIDGES 8   // 桥编号 0 ~ 7
+
+typedef struct
+{
+    uint32_t rx_frames;                        // 收到的上游事件帧
+    uint32_t rx_lost;                          // 上游序号缺口 (链路丢帧或 CRC 错误)
+    uint32_t rx_ignored;                       // 其他类型的帧
+    uint32_t hop_max_us;                       // 本跳停留时间: 收到到预计发出
+    uint64_t hop_sum_us;
+    uint32_t hop_count;
+    uint32_t rx_buffered_max;                  // UART RX 缓冲区最高占用 (字节)
+    uint32_t queue_max;                        // 上游事件队列最高占用
+    uint32_t tx_pending_max;                   // 输出队列最高占用 (字节)
+    uint32_t forwarded[CHAIN_MAX_BRIDGES];     // 按来源桥统计的转发事件
+    uint32_t age_max_us[CHAIN_MAX_BRIDGES];    // 按来源桥统计的最大端到端延迟
+} chain_stats_t;
+
+// 启动 RX 接收任务, 收到上游事件后通知 consumer 任务:
+void chain_start(uart_port_t port, int baud_rate, TaskHandle_t consumer);
+
+// 上游事件队列, 由 RX 任务写入, 与本机键盘队列一起参与归并:
+event_queue_t *chain_upstream_queue(void);
+
+// 将一个已解析的级联事件帧转换为事件, ts_us 为本机收到的时间; 不是级联事件帧时返回 false:
+bool chain_decode_event(const frame_parser_t *frame, uint32_t ts_us, key_event_t *event);
+
+// 编码转发帧: 累计延迟加上本机停留时间 (含 tx_pending 字节的预计排队时间):
+size_t chain_encode_event(const key_event_t *event, uint16_t seq, uint32_t now_us, size_t tx_pending, uint8_t *out);
+
+const chain_stats_t *chain_get_stats(void);
+
+void chain_log_stats(void);
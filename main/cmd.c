@@ -0,0 +1,78 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "cmd.h"
+
+#define CMD_RX_CHUNK 64
+
+static uart_port_t rx_port = UART_NUM_1;
+static cmd_handler_t handlers[CMD_MAX_TYPES];
+static frame_parser_t rx_parser;
+static cmd_stats_t stats;
+
+void cmd_register(uint8_t type, cmd_handler_t handler)
+{
+    if (type < CMD_MAX_TYPES)
+    {
+        handlers[type] = handler;
+    }
+}
+
+static void cmd_rx_task(void *pvParameters)
+{
+    uint8_t buf[CMD_RX_CHUNK];
+    while (1)
+    {
+        // 先阻塞等待第一个字节, 再取走已到达的全部数据:
+        int n = uart_read_bytes(rx_port, buf, 1, portMAX_DELAY);
+        if (n <= 0)
+        {
+            continue;
+        }
+        size_t buffered = 0;
+        uart_get_buffered_data_len(rx_port, &buffered);
+        if (buffered > 0)
+        {
+            int more = uart_read_bytes(rx_port, buf + 1, buffered < sizeof(buf) - 1 ? buffered : sizeof(buf) - 1, 0);
+            n += more > 0 ? more : 0;
+        }
+        for (int i = 0; i < n; i++)
+        {
+            if (!frame_parse_byte(&rx_parser, buf[i]))
+            {
+                continue;
+            }
+            if (rx_parser.type < CMD_MAX_TYPES && handlers[rx_parser.type] != NULL)
+            {
+                stats.frames++;
+                handlers[rx_parser.type](&rx_parser);
+            }
+            else
+            {
+                stats.unknown++;
+            }
+        }
+    }
+}
+
+void cmd_start(uart_port_t port)
+{
+    rx_port = port;
+    xTaskCreate(cmd_rx_task, "cmd_rx_task", 4096, NULL, 11, NULL);
+    ESP_LOGI("CMD", "Command channel on UART %d RX", port);
+}
+
+const cmd_stats_t *cmd_get_stats(void)
+{
+    return &stats;
+}
+
+void cmd_log_stats(void)
+{
+    ESP_LOGI("CMD", "rx: frames=%" PRIu32 " unknown=%" PRIu32 " crc_errors=%" PRIu32,
+             stats.frames, stats.unknown, rx_parser.crc_errors);
+}
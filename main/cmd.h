@@ -0,0 +1,30 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdint.h>
+#include "driver/uart.h"
+#include "frame.h"
+
+// 串口命令通道: 在 RX 上接收二进制帧 (格式见 frame.h), 按帧类型分发给注册的处理函数.
+// 处理函数在命令任务中执行, 需要发送的应答由发送任务负责, 不能在处理函数中阻塞.
+
+#define CMD_MAX_TYPES 16    // 可注册的帧类型 0 ~ 15
+
+typedef void (*cmd_handler_t)(const frame_parser_t *frame);
+
+typedef struct
+{
+    uint32_t frames;    // 已分发的帧
+    uint32_t unknown;   // 没有处理函数的帧
+} cmd_stats_t;
+
+// 必须在 cmd_start() 之前注册:
+void cmd_register(uint8_t type, cmd_handler_t handler);
+
+void cmd_start(uart_port_t port);
+
+const cmd_stats_t *cmd_get_stats(void);
+
+void cmd_log_stats(void);
@@ -0,0 +1,554 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "encoder.h"
+#include "frame.h"
+#include "keymap.h"
+
+#define ENCODER_CHECK_SEQ16 0x20
+#define ENCODER_CHECK_FROM 0x1F
+
+// 模板记号, 每个记号输出一个字节:
+enum
+{
+    TOK_BYTE,
+    TOK_KEY,
+    TOK_ASCII,
+    TOK_MOD,
+    TOK_DEV,
+    TOK_SEQ,    // 序号低字节, {seq} 后跟 TOK_SEQ_HI
+    TOK_SEQ_HI,
+    TOK_CHECK,  // val: 校验类型 << 6 | 起始位置
+};
+
+typedef struct
+{
+    uint8_t kind;
+    uint8_t lo;
+    uint8_t hi;
+    uint8_t len;
+    uint8_t tok[ENCODER_TEMPLATE_MAX];
+    uint8_t val[ENCODER_TEMPLATE_MAX];
+} rule_t;
+
+static encoder_allocator_t allocator = {malloc, free};
+
+static void *enc_alloc(size_t size)
+{
+    return allocator.alloc(size);
+}
+
+static void enc_free(void *ptr)
+{
+    allocator.free(ptr);
+}
+
+void encoder_set_allocator(const encoder_allocator_t *a)
+{
+    allocator = *a;
+}
+
+static uint8_t checksum(uint8_t type, const uint8_t *data, size_t len)
+{
+    if (type == ENCODER_CHECK_CRC8)
+    {
+        return frame_crc8(0, data, len);
+    }
+    uint8_t c = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        c = type == ENCODER_CHECK_XOR ? c ^ data[i] : (uint8_t)(c + data[i]);
+    }
+    return c;
+}
+
+void encoder_patch(const encoder_entry_t *e, const key_event_t *event, uint16_t seq, uint8_t *out)
+{
+    if (e->mod_pos != ENCODER_NONE)
+    {
+        out[e->mod_pos] = event->modifier;
+    }
+    if (e->dev_pos != ENCODER_NONE)
+    {
+        out[e->dev_pos] = event->dev;
+    }
+    if (e->seq_pos != ENCODER_NONE)
+    {
+        out[e->seq_pos] = seq & 0xFF;
+        if (e->check & ENCODER_CHECK_SEQ16)
+        {
+            out[e->seq_pos + 1] = seq >> 8;
+        }
+    }
+    uint8_t type = e->check >> 6;
+    if (type != ENCODER_CHECK_NONE)
+    {
+        uint8_t from = e->check & ENCODER_CHECK_FROM;
+        out[e->check_pos] = checksum(type, &out[from], e->check_pos - from);
+    }
+}
+
+// ------------------------- 解析 -------------------------
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int hex_digit(char c)
+{
+    return c >= '0' && c <= '9'   ? c - '0'
+           : c >= 'a' && c <= 'f' ? c - 'a' + 10
+           : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                  : -1;
+}
+
+// 解析 0..255 的数, 支持 0x 前缀:
+static bool parse_u8(const char *s, size_t n, uint8_t *out)
+{
+    char buf[8];
+    if (n == 0 || n >= sizeof(buf))
+    {
+        return false;
+    }
+    memcpy(buf, s, n);
+    buf[n] = 0;
+    char *end;
+    unsigned long v = strtoul(buf, &end, 0);
+    if (*end != 0 || v > 0xFF)
+    {
+        return false;
+    }
+    *out = (uint8_t)v;
+    return true;
+}
+
+static bool token_is(const char *s, size_t n, const char *name)
+{
+    return strlen(name) == n && memcmp(s, name, n) == 0;
+}
+
+static bool rule_push(rule_t *r, uint8_t tok, uint8_t val)
+{
+    if (r->len == ENCODER_TEMPLATE_MAX)
+    {
+        return false;
+    }
+    r->tok[r->len] = tok;
+    r->val[r->len] = val;
+    r->len++;
+    return true;
+}
+
+// 解析字符串记号 s (指向左引号), 返回记号之后的位置, 出错返回 NULL:
+static const char *parse_string(rule_t *r, const char *s, const char **error)
+{
+    s++;
+    while (*s != '"')
+    {
+        if (*s == 0 || *s == '\n')
+        {
+            *error = "unterminated string";
+            return NULL;
+        }
+        char c = *s++;
+        if (c == '\\')
+        {
+            c = *s++;
+            c = c == 'r' ? '\r' : c == 'n' ? '\n' : c == 't' ? '\t' : c == 'e' ? 0x1B : c;
+            if (c != '\\' && c != '"' && c != '\r' && c != '\n' && c != '\t' && c != 0x1B)
+            {
+                *error = "bad escape in string";
+                return NULL;
+            }
+        }
+        if (!rule_push(r, TOK_BYTE, (uint8_t)c))
+        {
+            *error = "template too long";
+            return NULL;
+        }
+    }
+    return s + 1;
+}
+
+// 解析 {...} 字段记号:
+static bool parse_field(rule_t *r, const char *s, size_t n, const char **error)
+{
+    static const struct
+    {
+        const char *name;
+        uint8_t tok;
+    } fields[] = {{"key", TOK_KEY}, {"ascii", TOK_ASCII}, {"mod", TOK_MOD}, {"dev", TOK_DEV},
+                  {"seq", TOK_SEQ}, {"seq8", TOK_SEQ}};
+    static const char *checks[] = {NULL, "xor", "sum", "crc8"};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+    {
+        if (!token_is(s, n, fields[i].name))
+        {
+            continue;
+        }
+        uint8_t tok = fields[i].tok;
+        // 运行时字段每个模板只能出现一次, 表项只记录一个位置:
+        for (size_t j = 0; j < r->len; j++)
+        {
+            if (tok != TOK_KEY && tok != TOK_ASCII && r->tok[j] == tok)
+            {
+                *error = "field used twice";
+                return false;
+            }
+        }
+        bool ok = rule_push(r, tok, 0);
+        if (ok && token_is(s, n, "seq"))
+        {
+            ok = rule_push(r, TOK_SEQ_HI, 0);
+        }
+        if (!ok)
+        {
+            *error = "template too long";
+        }
+        return ok;
+    }
+    const char *at = memchr(s, '@', n);
+    size_t name_len = at ? (size_t)(at - s) : n;
+    for (uint8_t type = ENCODER_CHECK_XOR; type <= ENCODER_CHECK_CRC8; type++)
+    {
+        if (!token_is(s, name_len, checks[type]))
+        {
+            continue;
+        }
+        uint8_t from = 0;
+        if (at && !parse_u8(at + 1, n - name_len - 1, &from))
+        {
+            *error = "bad checksum start";
+            return false;
+        }
+        for (size_t j = 0; j < r->len; j++)
+        {
+            if (r->tok[j] == TOK_CHECK)
+            {
+                *error = "more than one checksum";
+                return false;
+            }
+        }
+        if (from >= r->len)
+        {
+            *error = "checksum covers no bytes";
+            return false;
+        }
+        if (!rule_push(r, TOK_CHECK, (uint8_t)(type << 6 | from)))
+        {
+            *error = "template too long";
+            return false;
+        }
+        return true;
+    }
+    *error = "unknown field";
+    return false;
+}
+
+// 解析一行规则, 空行与注释行返回 true 且 r->len 不变, kind 为 ENCODER_KINDS:
+static bool parse_line(rule_t *r, const char *s, const char **error)
+{
+    memset(r, 0, sizeof(*r));
+    r->kind = ENCODER_KINDS;
+    int field = 0; // 0: 事件, 1: 键码, 2: 模板
+    while (1)
+    {
+        while (is_space(*s))
+        {
+            s++;
+        }
+        if (*s == 0 || *s == '\n' || *s == '#')
+        {
+            break;
+        }
+        if (field == 2 && *s == '"')
+        {
+            if ((s = parse_string(r, s, error)) == NULL)
+            {
+                return false;
+            }
+            continue;
+        }
+        const char *start = s;
+        while (*s != 0 && *s != '\n' && !is_space(*s) && *s != '#')
+        {
+            s++;
+        }
+        size_t n = (size_t)(s - start);
+        if (field == 0)
+        {
+            static const char *kinds[ENCODER_KINDS] = {"press", "release", "repeat"};
+            for (uint8_t k = 0; k < ENCODER_KINDS; k++)
+            {
+                if (token_is(start, n, kinds[k]))
+                {
+                    r->kind = k;
+                }
+            }
+            if (r->kind == ENCODER_KINDS)
+            {
+                *error = "unknown event, expected press, release or repeat";
+                return false;
+            }
+        }
+        else if (field == 1)
+        {
+            const char *dash = memchr(start, '-', n);
+            if (token_is(start, n, "*"))
+            {
+                r->lo = 0x00;
+                r->hi = 0xFF;
+            }
+            else if (dash ? !parse_u8(start, (size_t)(dash - start), &r->lo) ||
+                                !parse_u8(dash + 1, (size_t)(s - dash - 1), &r->hi) || r->lo > r->hi
+                          : !parse_u8(start, n, &r->lo))
+            {
+                *error = "bad key code or range";
+                return false;
+            }
+            else if (!dash)
+            {
+                r->hi = r->lo;
+            }
+        }
+        else if (*start == '{')
+        {
+            if (start[n - 1] != '}' || !parse_field(r, start + 1, n - 2, error))
+            {
+                *error = start[n - 1] != '}' ? "unterminated field" : *error;
+                return false;
+            }
+        }
+        else
+        {
+            int h = n == 2 ? hex_digit(start[0]) : -1;
+            int l = n == 2 ? hex_digit(start[1]) : -1;
+            if (h < 0 || l < 0)
+            {
+                *error = "bad byte, expected two hex digits";
+                return false;
+            }
+            if (!rule_push(r, TOK_BYTE, (uint8_t)(h << 4 | l)))
+            {
+                *error = "template too long";
+                return false;
+            }
+        }
+        field = field < 2 ? field + 1 : 2;
+    }
+    if (field == 1)
+    {
+        *error = "missing key code";
+        return false;
+    }
+    return true;
+}
+
+// ------------------------- 编译 -------------------------
+
+// 按规则生成一个键的模板, 返回长度, {ascii} 无对应字符时返回 0:
+static size_t render(const rule_t *r, uint8_t key, uint8_t cls, uint8_t *out, encoder_entry_t *e)
+{
+    e->mod_pos = e->dev_pos = e->seq_pos = e->check_pos = ENCODER_NONE;
+    e->check = 0;
+    for (uint8_t i = 0; i < r->len; i++)
+    {
+        out[i] = 0;
+        switch (r->tok[i])
+        {
+        case TOK_BYTE:
+            out[i] = r->val[i];
+            break;
+        case TOK_KEY:
+            out[i] = key;
+            break;
+        case TOK_ASCII:
+            // 类别 bit0 = Ctrl, bit1 = Shift, 与左侧修饰键的位相同:
+            out[i] = (uint8_t)usb_keycode_to_ascii(key, cls);
+            if (out[i] == 0)
+            {
+                return 0;
+            }
+            break;
+        case TOK_MOD:
+            e->mod_pos = i;
+            break;
+        case TOK_DEV:
+            e->dev_pos = i;
+            break;
+        case TOK_SEQ:
+            e->seq_pos = i;
+            break;
+        case TOK_SEQ_HI:
+            e->check |= ENCODER_CHECK_SEQ16;
+            break;
+        case TOK_CHECK:
+            e->check_pos = i;
+            e->check |= r->val[i];
+            break;
+        }
+    }
+    // 没有运行时字段时校验在编译时算出, 编码只需复制:
+    if ((e->mod_pos & e->dev_pos & e->seq_pos) == ENCODER_NONE && e->check_pos != ENCODER_NONE)
+    {
+        uint8_t from = e->check & ENCODER_CHECK_FROM;
+        out[e->check_pos] = checksum(e->check >> 6, &out[from], e->check_pos - from);
+        e->check = 0;
+        e->check_pos = ENCODER_NONE;
+    }
+    return r->len;
+}
+
+// 生成全部表项. 字节池为 NULL 时只计算大小; 与上一项相同的模板共用字节池中的同一份:
+static bool build(encoder_t *enc, const rule_t *rules, size_t count)
+{
+    uint8_t prev[ENCODER_TEMPLATE_MAX];
+    size_t prev_len = 0;
+    size_t pool_len = 0;
+    for (uint8_t kind = 0; kind < ENCODER_KINDS; kind++)
+    {
+        if (enc->kind_plane[kind] < 0)
+        {
+            continue;
+        }
+        for (uint8_t cls = 0; cls <= enc->class_mask; cls++)
+        {
+            encoder_entry_t *row = &enc->table[(enc->kind_plane[kind] + cls) * 256];
+            for (int key = 0; key < 256; key++)
+            {
+                encoder_entry_t *e = &row[key];
+                const rule_t *r = NULL;
+                for (size_t i = count; i-- > 0;)
+                {
+                    if (rules[i].kind == kind && key >= rules[i].lo && key <= rules[i].hi)
+                    {
+                        r = &rules[i];
+                        break;
+                    }
+                }
+                uint8_t out[ENCODER_TEMPLATE_MAX];
+                size_t len = r ? render(r, (uint8_t)key, cls, out, e) : 0;
+                e->len = (uint8_t)len;
+                if (len == 0)
+                {
+                    *e = (encoder_entry_t){.mod_pos = ENCODER_NONE, .dev_pos = ENCODER_NONE,
+                                           .seq_pos = ENCODER_NONE, .check_pos = ENCODER_NONE};
+                    continue;
+                }
+                if (len == prev_len && memcmp(out, prev, len) == 0)
+                {
+                    e->offset = (uint16_t)(pool_len - len);
+                    continue;
+                }
+                if (pool_len + len > ENCODER_POOL_MAX)
+                {
+                    return false;
+                }
+                if (enc->pool)
+                {
+                    memcpy(&enc->pool[pool_len], out, len);
+                }
+                e->offset = (uint16_t)pool_len;
+                pool_len += len;
+                memcpy(prev, out, len);
+                prev_len = len;
+            }
+        }
+    }
+    enc->pool_len = pool_len;
+    return true;
+}
+
+bool encoder_compile(encoder_t *enc, const char *def)
+{
+    *enc = (encoder_t){.kind_plane = {-1, -1, -1}};
+    rule_t *rules = enc_alloc(sizeof(rule_t) * ENCODER_RULES_MAX);
+    if (rules == NULL)
+    {
+        enc->error = "out of memory";
+        return false;
+    }
+    size_t count = 0;
+    bool ascii = false;
+    int line = 1;
+    for (const char *s = def; *s; line++)
+    {
+        rule_t r;
+        if (!parse_line(&r, s, &enc->error))
+        {
+            enc->error_line = line;
+            enc_free(rules);
+            return false;
+        }
+        if (r.kind != ENCODER_KINDS)
+        {
+            if (count == ENCODER_RULES_MAX)
+            {
+                enc->error_line = line;
+                enc->error = "too many rules";
+                enc_free(rules);
+                return false;
+            }
+            ascii = ascii || memchr(r.tok, TOK_ASCII, r.len) != NULL;
+            rules[count++] = r;
+        }
+        const char *nl = strchr(s, '\n');
+        s = nl ? nl + 1 : s + strlen(s);
+    }
+    if (count == 0)
+    {
+        enc->error = "no rules";
+        enc_free(rules);
+        return false;
+    }
+    // 只为出现过的事件分配平面, {ascii} 需要按 Ctrl / Shift 组合各一个平面:
+    enc->class_mask = ascii ? 3 : 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (enc->kind_plane[rules[i].kind] < 0)
+        {
+            enc->kind_plane[rules[i].kind] = (int8_t)enc->planes;
+            enc->planes += enc->class_mask + 1;
+        }
+    }
+    enc->rules = (uint8_t)count;
+    enc->table = enc_alloc(sizeof(encoder_entry_t) * 256 * enc->planes);
+    // 第一遍计算字节池大小, 第二遍写入:
+    bool ok = enc->table != NULL && build(enc, rules, count);
+    if (!ok)
+    {
+        enc->error = enc->table ? "templates exceed pool size" : "out of memory";
+    }
+    else if ((enc->pool = enc_alloc(enc->pool_len + ENCODER_TEMPLATE_MAX)) == NULL)
+    {
+        enc->error = "out of memory";
+        ok = false;
+    }
+    else
+    {
+        memset(enc->pool, 0, enc->pool_len + ENCODER_TEMPLATE_MAX);
+        build(enc, rules, count);
+    }
+    enc_free(rules);
+    if (!ok)
+    {
+        encoder_free(enc);
+    }
+    return ok;
+}
+
+void encoder_free(encoder_t *enc)
+{
+    enc_free(enc->table);
+    enc_free(enc->pool);
+    enc->table = NULL;
+    enc->pool = NULL;
+}
+
+size_t encoder_memory(const encoder_t *enc)
+{
+    return sizeof(encoder_entry_t) * 256 * enc->planes + enc->pool_len;
+}
@@ -0,0 +1,121 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "event_queue.h"
+
+// 表驱动输出编码: 接收端协议由文本定义描述, 加载时编译为 [事件类型][修饰键类别][键码] 的分发表
+// 和模板字节池, 编码一个事件只需查表并复制模板, 再填入少量运行时字段.
+//
+// 定义每行一条规则, # 之后为注释:
+//   <事件> <键码> <模板...>
+// 事件: press / release / repeat. 键码: * (全部), 0x28, 0x04-0x1D.
+// 同一事件和键码匹配多条规则时, 后出现的规则优先, 因此通用规则写在前面.
+// 模板由以下记号组成, 为空表示该键不输出:
+//   1B          一个字节, 两位十六进制
+//   "text"      字符串的各字节, 支持 \\ \" \r \n \t \e
+//   {key}       USB 键码
+//   {ascii}     键码按 Ctrl / Shift 转换的 ASCII 字符, 见 keymap.h; 无对应字符时该键不输出
+//   {mod}       修饰键          } 运行时填入, 每种最多一个
+//   {dev}       键盘编号        }
+//   {seq}       全局序号 (u16 LE), {seq8} 只取低字节
+//   {xor} {sum} {crc8}          校验字节, 覆盖模板开头至校验之前, {crc8@1} 从第 1 字节开始;
+//                               crc8 与二进制帧相同 (多项式 0x07, 初值 0). 每个模板最多一个
+// 例:
+//   press  *     {ascii}
+//   repeat *     {ascii}
+//   press  0x52  "\e[A"         # 上箭头
+
+#define ENCODER_TEMPLATE_MAX 16  // 每个事件最多输出的字节数, 与输出队列项相同
+#define ENCODER_RULES_MAX 64
+#define ENCODER_POOL_MAX 16384   // 模板字节池上限
+
+#define ENCODER_PRESS 0
+#define ENCODER_RELEASE 1
+#define ENCODER_REPEAT 2
+#define ENCODER_KINDS 3
+
+#define ENCODER_NONE 0xFF        // 字段不存在
+
+// 校验类型, 存放在 encoder_entry_t.check 的高 2 位:
+#define ENCODER_CHECK_NONE 0
+#define ENCODER_CHECK_XOR 1
+#define ENCODER_CHECK_SUM 2
+#define ENCODER_CHECK_CRC8 3
+
+// 分发表项, 8 字节:
+typedef struct
+{
+    uint16_t offset;   // 模板在字节池中的位置
+    uint8_t len;       // 模板长度, 0 表示不输出
+    uint8_t mod_pos;   // 各运行时字段在模板中的位置, ENCODER_NONE 表示没有
+    uint8_t dev_pos;
+    uint8_t seq_pos;
+    uint8_t check_pos;
+    uint8_t check;     // bit7~6 校验类型, bit5 序号为 16 位, bit4~0 校验起始位置
+} encoder_entry_t;
+
+typedef struct
+{
+    encoder_entry_t *table;              // planes * 256 项
+    uint8_t *pool;                       // pool_len 字节之后补 ENCODER_TEMPLATE_MAX 字节 0
+    size_t pool_len;
+    int8_t kind_plane[ENCODER_KINDS];    // 每种事件的第一个平面, -1 表示该事件不输出
+    uint8_t class_mask;                  // 使用 {ascii} 时为 3, 每种事件按修饰键类别分 4 个平面, 否则为 0
+    uint8_t planes;
+    uint8_t rules;
+    // 编译失败时的位置与原因:
+    int error_line;
+    const char *error;
+} encoder_t;
+
+// 分发表、字节池与编译时临时规则表的分配函数, 默认为 malloc / free. 固件换成按子系统统计的分配
+// (见 mem_stats.h), 本模块不依赖固件的其他部分, 可以单独在主机上编译. 在第一次编译之前设置:
+typedef struct
+{
+    void *(*alloc)(size_t size);
+    void (*free)(void *ptr);
+} encoder_allocator_t;
+
+void encoder_set_allocator(const encoder_allocator_t *allocator);
+
+// 编译以 \0 结尾的定义, 成功返回 true. 失败时 error_line / error 指出第一处错误:
+bool encoder_compile(encoder_t *enc, const char *def);
+
+void encoder_free(encoder_t *enc);
+
+// 分发表与字节池占用的内存:
+size_t encoder_memory(const encoder_t *enc);
+
+// 带运行时字段的表项, 由 encoder_encode() 调用:
+void encoder_patch(const encoder_entry_t *e, const key_event_t *event, uint16_t seq, uint8_t *out);
+
+// 编码一个事件写入 out (至少 ENCODER_TEMPLATE_MAX 字节), 返回长度, 不输出时返回 0.
+// 带 KEY_EVENT_REPEAT 的事件使用 repeat 规则:
+static inline size_t encoder_encode(const encoder_t *enc, const key_event_t *event, uint16_t seq, uint8_t *out)
+{
+    int kind = (event->flags & KEY_EVENT_REPEAT) ? ENCODER_REPEAT
+               : (event->flags & KEY_EVENT_PRESS) ? ENCODER_PRESS
+                                                  : ENCODER_RELEASE;
+    int plane = enc->kind_plane[kind];
+    if (plane < 0)
+    {
+        return 0;
+    }
+    // 左右 Ctrl / Shift 合并为类别, 与 keymap.c 的查找表相同:
+    uint8_t mod = event->modifier;
+    plane += (mod | (mod >> 4)) & enc->class_mask;
+    const encoder_entry_t *e = &enc->table[plane * 256 + event->key_code];
+    // 字节池末尾留有 ENCODER_TEMPLATE_MAX 字节, 总是复制定长, 编译为几条定长写入而不是按长度调用 memcpy:
+    memcpy(out, &enc->pool[e->offset], ENCODER_TEMPLATE_MAX);
+    if ((e->mod_pos & e->dev_pos & e->seq_pos) != ENCODER_NONE)
+    {
+        encoder_patch(e, event, seq, out);
+    }
+    return e->len;
+}
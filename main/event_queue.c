@@ -0,0 +1,86 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include "event_queue.h"
+
+bool event_queue_push(event_queue_t *queue, const key_event_t *event)
+{
+    uint32_t head = queue->head;
+    if (head - __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) >= EVENT_QUEUE_SIZE)
+    {
+        queue->dropped++;
+        return false;
+    }
+    queue->events[head & (EVENT_QUEUE_SIZE - 1)] = *event;
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+const key_event_t *event_queue_peek(event_queue_t *queue)
+{
+    uint32_t tail = queue->tail;
+    if (__atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) == tail)
+    {
+        return NULL;
+    }
+    return &queue->events[tail & (EVENT_QUEUE_SIZE - 1)];
+}
+
+void event_queue_pop(event_queue_t *queue)
+{
+    __atomic_store_n(&queue->tail, queue->tail + 1, __ATOMIC_RELEASE);
+}
+
+// a 是否早于 b, 时间戳与序号都按回绕差值比较:
+static inline bool key_event_before(const key_event_t *a, const key_event_t *b)
+{
+    int32_t dt = (int32_t)(a->ts_us - b->ts_us);
+    if (dt != 0)
+    {
+        return dt < 0;
+    }
+    if (a->dev != b->dev)
+    {
+        return a->dev < b->dev;
+    }
+    return (int32_t)(a->seq - b->seq) < 0;
+}
+
+size_t event_merge(event_queue_t *const *queues, const bool *active, size_t count,
+                   uint32_t now_us, uint32_t window_us, key_event_t *out, size_t max)
+{
+    size_t n = 0;
+    while (n < max)
+    {
+        // 设备数很少 (<= 8), 线性扫描队列头部比维护堆更快:
+        const key_event_t *earliest = NULL;
+        size_t earliest_index = 0;
+        bool all_ready = true;
+        for (size_t i = 0; i < count; i++)
+        {
+            const key_event_t *head = event_queue_peek(queues[i]);
+            if (head == NULL)
+            {
+                all_ready = all_ready && !active[i];
+                continue;
+            }
+            if (earliest == NULL || key_event_before(head, earliest))
+            {
+                earliest = head;
+                earliest_index = i;
+            }
+        }
+        if (earliest == NULL)
+        {
+            break;
+        }
+        // 还有设备可能产生更早的事件, 且最早事件仍在重排窗口内, 等待:
+        if (!all_ready && (int32_t)(now_us - earliest->ts_us) < (int32_t)window_us)
+        {
+            break;
+        }
+        out[n++] = *earliest;
+        event_queue_pop(queues[earliest_index]);
+    }
+    return n;
+}
@@ -0,0 +1,51 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define EVENT_QUEUE_SIZE 64 // 每个设备的事件队列容量, 必须是 2 的幂
+
+#define KEY_EVENT_PRESS 0x01   // 按下, 否则为释放
+#define KEY_EVENT_REPEAT 0x02  // 按住重复产生的按下
+
+// 一次按键事件:
+typedef struct
+{
+    uint32_t ts_us;   // 报告到达时间 (esp_timer, 微秒, 允许回绕)
+    uint32_t seq;     // 设备内序号, 时间戳相同时保持设备内顺序
+    uint8_t dev;      // 设备编号
+    uint8_t key_code; // 键码
+    uint8_t modifier; // 修饰键
+    uint8_t flags;    // KEY_EVENT_*
+    uint8_t bridge;   // 产生事件的桥编号, 级联模式下由上游帧携带
+    uint8_t hops;     // 已经过的级联跳数, 本机事件为 0
+    uint16_t age;     // 到达本机之前累计的延迟, 单位 100 微秒
+} key_event_t;
+
+// 单个设备的事件队列: HID 任务写入, 输出任务读取 (单生产者单消费者):
+typedef struct
+{
+    key_event_t events[EVENT_QUEUE_SIZE];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped; // 队列满丢弃的事件数
+} event_queue_t;
+
+// 追加事件, 队列满时丢弃并返回 false:
+bool event_queue_push(event_queue_t *queue, const key_event_t *event);
+
+// 队列头部事件, 队列为空返回 NULL:
+const key_event_t *event_queue_peek(event_queue_t *queue);
+
+// 移除队列头部事件:
+void event_queue_pop(event_queue_t *queue);
+
+// 多路归并: 在各队列头部中按 (时间戳, 设备内序号) 取最早的事件写入 out, 最多 max 个.
+// 只有当所有 active 队列都有待处理事件, 或最早事件已超过重排窗口 window_us 时才输出,
+// 因此同一窗口内来自不同设备的事件按发生顺序输出, 每个事件最多被延迟 window_us.
+size_t event_merge(event_queue_t *const *queues, const bool *active, size_t count,
+                   uint32_t now_us, uint32_t window_us, key_event_t *out, size_t max);
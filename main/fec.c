@@ -0,0 +1,186 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include "fec.h"
+
+#define FEC_CORRECTED 0x10
+#define FEC_UNCORRECTABLE 0x20
+
+static int fec_depth = 1;
+static uint8_t enc_table[16];
+static uint8_t dec_table[256];      // 码字 -> 半字节 | FEC_CORRECTED / FEC_UNCORRECTABLE
+static uint64_t spread_table[256];  // 码字的第 j 位移到第 j * depth 位
+
+void fec_init(int depth)
+{
+    fec_depth = depth;
+    // 码字位序: d0 d1 d2 d3 p0 p1 p2 p3, p3 为整体奇偶, 任意两个码字至少相差 4 位:
+    for (int n = 0; n < 16; n++)
+    {
+        int d0 = n & 1, d1 = (n >> 1) & 1, d2 = (n >> 2) & 1, d3 = (n >> 3) & 1;
+        int p0 = d0 ^ d1 ^ d3, p1 = d0 ^ d2 ^ d3, p2 = d1 ^ d2 ^ d3;
+        uint8_t cw = (uint8_t)(n | p0 << 4 | p1 << 5 | p2 << 6);
+        cw |= (uint8_t)(__builtin_parity(cw) << 7);
+        enc_table[n] = cw;
+    }
+    memset(dec_table, FEC_UNCORRECTABLE, sizeof(dec_table));
+    for (int n = 0; n < 16; n++)
+    {
+        dec_table[enc_table[n]] = (uint8_t)n;
+        for (int b = 0; b < 8; b++)
+        {
+            dec_table[enc_table[n] ^ (1 << b)] = (uint8_t)(n | FEC_CORRECTED);
+        }
+    }
+    for (int v = 0; v < 256; v++)
+    {
+        uint64_t s = 0;
+        for (int j = 0; j < 8; j++)
+        {
+            s |= (uint64_t)((v >> j) & 1) << (j * depth);
+        }
+        spread_table[v] = s;
+    }
+}
+
+static void fec_encode_block(const uint8_t *data, uint8_t *out)
+{
+    uint8_t cw[FEC_BLOCK_CODED];
+    for (int i = 0; i < FEC_BLOCK_DATA; i++)
+    {
+        cw[2 * i] = enc_table[data[i] & 0x0F];
+        cw[2 * i + 1] = enc_table[data[i] >> 4];
+    }
+    for (int g = 0; g < FEC_BLOCK_CODED; g += fec_depth)
+    {
+        uint64_t bits = 0;
+        for (int c = 0; c < fec_depth; c++)
+        {
+            bits |= spread_table[cw[g + c]] << c;
+        }
+        for (int i = 0; i < fec_depth; i++)
+        {
+            out[g + i] = (uint8_t)(bits >> (8 * i));
+        }
+    }
+}
+
+// 解码一块, 返回纠正的码字数, 有无法纠正的码字时返回 -1:
+static int fec_decode_block(const uint8_t *in, uint8_t *data)
+{
+    uint8_t cw[FEC_BLOCK_CODED] = {0};
+    for (int g = 0; g < FEC_BLOCK_CODED; g += fec_depth)
+    {
+        uint64_t bits = 0;
+        for (int i = 0; i < fec_depth; i++)
+        {
+            bits |= (uint64_t)in[g + i] << (8 * i);
+        }
+        for (int c = 0; c < fec_depth; c++)
+        {
+            for (int j = 0; j < 8; j++)
+            {
+                cw[g + c] |= (uint8_t)(((bits >> (j * fec_depth + c)) & 1) << j);
+            }
+        }
+    }
+    int corrected = 0;
+    for (int i = 0; i < FEC_BLOCK_DATA; i++)
+    {
+        uint8_t lo = dec_table[cw[2 * i]];
+        uint8_t hi = dec_table[cw[2 * i + 1]];
+        if ((lo | hi) & FEC_UNCORRECTABLE)
+        {
+            return -1;
+        }
+        corrected += ((lo & FEC_CORRECTED) != 0) + ((hi & FEC_CORRECTED) != 0);
+        data[i] = (uint8_t)((lo & 0x0F) | (hi & 0x0F) << 4);
+    }
+    return corrected;
+}
+
+size_t fec_encode(const uint8_t *frame, size_t len, uint8_t *out)
+{
+    size_t coded = 0;
+    for (size_t i = 0; i < len; i += FEC_BLOCK_DATA)
+    {
+        uint8_t block[FEC_BLOCK_DATA] = {0};
+        memcpy(block, &frame[i], len - i < FEC_BLOCK_DATA ? len - i : FEC_BLOCK_DATA);
+        fec_encode_block(block, &out[coded]);
+        coded += FEC_BLOCK_CODED;
+    }
+    return coded;
+}
+
+size_t fec_encode_frames(const uint8_t *frames, size_t len, uint8_t *out)
+{
+    size_t pos = 0;
+    size_t coded = 0;
+    while (pos + FRAME_OVERHEAD <= len)
+    {
+        size_t frame_len = frames[pos + 2] + FRAME_OVERHEAD;
+        coded += fec_encode(&frames[pos], frame_len, &out[coded]);
+        pos += frame_len;
+    }
+    return coded;
+}
+
+// 尝试从缓冲区开头解出一帧: 1 成功, 0 数据不足, -1 该位置不是帧开头:
+static int fec_try_frame(fec_decoder_t *dec)
+{
+    uint8_t data[FEC_FRAME_MAX + FEC_BLOCK_DATA];
+    int corrected = fec_decode_block(dec->buf, data);
+    if (corrected < 0 || data[0] != FRAME_SOF || data[2] > FRAME_MAX_PAYLOAD)
+    {
+        return -1;
+    }
+    size_t frame_len = data[2] + FRAME_OVERHEAD;
+    size_t coded_len = FEC_CODED_LEN(frame_len);
+    if (dec->len < coded_len)
+    {
+        return 0;
+    }
+    for (size_t i = FEC_BLOCK_CODED; i < coded_len; i += FEC_BLOCK_CODED)
+    {
+        int n = fec_decode_block(&dec->buf[i], &data[i / 2]);
+        if (n < 0)
+        {
+            return -1;
+        }
+        corrected += n;
+    }
+    if (frame_crc8(0, &data[1], frame_len - 2) != data[frame_len - 1])
+    {
+        return -1;
+    }
+    memcpy(dec->frame, data, frame_len);
+    dec->frame_len = frame_len;
+    dec->frames++;
+    dec->corrected += corrected;
+    dec->len -= coded_len;
+    memmove(dec->buf, &dec->buf[coded_len], dec->len);
+    return 1;
+}
+
+bool fec_decode_byte(fec_decoder_t *dec, uint8_t byte)
+{
+    dec->buf[dec->len++] = byte;
+    while (dec->len >= FEC_BLOCK_CODED)
+    {
+        int r = fec_try_frame(dec);
+        if (r > 0)
+        {
+            return true;
+        }
+        if (r == 0)
+        {
+            break;
+        }
+        // 不是帧开头, 后移一个字节继续寻找:
+        dec->len--;
+        memmove(dec->buf, &dec->buf[1], dec->len);
+        dec->skipped++;
+    }
+    return false;
+}
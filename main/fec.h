@@ -0,0 +1,45 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frame.h"
+
+// 前向纠错: 用于只接 TXD、接收端无法要求重发的链路.
+// 每个二进制帧补零到 4 字节的整数倍, 每 4 字节为一个块. 每个半字节编码为一个扩展
+// Hamming(8,4) 码字 (纠正 1 位, 检出 2 位错误), 一个块得到 8 个码字.
+// 块内每 depth 个码字按位交织 (码字 c 的第 j 位放在第 j * depth + c 位), 一个字节内
+// 的突发错误分散到 depth 个码字, 每个码字最多错 1 位. depth = 1 表示不交织.
+// 接收端不需要同步字节: 在每个字节位置尝试解码, 以 SOF 和帧 CRC 确认帧边界.
+
+#define FEC_BLOCK_DATA 4                      // 每块数据字节
+#define FEC_BLOCK_CODED 8                     // 每块编码后字节
+#define FEC_CODED_LEN(n) (((n) + FEC_BLOCK_DATA - 1) / FEC_BLOCK_DATA * FEC_BLOCK_CODED)
+#define FEC_FRAME_MAX (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+// 生成编码、解码与交织表, depth 取 1, 2, 4 或 8:
+void fec_init(int depth);
+
+// 编码一帧 (frame_encode() 的输出), out 至少 FEC_CODED_LEN(len) 字节, 返回编码后长度:
+size_t fec_encode(const uint8_t *frame, size_t len, uint8_t *out);
+
+// 依次编码连续存放的多帧, 返回编码后总长度:
+size_t fec_encode_frames(const uint8_t *frames, size_t len, uint8_t *out);
+
+// 逐字节解码的状态, 全零即为初始状态:
+typedef struct
+{
+    uint8_t buf[FEC_CODED_LEN(FEC_FRAME_MAX)];
+    size_t len;
+    uint8_t frame[FEC_FRAME_MAX];             // 最近解出的帧
+    size_t frame_len;
+    uint32_t frames;                          // 解出的帧
+    uint32_t corrected;                       // 纠正的码字
+    uint32_t skipped;                         // 寻找帧边界时跳过的字节
+} fec_decoder_t;
+
+// 输入一个字节, 解出完整且 CRC 正确的帧时返回 true, 帧内容在 frame / frame_len:
+bool fec_decode_byte(fec_decoder_t *dec, uint8_t byte);
@@ -0,0 +1,72 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "event_queue.h"
+
+// 二进制帧格式:
+//   [0xA5] [类型] [负载长度] [负载 ...] [CRC-8]
+// CRC-8 (多项式 0x07, 初值 0) 覆盖类型、长度和负载.
+
+#define FRAME_SOF 0xA5
+#define FRAME_OVERHEAD 4       // 帧头 3 字节 + CRC 1 字节
+#define FRAME_MAX_PAYLOAD 64
+
+#define FRAME_TYPE_EVENT 0x01  // 按键事件
+#define FRAME_TYPE_BUS 0x02    // RS-485 寻址帧, 见 rs485.h
+#define FRAME_TYPE_ACK 0x03    // RS-485 接收端应答
+#define FRAME_TYPE_CHAIN_EVENT 0x04 // 级联转发的按键事件, 见 chain.h
+#define FRAME_TYPE_KEYFRAME 0x05    // 键盘状态关键帧, 见 state_stream.h
+#define FRAME_TYPE_QUERY 0x06       // 接收端经 RX 发来的查询, 负载: 查询码
+#define FRAME_TYPE_SNAPSHOT 0x07    // 查询应答: 所有键盘的当前状态
+#define FRAME_TYPE_RELIABLE 0x08    // 带序号的段, 见 reliable.h
+#define FRAME_TYPE_RELIABLE_ACK 0x09 // 接收端经 RX 发来的累计应答
+#define FRAME_TYPE_UPLOAD 0x0A       // 经 RX 上传数据表, 见 table_store.h
+#define FRAME_TYPE_UPLOAD_STATUS 0x0B // 上传进度与结果
+#define FRAME_TYPE_MEMORY 0x0C        // 查询应答: 各子系统的堆内存用量, 见 mem_stats.h
+
+#define QUERY_SNAPSHOT 0x01  // 返回 FRAME_TYPE_SNAPSHOT
+#define QUERY_KEYFRAME 0x02  // 立即发送所有键盘的关键帧 (状态流模式)
+#define QUERY_MEMORY 0x03    // 返回 FRAME_TYPE_MEMORY
+
+#define FRAME_EVENT_PAYLOAD_LEN 6
+#define FRAME_EVENT_LEN (FRAME_OVERHEAD + FRAME_EVENT_PAYLOAD_LEN)
+
+#define FRAME_CHAIN_EVENT_PAYLOAD_LEN 10
+#define FRAME_CHAIN_EVENT_LEN (FRAME_OVERHEAD + FRAME_CHAIN_EVENT_PAYLOAD_LEN)
+
+// 快照负载: 下一个事件的全局序号 (u16 LE), 本帧的键盘数 N (位 7 置位表示后面还有快照帧),
+// 每个键盘: 设备编号, 修饰键, 按键数 K, K 个键码. 一帧放不下时按键盘拆成几帧, 一个键盘不跨帧:
+#define FRAME_SNAPSHOT_HEADER_LEN 3
+#define FRAME_SNAPSHOT_DEV_HEADER_LEN 3
+#define FRAME_SNAPSHOT_MORE 0x80
+
+uint8_t frame_crc8(uint8_t crc, const uint8_t *data, size_t len);
+
+// 编码一帧到 out (至少 len + FRAME_OVERHEAD 字节), 返回帧长度:
+size_t frame_encode(uint8_t type, const uint8_t *payload, size_t len, uint8_t *out);
+
+// 按键事件帧, 负载: 全局序号 (u16 LE), 设备编号, 事件标志, 修饰键, 键码:
+size_t frame_encode_event(const key_event_t *event, uint16_t seq, uint8_t *out);
+
+// 级联事件帧, 负载: 端到端序号 (u16 LE), 来源桥编号, 跳数, 设备编号, 事件标志, 修饰键, 键码,
+// 累计延迟 (u16 LE, 100 微秒):
+size_t frame_encode_chain_event(const key_event_t *event, uint16_t seq, uint8_t *out);
+
+// 逐字节接收帧的状态机, 全零即为初始状态. 长度超限或 CRC 错误时丢弃并重新寻找 SOF:
+typedef struct
+{
+    uint8_t state;
+    uint8_t type;
+    uint8_t len;
+    uint8_t pos;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint32_t crc_errors;
+} frame_parser_t;
+
+// 输入一个字节, 收到完整且校验正确的帧时返回 true, 内容在 type / len / payload 中:
+bool frame_parse_byte(frame_parser_t *p, uint8_t byte);
@@ -0,0 +1,209 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include "hid_report.h"
+
+#define HID_PAGE_KEYBOARD 0x07
+#define HID_KEY_FIRST 0x04     // 0x01 ~ 0x03 为错误码, 不是按键
+#define HID_KEY_MOD_FIRST 0xE0
+
+// 条目类型与标签, HID 1.11 第 6.2.2 节:
+#define ITEM_MAIN 0
+#define ITEM_GLOBAL 1
+#define ITEM_LOCAL 2
+#define TAG_INPUT 0x8
+#define TAG_USAGE_PAGE 0x0
+#define TAG_REPORT_SIZE 0x7
+#define TAG_REPORT_ID 0x8
+#define TAG_REPORT_COUNT 0x9
+#define TAG_USAGE 0x0
+#define TAG_USAGE_MIN 0x1
+#define TAG_USAGE_MAX 0x2
+#define INPUT_CONSTANT 0x01
+#define INPUT_VARIABLE 0x02
+
+const hid_kbd_layout_t hid_boot_layout = {
+    .report_id = 0,
+    .mod_bit = 0,
+    .bitmap_bit = -1,
+    .array_bit = 16,
+    .array_count = 6,
+    .rollover = 6};
+
+bool hid_report_parse_keyboard(const uint8_t *desc, size_t len, hid_kbd_layout_t *layout)
+{
+    *layout = (hid_kbd_layout_t){.mod_bit = -1, .bitmap_bit = -1, .array_bit = -1};
+    uint32_t usage_page = 0, report_size = 0, report_count = 0, report_id = 0;
+    uint32_t usage_min = 0;
+    bool have_usage = false;
+    bool found = false;
+    uint32_t bits = 0; // 当前报告 ID 内已出现的输入位数
+    size_t pos = 0;
+    while (pos < len)
+    {
+        uint8_t prefix = desc[pos++];
+        if (prefix == 0xFE)
+        {
+            // 长条目, 键盘描述符不会用到, 跳过:
+            if (pos + 1 >= len)
+            {
+                break;
+            }
+            pos += 2 + desc[pos];
+            continue;
+        }
+        size_t size = (prefix & 3) == 3 ? 4 : (prefix & 3);
+        if (pos + size > len)
+        {
+            break;
+        }
+        uint32_t value = 0;
+        for (size_t i = 0; i < size; i++)
+        {
+            value |= (uint32_t)desc[pos + i] << (8 * i);
+        }
+        pos += size;
+        uint8_t type = (prefix >> 2) & 3;
+        uint8_t tag = prefix >> 4;
+        if (type == ITEM_GLOBAL)
+        {
+            if (tag == TAG_USAGE_PAGE)
+            {
+                usage_page = value;
+            }
+            else if (tag == TAG_REPORT_SIZE)
+            {
+                report_size = value;
+            }
+            else if (tag == TAG_REPORT_COUNT)
+            {
+                report_count = value;
+            }
+            else if (tag == TAG_REPORT_ID && value != report_id)
+            {
+                // 已经找到键盘报告, 后面是其他报告:
+                if (found)
+                {
+                    break;
+                }
+                report_id = value;
+                bits = 0;
+            }
+        }
+        else if (type == ITEM_LOCAL)
+        {
+            // 第一个用途或用途最小值作为输入项的起始键码:
+            if ((tag == TAG_USAGE || tag == TAG_USAGE_MIN) && !have_usage)
+            {
+                usage_min = value;
+                have_usage = true;
+            }
+        }
+        else if (type == ITEM_MAIN)
+        {
+            if (tag == TAG_INPUT)
+            {
+                bool keyboard = usage_page == HID_PAGE_KEYBOARD && !(value & INPUT_CONSTANT);
+                if (keyboard && (value & INPUT_VARIABLE) && report_size == 1)
+                {
+                    if (usage_min == HID_KEY_MOD_FIRST && report_count == 8)
+                    {
+                        layout->mod_bit = (int16_t)bits;
+                    }
+                    else if (layout->bitmap_bit < 0)
+                    {
+                        layout->bitmap_bit = (int16_t)bits;
+                        layout->bitmap_count = (uint16_t)report_count;
+                        layout->bitmap_first = (uint8_t)usage_min;
+                    }
+                    found = true;
+                }
+                else if (keyboard && !(value & INPUT_VARIABLE) && report_size == 8 && layout->array_bit < 0)
+                {
+                    layout->array_bit = (int16_t)bits;
+                    layout->array_count = (uint8_t)report_count;
+                    found = true;
+                }
+                if (found)
+                {
+                    layout->report_id = (uint8_t)report_id;
+                }
+                bits += report_size * report_count;
+            }
+            // 局部条目只作用于下一个主条目:
+            have_usage = false;
+            usage_min = 0;
+        }
+    }
+    layout->rollover = layout->bitmap_bit >= 0 ? layout->bitmap_count : layout->array_count;
+    return layout->bitmap_bit >= 0 || layout->array_bit >= 0;
+}
+
+size_t hid_report_decode_keyboard(const hid_kbd_layout_t *layout, const uint8_t *report, size_t len,
+                                  uint8_t *out, size_t out_max)
+{
+    if (layout->report_id != 0)
+    {
+        if (len < 1 || report[0] != layout->report_id)
+        {
+            return 0;
+        }
+        report++;
+        len--;
+    }
+    if (out_max < 2)
+    {
+        return 0;
+    }
+    size_t bits = len * 8;
+    uint8_t modifier = 0;
+    if (layout->mod_bit >= 0 && (size_t)layout->mod_bit + 8 <= bits)
+    {
+        size_t b = (size_t)layout->mod_bit;
+        modifier = (b & 7) == 0 ? report[b >> 3]
+                                : (uint8_t)((report[b >> 3] | report[(b >> 3) + 1] << 8) >> (b & 7));
+    }
+    size_t n = 2;
+    if (layout->bitmap_bit >= 0)
+    {
+        size_t end = (size_t)layout->bitmap_bit + layout->bitmap_count;
+        end = end < bits ? end : bits;
+        for (size_t b = (size_t)layout->bitmap_bit; b < end && n < out_max; b++)
+        {
+            // 整字节为 0 时跳过, 通常只有少数键按下:
+            if ((b & 7) == 0 && report[b >> 3] == 0)
+            {
+                b += 7;
+                continue;
+            }
+            if (!(report[b >> 3] & (1 << (b & 7))))
+            {
+                continue;
+            }
+            uint32_t key = layout->bitmap_first + (b - (size_t)layout->bitmap_bit);
+            if (key >= HID_KEY_MOD_FIRST && key < HID_KEY_MOD_FIRST + 8)
+            {
+                modifier |= (uint8_t)(1 << (key - HID_KEY_MOD_FIRST));
+            }
+            else if (key >= HID_KEY_FIRST && key <= 0xFF)
+            {
+                out[n++] = (uint8_t)key;
+            }
+        }
+    }
+    else if (layout->array_bit >= 0 && (layout->array_bit & 7) == 0)
+    {
+        for (size_t i = 0; i < layout->array_count && n < out_max; i++)
+        {
+            size_t byte = ((size_t)layout->array_bit >> 3) + i;
+            if (byte < len && report[byte] >= HID_KEY_FIRST)
+            {
+                out[n++] = report[byte];
+            }
+        }
+    }
+    out[0] = modifier;
+    out[1] = 0;
+    return n;
+}
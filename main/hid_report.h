@@ -0,0 +1,36 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 键盘报告布局: 连接时由报告描述符解析一次, 之后每份报告按布局直接取位,
+// 用于 Boot 协议以外的接口, 如 NKRO 键盘的位图报告.
+// 只识别键盘用途页 (0x07) 的输入项: 8 位修饰键, 1 位一键的位图, 8 位键码数组.
+// 假设同一报告 ID 的输入项在描述符中连续出现, 键盘常见的描述符都满足.
+
+typedef struct
+{
+    uint8_t report_id;     // 键盘报告的 ID, 0 表示报告不带 ID
+    int16_t mod_bit;       // 修饰键 (0xE0 ~ 0xE7) 的起始位, -1 表示没有
+    int16_t bitmap_bit;    // 按键位图的起始位, -1 表示没有
+    uint16_t bitmap_count; // 位图的位数
+    uint8_t bitmap_first;  // 位图第 0 位对应的键码
+    int16_t array_bit;     // 键码数组的起始位, -1 表示没有
+    uint8_t array_count;   // 键码数组的长度
+    uint16_t rollover;     // 一份报告最多能报告的同时按键数, 用于比较接口
+} hid_kbd_layout_t;
+
+// Boot 协议报告的布局, 修饰键, 保留字节, 6 个键码:
+extern const hid_kbd_layout_t hid_boot_layout;
+
+// 解析报告描述符, 找到键盘报告时返回 true:
+bool hid_report_parse_keyboard(const uint8_t *desc, size_t len, hid_kbd_layout_t *layout);
+
+// 将一份报告转换为 Boot 格式 (修饰键, 0, 键码...) 写入 out, 最多 out_max 字节.
+// 返回写入的长度, 不是键盘报告 (报告 ID 不同或长度不足) 时返回 0:
+size_t hid_report_decode_keyboard(const hid_kbd_layout_t *layout, const uint8_t *report, size_t len,
+                                  uint8_t *out, size_t out_max);
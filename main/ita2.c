@@ -0,0 +1,253 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "ita2.h"
+
+// 队列中每个字符存为 [类别 2 位][码 5 位], 类别为字符所在的档, 两档相同的字符不需要换档:
+#define CLASS_ANY 0
+#define CLASS_LTRS 1
+#define CLASS_FIGS 2
+#define SHIFT_UNKNOWN 0 // 打印机档位未知, 与 CLASS_ANY 以外的类别都不相同
+#define SYM(code, cls) ((uint8_t)((code) | (cls) << 5))
+#define SYM_NONE 0xFF
+#define QUEUE_MASK (ITA2_QUEUE_SIZE - 1)
+
+_Static_assert((ITA2_QUEUE_SIZE & QUEUE_MASK) == 0, "ITA2_QUEUE_SIZE must be a power of 2");
+
+// 码位 -> 字符, 0 为换档字符或没有定义 (ITA2 的 WRU、响铃与留给各国的码位):
+static const char ltrs_table[32] = {0, 'E', '\n', 'A', ' ', 'S', 'I', 'U', '\r', 'D', 'R', 'J', 'N', 'F', 'C', 'K',
+                                    'T', 'Z', 'L', 'W', 'H', 'Y', 'P', 'Q', 'O', 'B', 'G', 0, 'M', 'X', 'V', 0};
+static const char figs_ita2[32] = {0, '3', '\n', '-', ' ', '\'', '8', '7', '\r', 0, '4', 0, ',', 0, ':', '(',
+                                   '5', '+', ')', '2', 0, '6', '0', '1', '9', '?', 0, 0, '.', '/', '=', 0};
+static const char figs_us_tty[32] = {0, '3', '\n', '-', ' ', 0, '8', '7', '\r', '$', '4', '\'', ',', '!', ':', '(',
+                                     '5', '"', ')', '2', '#', '6', '0', '1', '9', '?', '&', 0, '.', '/', ';', 0};
+
+typedef struct
+{
+    uint8_t sym[ITA2_QUEUE_SIZE];
+    uint32_t ts_us[ITA2_QUEUE_SIZE]; // 进入队列的时间
+    uint32_t head;
+    uint32_t tail;
+    uint16_t overtaken;              // 队首字符被其他设备的字符越过的次数
+} ita2_queue_t;
+
+static ita2_config_t config;
+static const char *figs_table = figs_ita2;
+static uint8_t ascii_table[128];     // ASCII -> SYM, 没有对应码时为 SYM_NONE
+static ita2_queue_t queues[ITA2_DEVICES];
+static uint32_t char_us = 165000;    // 每个字符在线路上的时间
+static uint16_t overtake_max = 0;    // reorder_us 换算为字符数
+static uint8_t shift = SHIFT_UNKNOWN;
+static uint8_t fifo_shift = SHIFT_UNKNOWN; // 按到达顺序发送时的档位, 只用于统计
+static uint32_t busy_until = 0;      // 已交给 UART 的字符全部发完的时间
+static bool idle = true;             // 线路在 busy_until 之后没有字符
+static size_t pending = 0;
+static ita2_stats_t stats;
+
+void ita2_init(const ita2_config_t *cfg)
+{
+    config = *cfg;
+    figs_table = config.us_tty ? figs_us_tty : figs_ita2;
+    char_us = (uint32_t)(ITA2_BITS_X10 * 100000ULL / config.baud);
+    overtake_max = (uint16_t)(config.reorder_us / char_us);
+    memset(ascii_table, SYM_NONE, sizeof(ascii_table));
+    for (uint8_t code = 0; code < 32; code++)
+    {
+        char l = ltrs_table[code];
+        char f = figs_table[code];
+        if (l != 0 && l == f)
+        {
+            ascii_table[(uint8_t)l] = SYM(code, CLASS_ANY);
+            continue;
+        }
+        if (l != 0)
+        {
+            ascii_table[(uint8_t)l] = SYM(code, CLASS_LTRS);
+            ascii_table[(uint8_t)(l - 'A' + 'a')] = SYM(code, CLASS_LTRS);
+        }
+        if (f != 0)
+        {
+            ascii_table[(uint8_t)f] = SYM(code, CLASS_FIGS);
+        }
+    }
+    ascii_table['\t'] = ascii_table[' '];
+    memset(queues, 0, sizeof(queues));
+    shift = fifo_shift = SHIFT_UNKNOWN;
+    idle = true;
+    pending = 0;
+    memset(&stats, 0, sizeof(stats));
+    ESP_LOGI("ITA2", "%u baud, %" PRIu32 " ms per char, %s figures, USOS %s, reorder up to %u chars",
+             config.baud, char_us / 1000, config.us_tty ? "US TTY" : "ITA2", config.usos ? "on" : "off", overtake_max);
+}
+
+static void enqueue(ita2_queue_t *q, uint8_t sym, uint32_t now_us)
+{
+    if (q->tail - q->head >= ITA2_QUEUE_SIZE)
+    {
+        stats.dropped++;
+        return;
+    }
+    q->sym[q->tail & QUEUE_MASK] = sym;
+    q->ts_us[q->tail & QUEUE_MASK] = now_us;
+    q->tail++;
+    pending++;
+    stats.backlog_max = pending > stats.backlog_max ? (uint16_t)pending : stats.backlog_max;
+    // 对比用: 按到达顺序逐个发送需要的换档:
+    uint8_t cls = sym >> 5;
+    if (cls != CLASS_ANY && cls != fifo_shift)
+    {
+        fifo_shift = cls;
+        stats.shifts_fifo++;
+    }
+    if (config.usos && sym == ascii_table[' '])
+    {
+        fifo_shift = CLASS_LTRS;
+    }
+}
+
+void ita2_push(uint8_t dev, const char *text, size_t len, uint32_t now_us)
+{
+    ita2_queue_t *q = &queues[dev < ITA2_DEVICES ? dev : ITA2_DEVICES - 1];
+    for (size_t i = 0; i < len; i++)
+    {
+        uint8_t c = (uint8_t)text[i];
+        if (c == '\n')
+        {
+            // 回车键: 打印头回到行首并走纸:
+            enqueue(q, ascii_table['\r'], now_us);
+            enqueue(q, ascii_table['\n'], now_us);
+            continue;
+        }
+        if (c >= sizeof(ascii_table) || ascii_table[c] == SYM_NONE)
+        {
+            stats.unmapped++;
+            continue;
+        }
+        enqueue(q, ascii_table[c], now_us);
+    }
+}
+
+// 选择下一个发送的设备: 优先与当前档相同或不需要换档的队首, 其中最早的一个;
+// 都需要换档, 或者最早的队首已被越过 overtake_max 次时, 发送最早的队首. 所有队列为空时返回 -1:
+static int pick(int *oldest_out)
+{
+    int oldest = -1;
+    int match = -1;
+    for (int d = 0; d < ITA2_DEVICES; d++)
+    {
+        const ita2_queue_t *q = &queues[d];
+        if (q->head == q->tail)
+        {
+            continue;
+        }
+        uint32_t ts = q->ts_us[q->head & QUEUE_MASK];
+        if (oldest < 0 || (int32_t)(ts - queues[oldest].ts_us[queues[oldest].head & QUEUE_MASK]) < 0)
+        {
+            oldest = d;
+        }
+        uint8_t cls = q->sym[q->head & QUEUE_MASK] >> 5;
+        if ((cls == CLASS_ANY || cls == shift) &&
+            (match < 0 || (int32_t)(ts - queues[match].ts_us[queues[match].head & QUEUE_MASK]) < 0))
+        {
+            match = d;
+        }
+    }
+    *oldest_out = oldest;
+    if (match < 0 || queues[oldest].overtaken >= overtake_max)
+    {
+        return oldest;
+    }
+    return match;
+}
+
+size_t ita2_drain(uint32_t now_us, uint8_t *out, size_t max)
+{
+    if (!idle && (int32_t)(now_us - busy_until) >= 0)
+    {
+        idle = true;
+    }
+    if (idle && shift != SHIFT_UNKNOWN && now_us - busy_until >= config.resync_us)
+    {
+        // 长时间空闲, 打印机可能被线路噪声或本地按键切换过档位:
+        shift = SHIFT_UNKNOWN;
+    }
+    size_t n = 0;
+    // 线路在下一个周期结束前会空闲时才交给 UART 下一个字符, UART 中最多两个字符:
+    while (n < max && (idle || busy_until - now_us < config.tick_us))
+    {
+        int oldest;
+        int dev = pick(&oldest);
+        if (dev < 0)
+        {
+            break;
+        }
+        if (idle)
+        {
+            busy_until = now_us;
+            idle = false;
+        }
+        ita2_queue_t *q = &queues[dev];
+        uint8_t sym = q->sym[q->head & QUEUE_MASK];
+        uint8_t cls = sym >> 5;
+        busy_until += char_us;
+        if (cls != CLASS_ANY && cls != shift)
+        {
+            out[n++] = cls == CLASS_LTRS ? ITA2_LTRS : ITA2_FIGS;
+            shift = cls;
+            stats.shifts++;
+            continue;
+        }
+        out[n++] = sym & 0x1F;
+        if (config.usos && sym == ascii_table[' '])
+        {
+            shift = CLASS_LTRS;
+        }
+        if (dev != oldest)
+        {
+            queues[oldest].overtaken++;
+            stats.reordered++;
+        }
+        uint32_t latency = busy_until - q->ts_us[q->head & QUEUE_MASK];
+        stats.latency_sum_us += latency;
+        stats.latency_max_us = latency > stats.latency_max_us ? latency : stats.latency_max_us;
+        stats.chars++;
+        q->head++;
+        q->overtaken = 0;
+        pending--;
+    }
+    return n;
+}
+
+size_t ita2_backlog(void)
+{
+    return pending;
+}
+
+uint32_t ita2_behind_us(uint32_t now_us)
+{
+    uint32_t busy = idle || (int32_t)(busy_until - now_us) <= 0 ? 0 : busy_until - now_us;
+    return busy + (uint32_t)pending * char_us;
+}
+
+char ita2_char(uint8_t code, bool figs)
+{
+    return code < 32 ? (figs ? figs_table : ltrs_table)[code] : 0;
+}
+
+const ita2_stats_t *ita2_get_stats(void)
+{
+    return &stats;
+}
+
+void ita2_log_stats(uint32_t now_us)
+{
+    ESP_LOGI("ITA2", "chars=%" PRIu32 " shifts=%" PRIu32 " (arrival order: %" PRIu32 ") reordered=%" PRIu32
+                     " unmapped=%" PRIu32 " dropped=%" PRIu32,
+             stats.chars, stats.shifts, stats.shifts_fifo, stats.reordered, stats.unmapped, stats.dropped);
+    ESP_LOGI("ITA2", "queue latency: avg=%" PRIu32 " ms max=%" PRIu32 " ms, printer behind %" PRIu32 " ms (%u chars queued, max %u)",
+             stats.chars ? (uint32_t)(stats.latency_sum_us / stats.chars / 1000) : 0, stats.latency_max_us / 1000,
+             ita2_behind_us(now_us) / 1000, (unsigned)pending, stats.backlog_max);
+}
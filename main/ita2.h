@@ -0,0 +1,71 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Baudot (ITA2) 电传打字机输出: ASCII 字符转换为 5 位码, 字母与数字/符号共用码位,
+// 由换档字符 LTRS / FIGS 切换. 空格、回车、换行、空白在两档中相同, 不需要换档.
+// 45.45 ~ 75 波特时每个字符需要 100 ~ 165 ms, 因此:
+//   - 跟踪打印机的当前档位, 只在下一个字符不在当前档时插入换档字符;
+//   - 每个键盘的字符各自排队, 发送时向前查看各队列的队首, 优先发送与当前档相同的字符,
+//     多个键盘同时输入时同档字符连续发出, 换档次数最少. 同一键盘的字符顺序不变,
+//     等待超过 reorder_us 的字符不再被越过;
+//   - 按线路速度计时, 每次只交给 UART 即将发完的字符, 积压留在队列中, 可以统计打印机落后多少.
+// 小写字母转为大写, 回车键 ('\n') 输出回车加换行, 制表符输出空格, 其他没有对应码的字符被丢弃.
+// 线路空闲 resync_us 后认为档位未知, 下一个字符前重发换档字符, 防止噪声使打印机档位错乱.
+
+#define ITA2_LTRS 0x1F       // 切换到字母档
+#define ITA2_FIGS 0x1B       // 切换到数字/符号档
+#define ITA2_DEVICES 8       // 独立排队的设备数, 设备编号超出时与最后一个共用队列
+#define ITA2_QUEUE_SIZE 128  // 每个设备排队的字符数, 必须是 2 的幂
+#define ITA2_BITS_X10 75     // 每字符位数 x10: 起始位 + 5 个数据位 + 1.5 个停止位
+
+typedef struct
+{
+    uint16_t baud;       // 线路波特率
+    bool us_tty;         // true: 数字档使用美国 TTY 字符集 ($ # & ! " ; 等), false: ITA2 国际标准
+    bool usos;           // true: 打印机收到空格后自动回到字母档 (Unshift On Space)
+    uint32_t reorder_us; // 为减少换档, 一个字符最多被其他键盘的字符越过这么久
+    uint32_t resync_us;  // 线路空闲这么久后档位视为未知
+    uint32_t tick_us;    // ita2_drain() 的调用间隔
+} ita2_config_t;
+
+typedef struct
+{
+    uint32_t chars;          // 发出的字符, 不含换档字符
+    uint32_t shifts;         // 插入的换档字符
+    uint32_t shifts_fifo;    // 按到达顺序逐个发送时需要的换档字符, 用于对比
+    uint32_t reordered;      // 越过其他键盘更早的字符发出的字符
+    uint32_t unmapped;       // 没有对应 Baudot 码而丢弃的字符
+    uint32_t dropped;        // 队列满丢弃的字符
+    uint32_t latency_max_us; // 字符进入队列到在线路上发完
+    uint64_t latency_sum_us;
+    uint16_t backlog_max;    // 所有队列中同时等待的最大字符数
+} ita2_stats_t;
+
+// 建立转换表, 清空队列与统计:
+void ita2_init(const ita2_config_t *config);
+
+// 把设备 dev 的 len 个 ASCII 字符转换后排队, now_us 为进入队列的时间:
+void ita2_push(uint8_t dev, const char *text, size_t len, uint32_t now_us);
+
+// 发送任务每个周期调用: 把线路在下一个周期结束前能开始发送的字符 (含换档字符) 写入 out,
+// 最多 max 个, 返回个数:
+size_t ita2_drain(uint32_t now_us, uint8_t *out, size_t max);
+
+// 排队的字符数 (不含换档字符):
+size_t ita2_backlog(void);
+
+// 打印机落后的时间: 已交给 UART 尚未发完的时间加上排队字符的发送时间:
+uint32_t ita2_behind_us(uint32_t now_us);
+
+// 5 位码在给定档位下对应的 ASCII 字符, 换档字符与没有定义的码位返回 0:
+char ita2_char(uint8_t code, bool figs);
+
+const ita2_stats_t *ita2_get_stats(void);
+
+void ita2_log_stats(uint32_t now_us);
@@ -2,6 +2,8 @@
  * SPDX-License-Identifier: GPLv3
  */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <inttypes.h>
 #include "sdkconfig.h"
 #include "freertos/FreeRTOS.h"
@@ -10,129 +12,1032 @@
 #include "esp_flash.h"
 #include "esp_system.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
 #include "driver/uart.h"
 #include "usb/hid_host.h"
+#include "usb/hid_host_batch.h"
 #include "usb/hid_usage_keyboard.h"
+#include "keymap.h"
+#include "midi_out.h"
+#include "event_queue.h"
+#include "frame.h"
+#include "tx_queue.h"
+#include "uart_tx.h"
+#include "rs485.h"
+#include "chain.h"
+#include "fec.h"
+#include "state_stream.h"
+#include "cmd.h"
+#include "seqlock.h"
+#include "hid_report.h"
+#include "encoder.h"
+#include "matrix.h"
+#include "rate_limit.h"
+#include "reliable.h"
+#include "table_store.h"
+#include "ita2.h"
+#include "mem_stats.h"
+#include "pipeline.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <time.h>
+#include "sim_uhid.h"
+#include "sim_bench.h"
+#include "sim_rs485.h"
+#endif
+
+// 输出模式 (OUTPUT_MODE) 与各 *_ENABLE 阶段开关在 menuconfig 中选择, 见 pipeline.h,
+// 下面是各阶段的参数.
 
 // --- UART 配置 ---
 #define TXD_PIN 17            // 发送管脚
 #define RXD_PIN 18            // 接收管脚
+#if OUTPUT_MODE == OUTPUT_MODE_MIDI
+#define UART_BUAD_RATE 31250 // MIDI 标准波特率
+#elif OUTPUT_MODE == OUTPUT_MODE_BAUDOT
+#define UART_BUAD_RATE BAUDOT_BAUD
+#else
 #define UART_BUAD_RATE 115200 // 波特率
+#endif
 #define UART_PORT UART_NUM_1  // 使用的 UART 端口
 
+// --- RS-485 配置 ---
+// RS485_ENABLE: 半双工多点总线, 输出帧带目的地址, 见 rs485.h; RS485_ACK_ENABLE: 单播帧等待接收端应答, 超时重发
+#define RS485_DE_PIN 16       // 收发器驱动器使能 (DE/RE), 由 UART 的 RTS 自动控制
+#define RS485_ROUTE {0x01, 0x02, 0x03, 0x04, 0x05} // 每个键盘槽位的目的地址, 最后一项为按键矩阵, RS485_ADDR_BROADCAST 为广播
+#if RS485_ENABLE && (OUTPUT_MODE == OUTPUT_MODE_MIDI || OUTPUT_MODE == OUTPUT_MODE_BAUDOT)
+#error "RS-485 mode supports ASCII and binary output only"
+#endif
+
+// --- 级联配置 ---
+// CHAIN_ENABLE: 从 RX 接收上游桥的事件帧, 与本机事件归并后从 TX 转发, 见 chain.h
+#define BRIDGE_ID 0           // 本机桥编号, 0 ~ CHAIN_MAX_BRIDGES - 1
+#if CHAIN_ENABLE && (OUTPUT_MODE != OUTPUT_MODE_BINARY || RS485_ENABLE)
+#error "Chain mode requires binary output on a point-to-point UART"
+#endif
+
+// --- 前向纠错配置 ---
+// FEC_ENABLE: 二进制帧经 Hamming(8,4) 编码后发送, 见 fec.h
+#define FEC_INTERLEAVE 8      // 交织深度: 1 (不交织), 2, 4, 8
+#if FEC_ENABLE && (OUTPUT_MODE != OUTPUT_MODE_BINARY || RS485_ENABLE || CHAIN_ENABLE)
+#error "FEC mode requires binary output on a TX-only link"
+#endif
+
+// --- 状态流配置 ---
+// STATE_STREAM_ENABLE: 增量事件之外周期性发送键盘状态关键帧, 见 state_stream.h
+#define STATE_KEYFRAME_INTERVAL_MS 1000 // 每个键盘的关键帧间隔
+#define STATE_KEYFRAME_MAX_PERCENT 5    // 关键帧占链路带宽的上限, 必要时延长间隔
+#if STATE_STREAM_ENABLE && (OUTPUT_MODE != OUTPUT_MODE_BINARY || RS485_ENABLE || CHAIN_ENABLE)
+#error "State stream mode requires binary output on a point-to-point UART"
+#endif
+
+// --- 命令通道配置 ---
+// CMD_ENABLE: 在 RX 上接收查询帧, 见 cmd.h
+// 编码表模式的接收端协议自定义, 应答帧与事件混在一起, 由接收端按帧格式区分:
+#if CMD_ENABLE && ((OUTPUT_MODE != OUTPUT_MODE_BINARY && OUTPUT_MODE != OUTPUT_MODE_TABLE) || RS485_ENABLE || CHAIN_ENABLE)
+#error "Command channel requires binary or table output with a free RX pin"
+#endif
+
+// --- 可靠传输配置 ---
+// RELIABLE_ENABLE: 二进制帧按段编号发送, 接收端经 RX 累计应答, 超时或重复应答时 go-back-N 重发, 见 reliable.h
+#define RELIABLE_WINDOW 8         // 同时等待应答的段数, 1 ~ RELIABLE_WINDOW_MAX
+#define RELIABLE_TIMEOUT_MS 40    // 等待应答的时间, 超时后从最早未应答的段起全部重发
+#define RELIABLE_RETRIES 5        // 连续超时这么多次后认为链路断开, 之后每次超时只重发最早的段
+#if RELIABLE_ENABLE && (!CMD_ENABLE || OUTPUT_MODE != OUTPUT_MODE_BINARY)
+#error "Reliable mode packs binary frames and receives ACKs on the command channel, enable CMD_ENABLE"
+#endif
+
+// --- 数据表上传配置 ---
+// TABLE_UPLOAD_ENABLE: 经 RX 把数据表流式写入 A/B 数据分区, 校验后切换, 不需要重启, 见 table_store.h
+#if TABLE_UPLOAD_ENABLE && !CMD_ENABLE
+#error "Table upload receives data on the command channel, enable CMD_ENABLE"
+#endif
+
+// --- 编码表配置 ---
+#define ENCODER_NVS_NAMESPACE "encoder" // 定义保存在 NVS 的命名空间与键名 (blob)
+#define ENCODER_NVS_KEY "def"
+#define ENCODER_DEF_MAX 4096            // 定义文本的最大长度
+#define ENCODER_DEFAULT "press * {ascii}\nrepeat * {ascii}\n" // 数据表与 NVS 中都没有定义或定义有误时使用, 与 ASCII 模式相同
+#if OUTPUT_MODE == OUTPUT_MODE_TABLE && RS485_ENABLE
+#error "Table output requires a point-to-point UART"
+#endif
+
+// --- 电传打字机配置 ---
+#define BAUDOT_BAUD 45            // 线路波特率: 45 (45.45 取整, 误差 1%), 50, 57, 75
+#define BAUDOT_US_TTY 1           // 1: 数字档使用美国 TTY 字符集, 0: ITA2 国际标准
+#define BAUDOT_USOS 0             // 1: 打印机收到空格后自动回到字母档 (Unshift On Space)
+#define BAUDOT_REORDER_MS 2000    // 多个键盘同时输入时, 为减少换档一个字符最多被越过的时间
+#define BAUDOT_RESYNC_MS 5000     // 线路空闲这么久后, 下一个字符前重发换档字符
+
+// --- 键盘接口配置 ---
+// NKRO_ENABLE: 同时打开 NKRO (位图报告) 接口, 同一设备的兄弟接口只由一个输出
+#define DEDUP_FAILOVER_REPORTS 2  // 输出接口沉默时, 备用接口连续收到多少份报告后接管输出
+// HID_BATCH_ENABLE: HID 驱动每轮事件处理批量投递报告, 不逐份回调, 见 hid_host_batch.h
+#define HID_BATCH_THRESHOLD 8     // 积累到这么多份报告时不等本轮结束立即投递
+// RATE_LIMIT_ENABLE: 每个接口限制带按下的报告频率, 持续超限的接口被停止, 见 rate_limit.h
+#define RATE_LIMIT_PER_SEC 60     // 每秒允许的带按下的报告数, 约为最快打字速度的两倍
+#define RATE_LIMIT_BURST 20       // 允许的突发报告数
+#define RATE_FLOOD_GAP_MS 4       // 平均报告间隔低于此值视为失控或注入, 超限不再被之后的正常报告抵消
+#define RATE_QUARANTINE_STRIKES 50 // 未抵消的超限报告达到此数时隔离接口
+
+// --- 按键矩阵配置 ---
+// MATRIX_ENABLE: 扫描 GPIO 按键矩阵, 作为最后一个键盘槽位输出, 见 matrix.h
+#define MATRIX_ROW_PINS {4, 5, 6, 7}      // 行线, 推挽输出
+#define MATRIX_COL_PINS {8, 9, 10, 11}    // 列线, 上拉输入
+#define MATRIX_KEYMAP {0x1E, 0x1F, 0x20, 0x04, /* 1 2 3 A */ \
+                       0x21, 0x22, 0x23, 0x05, /* 4 5 6 B */ \
+                       0x24, 0x25, 0x26, 0x06, /* 7 8 9 C */ \
+                       0x2A, 0x27, 0x28, 0x07} /* 退格 0 回车 D */
+#define MATRIX_SCAN_HZ 1000       // 整个矩阵的扫描频率
+#define MATRIX_DEBOUNCE_MS 5      // 去抖时间, 按下与释放都延迟这么久
+#if MATRIX_ENABLE && OUTPUT_MODE == OUTPUT_MODE_MIDI
+#error "Key matrix does not support MIDI output"
+#endif
+
+// --- 内存统计配置 ---
+// MEM_STATS_ENABLE: 统计日志中输出 USB / HID / 应用各自的堆用量与最大空闲块趋势, 命令通道可查询, 见 mem_stats.h
+
 // --- Key 配置 ---
 #define KEYPRESS_INTERVAL_MS 250                                  // 触发间隔，单位毫秒
 #define TIMER_INTERVAL_MS 10                                      // 定时器周期，单位毫秒
 #define TICK_COUNT_MAX (KEYPRESS_INTERVAL_MS / TIMER_INTERVAL_MS) // 计算最大计数值
 
+// --- 发送配置 ---
+#define MAX_KEYBOARDS 4      // 同时打开的键盘接口数
+#define KEYBOARD_SLOTS (MAX_KEYBOARDS + MATRIX_ENABLE) // 键盘槽位数, 按键矩阵占用最后一个
+#define KEYBOARD_MAX_KEYS (NKRO_ENABLE ? 16 : 6) // 每个接口跟踪的同时按键数
+#define TX_BATCH_SIZE 64     // 每次归并发送的最大事件数
+// 每个周期 UART 能发出的字节数, 电传打字机不到一个, 按字符时间由 ita2_drain() 控制:
+#define TX_BYTES_PER_TICK (OUTPUT_MODE == OUTPUT_MODE_BAUDOT ? 1 : UART_BUAD_RATE / 10 * TIMER_INTERVAL_MS / 1000)
+#define TX_STATS_INTERVAL_MS 10000 // 输出队列统计的日志间隔
+// UART 驱动缓冲区: 接收只用于 RS-485 应答与级联, 取驱动允许的最小值 (须大于 128 字节硬件 FIFO),
+// 级联时容纳约 40 ms 的上游数据;
+// 发送环形缓冲区只需容纳两个周期的数据, 积压留在优先级队列中, 控制字符才能越过:
+#define UART_RX_BUFFER_SIZE (CHAIN_ENABLE ? 512 : 256)
+#define UART_TX_BUFFER_SIZE (2 * TX_BYTES_PER_TICK + 128)
+
 static uint32_t tick_counter = 0;        // 计时器滴答计数器
 static volatile uint8_t current_key = 0; // 当前按住的键码
 static volatile uint8_t current_mod = 0; // 当前按住的修饰键
+static volatile uint8_t current_dev = 0; // 当前按键所属的键盘槽位
 
-// 将 USB HID 键码转换为 ASCII 字符:
-char usb_keycode_to_ascii(uint8_t key_code, uint8_t modifier)
+// 每个已打开键盘接口的状态:
+typedef struct keyboard
 {
-    // 映射表 (索引 0 对应 Keycode 0x04)
-    // 注意：\\ 是反斜杠，\" 是双引号
-    // 位置：A-Z, 1-0, Enter, Esc, Backspace, Tab, Space, - = [ ] \ (non) ; ' ` , . /
-    const static char *lut_shift = "ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%^&*()\n\x1B\b\t _+{}| :\"~<>?";
-    const static char *lut_plain = "abcdefghijklmnopqrstuvwxyz1234567890\n\x1B\b\t -=[]\\ ;'`,./";
+    hid_host_device_handle_t handle; // NULL 表示空闲
+    uint8_t prev_keys[KEYBOARD_MAX_KEYS]; // 上一份报告中的键码
+    uint8_t prev_mod;                // 上一份报告中的修饰键
+    uint32_t seq;                    // 设备内事件序号
+    event_queue_t queue;             // 等待归并输出的事件, HID 任务写入, 发送任务读取
+    hid_kbd_layout_t layout;         // 报告布局, Boot 接口为 hid_boot_layout
+    uint8_t addr;                    // USB 设备地址, 同一地址的键盘接口互为兄弟
+    struct keyboard *sibling;        // 同一设备上另一个键盘接口, 没有时为 NULL
+    volatile bool muted;             // 兄弟接口负责输出, 本接口的报告只用于判断是否需要接管
+    uint8_t silent_reports;          // 静默期间兄弟接口没有跟随报告的连续次数
+    uint32_t last_report_us;         // 最近一份输入报告的时间
+    rate_limit_t limit;              // 带按下的报告的限速状态
+    volatile bool quarantined;       // 持续超限被停止, 保留槽位直到拔出
+    bool stop_pending;               // 已隔离, 等待 HID 任务在事件处理之后停止 IN 传输
+    hid_host_device_handle_t stop_handle; // 隔离时的句柄与分配代数, 停止前核对, 槽位已换设备时不停止
+    uint32_t stop_generation;
+    uint32_t generation;             // 每次分配槽位加一
+} keyboard_t;
+
+static keyboard_t keyboards[KEYBOARD_SLOTS];
+// 保护所有键盘的 handle / prev_keys / prev_mod: HID 任务与矩阵报告任务写入, 查询快照时
+// 发送任务读取, HID 回调不会因查询而等待:
+static seqlock_t keyboards_lock;
+// 序列锁只允许一个写者, 启用按键矩阵时两个写者之间用自旋锁互斥, 临界区只有几次内存写入:
+static portMUX_TYPE keyboards_mux = portMUX_INITIALIZER_UNLOCKED;
+static matrix_t matrix;
+static volatile bool snapshot_requested = false;
+static volatile bool memory_requested = false;
+static uint32_t snapshot_retries = 0;   // 快照读取因并发写入而重试的次数
+static uint32_t dedup_suppressed = 0;   // 静默接口丢弃的报告
+static uint32_t dedup_failovers = 0;    // 备用接口接管输出的次数
+static uint32_t rate_dropped = 0;       // 超过限速丢弃的报告
+static uint32_t rate_quarantined = 0;   // 被隔离的接口数
+static const rate_limit_config_t rate_limit_config = {
+    .rate = RATE_LIMIT_PER_SEC,
+    .burst = RATE_LIMIT_BURST,
+    .strikes_max = RATE_QUARANTINE_STRIKES,
+    .flood_gap = RATE_FLOOD_GAP_MS * 10};
+static TaskHandle_t send_task = NULL;
+static const uint8_t rs485_route[MAX_KEYBOARDS + 1] = RS485_ROUTE;
+static uint16_t event_seq = 0; // 全局事件序号, 按归并后的输出顺序分配
+static encoder_t encoder;      // 编码表模式的分发表
+static encoder_t encoder_next; // 上传的新表编译后在这里等待发送任务切换
+static bool encoder_swap = false; // 释放写入发布 encoder_next, 获取读取后才能使用它
 
-    // 基础偏移量：HID 键码是从 0x04 (字母A) 开始的
-    if (key_code < 0x04 || key_code > 0x38)
+static char tx_batch[TX_BATCH_SIZE];     // 批量转换缓冲区
+static uint8_t tx_out[TX_BYTES_PER_TICK]; // 每个周期从输出队列取出的数据
+#define STATE_OUT_SIZE (STATE_STREAM_ENABLE ? FRAME_KEYFRAME_LEN * KEYBOARD_SLOTS : 1)
+static uint8_t state_out[STATE_OUT_SIZE]; // 每个周期到期的关键帧
+// 查询应答: 每个键盘带全部 KEYBOARD_MAX_KEYS 个按键, 最坏情况每个键盘一帧:
+#define SNAPSHOT_DEV_MAX (FRAME_SNAPSHOT_DEV_HEADER_LEN + KEYBOARD_MAX_KEYS)
+#define SNAPSHOT_OUT_SIZE (KEYBOARD_SLOTS * (FRAME_OVERHEAD + FRAME_SNAPSHOT_HEADER_LEN + SNAPSHOT_DEV_MAX))
+#define SNAPSHOT_CODED_MAX (KEYBOARD_SLOTS * FEC_CODED_LEN(FRAME_OVERHEAD + FRAME_MAX_PAYLOAD))
+_Static_assert(FRAME_SNAPSHOT_HEADER_LEN + SNAPSHOT_DEV_MAX <= FRAME_MAX_PAYLOAD, "snapshot record exceeds a frame");
+_Static_assert(KEYBOARD_SLOTS <= MIDI_MAX_DEVICES, "MIDI note state per keyboard slot");
+static uint8_t snapshot_out[SNAPSHOT_OUT_SIZE];
+#define RELIABLE_OUT_SIZE (RELIABLE_ENABLE ? RELIABLE_WINDOW * RELIABLE_SEGMENT_WIRE_MAX : 1)
+static uint8_t reliable_out[RELIABLE_OUT_SIZE]; // 重发与新段, 最多一个窗口
+// FEC 编码后的数据: 每帧最多补齐 3 字节, 编码后长度翻倍:
+#define MAX2(a, b) ((a) > (b) ? (a) : (b))
+#define FEC_IN_MAX MAX2(MAX2(TX_BYTES_PER_TICK, RELIABLE_OUT_SIZE), MAX2(STATE_OUT_SIZE, SNAPSHOT_OUT_SIZE))
+static uint8_t fec_out[FEC_ENABLE ? 2 * (FEC_IN_MAX + 3 * (FEC_IN_MAX / FRAME_OVERHEAD)) : 1];
+
+static uint32_t midi_latency_max_us = 0; // 报告回调到 MIDI 字节写入 UART 的最大耗时
+
+// 记录按键并通过 UART 发送:
+static void uart_send(const char *buf, size_t len)
+{
+    if (len == 1)
     {
-        return 0;
+        char ascii_char = buf[0];
+        if (ascii_char >= 32 && ascii_char <= 126)
+        {
+            ESP_LOGI("UART", "Send: 0x%02X: [%c]", (uint8_t)ascii_char, ascii_char);
+        }
+        else
+        {
+            ESP_LOGI("UART", "Send: 0x%02X", (uint8_t)ascii_char);
+        }
     }
+    else
+    {
+        ESP_LOGI("UART", "Send: %d bytes", (int)len);
+    }
+    // 通过UART发送 (写入 TX 环形缓冲区, 不等待发送完成):
+    size_t accepted = uart_tx_write(buf, len);
+    if (accepted < len)
+    {
+        ESP_LOGW("UART", "TX buffer full, drop %d bytes", (int)(len - accepted));
+    }
+}
 
-    bool shift = (modifier & 0x02) || (modifier & 0x20);
-    bool ctrl = (modifier & 0x01) || (modifier & 0x10);
+// 发送已编码的帧, FEC 模式下先编码:
+static void send_frames(const uint8_t *frames, size_t len)
+{
+    if (FEC_ENABLE)
+    {
+        uart_send((const char *)fec_out, fec_encode_frames(frames, len, fec_out));
+    }
+    else
+    {
+        uart_send((const char *)frames, len);
+    }
+}
 
-    // 索引计算:
-    uint8_t idx = key_code - 0x04;
+// 读取所有已连接键盘的当前状态, 编码为快照帧写入 out, 返回总长度:
+static size_t encode_snapshot(uint8_t *out)
+{
+    uint8_t records[KEYBOARD_SLOTS][SNAPSHOT_DEV_MAX];
+    size_t record_len[KEYBOARD_SLOTS];
+    size_t count;
+    uint32_t seq;
+    while (1)
+    {
+        seq = seqlock_read_begin(&keyboards_lock);
+        count = 0;
+        for (int i = 0; i < KEYBOARD_SLOTS; i++)
+        {
+            if (keyboards[i].handle != NULL && !keyboards[i].muted && !keyboards[i].quarantined)
+            {
+                // 只带按下的键码, NKRO 接口最多 KEYBOARD_MAX_KEYS 个:
+                uint8_t *r = records[count];
+                size_t keys = 0;
+                for (size_t k = 0; k < KEYBOARD_MAX_KEYS; k++)
+                {
+                    if (keyboards[i].prev_keys[k] != 0)
+                    {
+                        r[FRAME_SNAPSHOT_DEV_HEADER_LEN + keys++] = keyboards[i].prev_keys[k];
+                    }
+                }
+                r[0] = (uint8_t)i;
+                r[1] = keyboards[i].prev_mod;
+                r[2] = (uint8_t)keys;
+                record_len[count++] = FRAME_SNAPSHOT_DEV_HEADER_LEN + keys;
+            }
+        }
+        if (!seqlock_read_retry(&keyboards_lock, seq))
+        {
+            break;
+        }
+        // HID 任务或矩阵报告任务正在写入, 让它先完成:
+        snapshot_retries++;
+        taskYIELD();
+    }
+    // 与关键帧相同: 接收端忽略序号更小的事件, 快照已包含它们.
+    // 按帧负载上限装入键盘, 每帧带相同的序号, 没有键盘时也发一帧:
+    size_t total = 0;
+    size_t next = 0;
+    do
+    {
+        uint8_t payload[FRAME_MAX_PAYLOAD];
+        size_t len = FRAME_SNAPSHOT_HEADER_LEN;
+        size_t n = 0;
+        while (next < count && len + record_len[next] <= FRAME_MAX_PAYLOAD)
+        {
+            memcpy(&payload[len], records[next], record_len[next]);
+            len += record_len[next++];
+            n++;
+        }
+        payload[0] = event_seq & 0xFF;
+        payload[1] = event_seq >> 8;
+        payload[2] = (uint8_t)n | (next < count ? FRAME_SNAPSHOT_MORE : 0);
+        total += frame_encode(FRAME_TYPE_SNAPSHOT, payload, len, out + total);
+    } while (next < count);
+    return total;
+}
 
-    // 处理 Ctrl 组合键 (仅针对 A-Z):
-    if (ctrl && idx <= 25)
+// 命令任务中执行: 只记录请求, 应答由发送任务发出:
+static void cmd_query(const frame_parser_t *frame)
+{
+    if (frame->len < 1)
+    {
+        return;
+    }
+    if (frame->payload[0] == QUERY_SNAPSHOT)
     {
-        return idx + 1; // Ctrl+A = 0x01 ...
+        snapshot_requested = true;
+        xTaskNotifyGive(send_task);
     }
+    else if (frame->payload[0] == QUERY_KEYFRAME && STATE_STREAM_ENABLE)
+    {
+        state_request_keyframe();
+        xTaskNotifyGive(send_task);
+    }
+    else if (frame->payload[0] == QUERY_MEMORY && MEM_STATS_ENABLE)
+    {
+        memory_requested = true;
+        xTaskNotifyGive(send_task);
+    }
+}
 
-    // 返回对应的 ASCII:
-    return shift ? lut_shift[idx] : lut_plain[idx];
+static void keyboards_write_begin(void)
+{
+    if (MATRIX_ENABLE)
+    {
+        portENTER_CRITICAL(&keyboards_mux);
+    }
+    seqlock_write_begin(&keyboards_lock);
 }
 
-void uart_repeat_send_task(void *pvParameters)
+static void keyboards_write_end(void)
 {
-    uint8_t prev_key = 0;
-    while (1)
+    seqlock_write_end(&keyboards_lock);
+    if (MATRIX_ENABLE)
     {
-        // 复制全局变量至本地变量:
-        uint8_t local_key = current_key;
-        uint8_t local_mod = current_mod;
+        portEXIT_CRITICAL(&keyboards_mux);
+    }
+}
+
+// 命令任务中执行: 记录累计应答并唤醒发送任务, 尽快释放窗口:
+static void cmd_reliable_ack(const frame_parser_t *frame)
+{
+    if (reliable_ack(frame->payload, frame->len))
+    {
+        xTaskNotifyGive(send_task);
+    }
+}
 
-        if (local_key != prev_key)
+// 记录一个按键事件到所属键盘的事件队列, 队列满时丢弃:
+static void keyboard_push_event(keyboard_t *kbd, uint32_t ts_us, uint8_t key_code, uint8_t modifier, uint8_t flags)
+{
+    const key_event_t event = {
+        .ts_us = ts_us,
+        .seq = kbd->seq++,
+        .dev = (uint8_t)(kbd - keyboards),
+        .key_code = key_code,
+        .modifier = modifier,
+        .flags = flags,
+        .bridge = BRIDGE_ID};
+    if (!event_queue_push(&kbd->queue, &event))
+    {
+        ESP_LOGW("KEYBOARD", "Keyboard %d queue full, drop key 0x%02X", event.dev, key_code);
+    }
+}
+
+// 二进制与查表输出的帧带有序号, 必须按分配的顺序发出: 接收端按序号检测丢失, 状态流按序号丢弃
+// 关键帧之前的事件, 同一个键的按下与释放也不能颠倒. 因此全部放入同一类, 优先级只用于 ASCII 字符:
+#define TX_CLASS_SEQUENCED TX_CLASS_NORMAL
+
+// 放入输出队列, RS-485 模式下按键盘槽位的路由加上目的地址:
+static void queue_item(uint8_t dev, tx_class_t cls, const uint8_t *data, size_t len, uint32_t now_us)
+{
+    if (RS485_ENABLE)
+    {
+        uint8_t frame[TX_ITEM_MAX];
+        len = rs485_wrap(rs485_route[dev], data, len, now_us, frame);
+        tx_queue_push(cls, frame, len, now_us);
+        return;
+    }
+    tx_queue_push(cls, data, len, now_us);
+}
+
+// 每个队列项的数据长度, RS-485 模式需要留出地址帧的开销:
+#define TX_CHUNK_MAX (RS485_ENABLE ? TX_ITEM_MAX - RS485_OVERHEAD : TX_ITEM_MAX)
+
+// 将一批已按时间排序的事件编码后放入输出队列:
+static void queue_events(const key_event_t *events, size_t count, uint32_t now_us)
+{
+    if (OUTPUT_MODE == OUTPUT_MODE_BINARY)
+    {
+        uint8_t frame[FRAME_CHAIN_EVENT_LEN];
+        for (size_t i = 0; i < count; i++)
         {
-            // 按键状态变化，重置计数器:
-            tick_counter = 0;
+            size_t len = CHAIN_ENABLE ? chain_encode_event(&events[i], event_seq++, now_us, tx_queue_pending(), frame)
+                                      : frame_encode_event(&events[i], event_seq++, frame);
+            if (STATE_STREAM_ENABLE)
+            {
+                state_apply(&events[i], len);
+            }
+            queue_item(events[i].dev, TX_CLASS_SEQUENCED, frame, len, now_us);
+        }
+        return;
+    }
+    if (OUTPUT_MODE == OUTPUT_MODE_TABLE)
+    {
+        // 查表复制模板, 序号只分配给有输出的事件, 接收端据此检测丢失:
+        uint8_t out[ENCODER_TEMPLATE_MAX];
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t len = encoder_encode(&encoder, &events[i], event_seq, out);
+            if (len > 0)
+            {
+                event_seq++;
+                queue_item(events[i].dev, TX_CLASS_SEQUENCED, out, len, now_us);
+            }
+        }
+        return;
+    }
+    // ASCII 只发送按下事件, 批量转换后直接写入发送缓冲区.
+    // RS-485 模式下按设备分段, 每段发往各自的目的地址; 电传打字机模式按设备分段后各自排队:
+    size_t i = 0;
+    while (i < count)
+    {
+        uint8_t dev = events[i].dev;
+        key_input_t keys[TX_BATCH_SIZE];
+        size_t n = 0;
+        for (; i < count && (!(RS485_ENABLE || OUTPUT_MODE == OUTPUT_MODE_BAUDOT) || events[i].dev == dev); i++)
+        {
+            if (events[i].flags & KEY_EVENT_PRESS)
+            {
+                keys[n].key_code = events[i].key_code;
+                keys[n].modifier = events[i].modifier;
+                n++;
+            }
+        }
+        size_t len = usb_keycode_to_ascii_bulk(keys, n, tx_batch);
+        if (OUTPUT_MODE == OUTPUT_MODE_BAUDOT)
+        {
+            ita2_push(dev, tx_batch, len, now_us);
+            continue;
+        }
+        // 连续的同类字符合并为一个队列项:
+        size_t start = 0;
+        for (size_t j = 1; j <= len; j++)
+        {
+            tx_class_t cls = tx_classify_char(tx_batch[start]);
+            if (j == len || j - start == TX_CHUNK_MAX || tx_classify_char(tx_batch[j]) != cls)
+            {
+                queue_item(dev, cls, (const uint8_t *)&tx_batch[start], j - start, now_us);
+                start = j;
+            }
+        }
+    }
+}
+
+// MIDI 模式: 在 HID 回调中直接编码发送, 不经过发送任务的 10 ms 周期:
+static void midi_send_report(uint8_t dev, const uint8_t *prev_keys, const uint8_t *keys, size_t key_count,
+                             uint8_t modifier)
+{
+    int64_t start = esp_timer_get_time();
+    uint32_t now_ms = (uint32_t)(start / 1000);
+    uint8_t midi[KEYBOARD_MAX_KEYS * 2 * 3];
+    size_t len = 0;
+    // 先释放再按下, 同一份报告中换键时不会出现音符重叠:
+    for (size_t i = 0; i < KEYBOARD_MAX_KEYS; i++)
+    {
+        if (prev_keys[i] != 0 && memchr(keys, prev_keys[i], key_count) == NULL)
+        {
+            len += midi_encode_key(dev, prev_keys[i], modifier, false, now_ms, midi + len);
+        }
+    }
+    for (size_t i = 0; i < key_count; i++)
+    {
+        if (keys[i] != 0 && memchr(prev_keys, keys[i], KEYBOARD_MAX_KEYS) == NULL)
+        {
+            len += midi_encode_key(dev, keys[i], modifier, true, now_ms, midi + len);
         }
-        if (local_key != 0)
+    }
+    if (len == 0)
+    {
+        return;
+    }
+    // 写入 TX 环形缓冲区后立即返回, 先发送再记录日志:
+    uart_tx_write(midi, len);
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - start);
+    if (latency > midi_latency_max_us)
+    {
+        midi_latency_max_us = latency;
+        ESP_LOGW("MIDI", "Max latency: %" PRIu32 " us", latency);
+    }
+    ESP_LOG_BUFFER_HEX("MIDI", midi, len);
+}
+
+// 按住重复: 每个定时器周期调用一次, 按住超过触发间隔时重复发送当前键:
+static void typematic_tick(uint8_t *prev_key)
+{
+    // 复制全局变量至本地变量:
+    uint8_t local_key = current_key;
+    uint8_t local_mod = current_mod;
+
+    if (local_key != *prev_key)
+    {
+        // 按键状态变化，重置计数器 (首次按下已由事件队列发送):
+        tick_counter = 0;
+    }
+    if (local_key != 0)
+    {
+        tick_counter++;
+        if (tick_counter >= TICK_COUNT_MAX)
         {
-            if (tick_counter == 0)
+            tick_counter = 0;
+            // 按住超过触发间隔, 重复发送 (ASCII 为批量类, 不会延迟控制字符与普通按键):
+            if (OUTPUT_MODE == OUTPUT_MODE_TABLE)
+            {
+                const key_event_t event = {
+                    .dev = current_dev,
+                    .key_code = local_key,
+                    .modifier = local_mod,
+                    .flags = KEY_EVENT_PRESS | KEY_EVENT_REPEAT};
+                uint8_t out[ENCODER_TEMPLATE_MAX];
+                size_t len = encoder_encode(&encoder, &event, event_seq, out);
+                if (len > 0)
+                {
+                    event_seq++;
+                    queue_item(current_dev, TX_CLASS_SEQUENCED, out, len, (uint32_t)esp_timer_get_time());
+                }
+            }
+            else
             {
-                // 转换并发送ASCII码:
                 char ascii_char = usb_keycode_to_ascii(local_key, local_mod);
                 if (ascii_char != 0)
                 {
-                    if (ascii_char >= 32 && ascii_char <= 126)
-                    {
-                        ESP_LOGI("UART", "Send: 0x%02X: [%c]", (uint8_t)ascii_char, ascii_char);
-                    }
-                    else
-                    {
-                        ESP_LOGI("UART", "Send: 0x%02X", (uint8_t)ascii_char);
-                    }
-                    // 通过UART发送:
-                    uart_write_bytes(UART_NUM_1, &ascii_char, 1);
+                    queue_item(current_dev, TX_CLASS_BULK, (const uint8_t *)&ascii_char, 1, (uint32_t)esp_timer_get_time());
                 }
             }
-            tick_counter++;
-            if (tick_counter >= TICK_COUNT_MAX)
+        }
+    }
+    else
+    {
+        tick_counter = 0;
+    }
+    *prev_key = local_key;
+}
+
+void uart_repeat_send_task(void *pvParameters)
+{
+    uint8_t prev_key = 0;
+    key_event_t merged[TX_BATCH_SIZE];
+    // 级联模式下上游事件队列作为最后一路参与归并:
+    event_queue_t *queues[KEYBOARD_SLOTS + 1];
+    bool active[KEYBOARD_SLOTS + 1];
+    const size_t queue_count = CHAIN_ENABLE ? KEYBOARD_SLOTS + 1 : KEYBOARD_SLOTS;
+    for (int i = 0; i < KEYBOARD_SLOTS; i++)
+    {
+        queues[i] = &keyboards[i].queue;
+    }
+    queues[KEYBOARD_SLOTS] = CHAIN_ENABLE ? chain_upstream_queue() : NULL;
+    // 上游事件已在上游归并过, 到达时间即为顺序, 队列为空时不需要等待:
+    active[KEYBOARD_SLOTS] = false;
+    uint32_t stats_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    uint32_t dropped[KEYBOARD_SLOTS] = {0};
+    while (1)
+    {
+        if (OUTPUT_MODE == OUTPUT_MODE_TABLE && __atomic_load_n(&encoder_swap, __ATOMIC_ACQUIRE))
+        {
+            // 编码表只在本任务中使用, 在两批事件之间切换, 不需要加锁:
+            encoder_free(&encoder);
+            encoder = encoder_next;
+            __atomic_store_n(&encoder_swap, false, __ATOMIC_RELEASE);
+            ESP_LOGI("ENCODER", "Switched to uploaded definition, %u rules", encoder.rules);
+        }
+        // 归并各键盘的事件队列, 按发生顺序放入输出队列:
+        for (int i = 0; i < KEYBOARD_SLOTS; i++)
+        {
+            // 被隔离的接口不再报告, 不能让其他键盘的事件等待它:
+            active[i] = keyboards[i].handle != NULL && !keyboards[i].muted && !keyboards[i].quarantined;
+        }
+        uint32_t now_us = (uint32_t)esp_timer_get_time();
+        size_t count;
+        while ((count = event_merge(queues, active, queue_count, now_us,
+                                    REORDER_WINDOW_MS * 1000, merged, TX_BATCH_SIZE)) > 0)
+        {
+            queue_events(merged, count, now_us);
+        }
+        if (OUTPUT_MODE == OUTPUT_MODE_ASCII || OUTPUT_MODE == OUTPUT_MODE_TABLE)
+        {
+            typematic_tick(&prev_key);
+        }
+        if (STATE_STREAM_ENABLE)
+        {
+            // 本机事件队列溢出时丢失的事件无法补发, 清空状态并立即发送关键帧:
+            for (int i = 0; i < KEYBOARD_SLOTS; i++)
+            {
+                if (keyboards[i].queue.dropped != dropped[i])
+                {
+                    dropped[i] = keyboards[i].queue.dropped;
+                    state_clear(i);
+                    state_request_keyframe();
+                }
+            }
+        }
+
+        if (RELIABLE_ENABLE)
+        {
+            // 到期的重发排在所有新数据之前, 不经过优先级队列:
+            size_t free_size = FEC_ENABLE ? uart_tx_free() * 5 / 12 : uart_tx_free();
+            size_t resent = reliable_poll((uint32_t)esp_timer_get_time(), reliable_out,
+                                          free_size < sizeof(reliable_out) ? free_size : sizeof(reliable_out));
+            if (resent > 0)
             {
-                tick_counter = 0;
+                send_frames(reliable_out, resent);
             }
         }
+
+        // 按优先级取出本周期 UART 能发完的数据, 积压留在队列中, 后到的控制字符可以越过.
+        // RS-485 总线忙或仍有帧在等待应答时本周期不取新的数据:
+        size_t budget = uart_tx_free();
+        if (FEC_ENABLE)
+        {
+            // 编码后约为 2.4 倍 (10 字节事件帧编码为 24 字节):
+            budget = budget * 5 / 12;
+        }
+        if (RELIABLE_ENABLE)
+        {
+            // 扣除段的开销, 并且只取窗口能容纳的部分, 窗口满时新数据留在队列中:
+            size_t room = reliable_room();
+            budget = budget * RELIABLE_SEGMENT_MIN / (RELIABLE_SEGMENT_MIN + RELIABLE_OVERHEAD);
+            budget = budget < room ? budget : room;
+        }
+        if (budget > sizeof(tx_out))
+        {
+            budget = sizeof(tx_out);
+        }
+        if (RS485_ENABLE && budget > RS485_BACKLOG_SIZE)
+        {
+            budget = RS485_BACKLOG_SIZE;
+        }
+        if (RS485_ENABLE && !rs485_bus_idle())
+        {
+            budget = 0;
+        }
+        if (OUTPUT_MODE == OUTPUT_MODE_BAUDOT)
+        {
+            // 字符不经过优先级队列, 按线路速度交给 UART, 积压留在 ita2 的队列中以便选择换档最少的顺序:
+            uint8_t baudot[4];
+            size_t n = ita2_drain((uint32_t)esp_timer_get_time(), baudot, sizeof(baudot));
+            if (n > 0)
+            {
+                uart_send((const char *)baudot, n);
+            }
+        }
+        size_t len = tx_queue_drain(tx_out, budget, (uint32_t)esp_timer_get_time());
+        if (len > 0 && RS485_ENABLE)
+        {
+            rs485_transmit(tx_out, len);
+        }
+        else if (len > 0 && RELIABLE_ENABLE)
+        {
+            size_t n = reliable_send(tx_out, len, (uint32_t)esp_timer_get_time(), reliable_out);
+            if (n > 0)
+            {
+                send_frames(reliable_out, n);
+            }
+        }
+        else if (len > 0)
+        {
+            send_frames(tx_out, len);
+        }
+        if (CMD_ENABLE && snapshot_requested &&
+            uart_tx_free() >= (FEC_ENABLE ? SNAPSHOT_CODED_MAX : sizeof(snapshot_out)))
+        {
+            // 快照与关键帧一样不经过优先级队列:
+            snapshot_requested = false;
+            send_frames(snapshot_out, encode_snapshot(snapshot_out));
+        }
+        if (CMD_ENABLE && MEM_STATS_ENABLE && memory_requested &&
+            uart_tx_free() >= (FEC_ENABLE ? FEC_CODED_LEN(FRAME_MEMORY_LEN) : FRAME_MEMORY_LEN))
+        {
+            // 采样时遍历堆, 只在查询时进行:
+            uint8_t memory[FRAME_MEMORY_LEN];
+            memory_requested = false;
+            send_frames(memory, mem_stats_encode(memory));
+        }
+        while (TABLE_UPLOAD_ENABLE &&
+               uart_tx_free() >= (FEC_ENABLE ? FEC_CODED_LEN(TABLE_STATUS_FRAME_LEN) : TABLE_STATUS_FRAME_LEN))
+        {
+            // 上传进度同样不经过优先级队列:
+            uint8_t status[TABLE_STATUS_FRAME_LEN];
+            size_t n = table_upload_status(status);
+            if (n == 0)
+            {
+                break;
+            }
+            send_frames(status, n);
+        }
+        if (STATE_STREAM_ENABLE)
+        {
+            // 关键帧不经过优先级队列直接写入, 之后编码的增量都排在它后面;
+            // 仍在队列中的更早增量被接收端按序号忽略:
+            size_t free_size = FEC_ENABLE ? uart_tx_free() * 5 / 12 : uart_tx_free();
+            size_t kf_len = state_poll((uint32_t)(esp_timer_get_time() / 1000), event_seq, active, KEYBOARD_SLOTS,
+                                       state_out, free_size < sizeof(state_out) ? free_size : sizeof(state_out));
+            if (kf_len > 0)
+            {
+                send_frames(state_out, kf_len);
+            }
+        }
+        uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        if (now_ms - stats_ms >= TX_STATS_INTERVAL_MS)
+        {
+            stats_ms = now_ms;
+            tx_queue_log_stats();
+            uart_tx_log_stats();
+            if (OUTPUT_MODE == OUTPUT_MODE_BAUDOT)
+            {
+                ita2_log_stats((uint32_t)esp_timer_get_time());
+            }
+            if (RS485_ENABLE)
+            {
+                rs485_log_stats();
+            }
+            if (CHAIN_ENABLE)
+            {
+                chain_log_stats();
+            }
+            if (STATE_STREAM_ENABLE)
+            {
+                state_log_stats();
+            }
+            if (RELIABLE_ENABLE)
+            {
+                reliable_log_stats();
+            }
+            if (TABLE_UPLOAD_ENABLE)
+            {
+                table_store_log_stats();
+            }
+            if (CMD_ENABLE)
+            {
+                cmd_log_stats();
+                ESP_LOGI("CMD", "snapshot read retries=%" PRIu32, snapshot_retries);
+            }
+            if (MATRIX_ENABLE)
+            {
+                matrix_log_stats(&matrix);
+            }
+            if (RATE_LIMIT_ENABLE)
+            {
+                ESP_LOGI("KEYBOARD", "rate limit: dropped reports=%" PRIu32 " quarantined=%" PRIu32,
+                         rate_dropped, rate_quarantined);
+            }
+            if (NKRO_ENABLE)
+            {
+                ESP_LOGI("KEYBOARD", "dedup: suppressed reports=%" PRIu32 " failovers=%" PRIu32,
+                         dedup_suppressed, dedup_failovers);
+            }
+            if (MEM_STATS_ENABLE)
+            {
+                mem_stats_log();
+            }
+        }
+        if (CHAIN_ENABLE || CMD_ENABLE)
+        {
+            // 收到上游事件或查询时立即唤醒, 不必等满一个周期:
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TIMER_INTERVAL_MS));
+        }
         else
         {
-            tick_counter = 0;
+            // 根据配置的间隔进行延时:
+            vTaskDelay(pdMS_TO_TICKS(TIMER_INTERVAL_MS));
         }
-        prev_key = local_key;
-        // 根据配置的间隔进行延时:
-        vTaskDelay(pdMS_TO_TICKS(TIMER_INTERVAL_MS));
     }
 }
 
-// 当键盘有按键动作时的回调函数:
-void hid_host_keyboard_report_callback(const uint8_t *report, size_t report_len, void *arg)
+// 当键盘有按键动作时的回调函数, USB 键盘在 HID 任务中调用, 按键矩阵在矩阵报告任务中调用.
+// ts_us 是报告产生的时间 (USB 传输完成或矩阵扫描到变化), 作为事件的时间戳:
+void hid_host_keyboard_report_callback(const uint8_t *report, size_t report_len, uint32_t ts_us, void *arg)
 {
     // 标准 HID 键盘报告格式 (8字节):
     // report[0]: 修饰键 (Ctrl, Shift, etc)
     // report[1]: 保留
     // report[2~7]: 同时按下的键码 (最多6个)
     // report[2] 是第一个按下的键的键码 (Keycode)
-    if (report_len < 3)
+    // NKRO 接口的报告已转换为相同格式, 键码最多 KEYBOARD_MAX_KEYS 个.
+    keyboard_t *kbd = (keyboard_t *)arg;
+    uint8_t *prev_keys = kbd->prev_keys;
+    if (report_len < 2)
         return;
+    size_t key_count = report_len - 2 < KEYBOARD_MAX_KEYS ? report_len - 2 : KEYBOARD_MAX_KEYS;
+    if (OUTPUT_MODE == OUTPUT_MODE_MIDI)
+    {
+        midi_send_report((uint8_t)(kbd - keyboards), prev_keys, &report[2], key_count, report[0]);
+    }
+    else
+    {
+        // 与上一份报告比较, 消失的键码产生释放事件, 新出现的键码产生按下事件:
+        if (STATE_STREAM_ENABLE)
+        {
+            // 状态流需要完整的按键位图, 修饰键的变化也作为键码 0xE0 ~ 0xE7 的事件:
+            uint8_t changed = kbd->prev_mod ^ report[0];
+            for (int b = 0; b < 8; b++)
+            {
+                if (changed & (1 << b))
+                {
+                    keyboard_push_event(kbd, ts_us, 0xE0 + b, report[0], (report[0] & (1 << b)) ? KEY_EVENT_PRESS : 0);
+                }
+            }
+        }
+        for (size_t i = 0; i < KEYBOARD_MAX_KEYS; i++)
+        {
+            if (prev_keys[i] != 0 && memchr(&report[2], prev_keys[i], key_count) == NULL)
+            {
+                keyboard_push_event(kbd, ts_us, prev_keys[i], report[0], 0);
+            }
+        }
+        for (size_t i = 0; i < key_count; i++)
+        {
+            uint8_t key = report[2 + i];
+            if (key != 0 && memchr(prev_keys, key, KEYBOARD_MAX_KEYS) == NULL)
+            {
+                keyboard_push_event(kbd, ts_us, key, report[0], KEY_EVENT_PRESS);
+            }
+        }
+    }
+    keyboards_write_begin();
+    memset(prev_keys, 0, KEYBOARD_MAX_KEYS);
+    memcpy(prev_keys, &report[2], key_count);
+    kbd->prev_mod = report[0];
+    keyboards_write_end();
     // 更新当前全局状态:
     current_mod = report[0];
-    current_key = report[2]; // 即使是 0 (释放) 也会赋值给 current_key
+    current_key = key_count > 0 ? report[2] : 0; // 即使是 0 (释放) 也会赋值给 current_key
+    current_dev = (uint8_t)(kbd - keyboards);
     ESP_LOGI("KEYBOARD", "Key pressed: 0x%02X, mod: 0x%02X", current_key, current_mod);
 }
 
+// 兄弟接口接管输出: 原输出接口按住的键补发释放后静默, 接管者从空状态开始,
+// 下一份报告中按住的键重新发出按下:
+static void keyboard_promote(keyboard_t *kbd, uint32_t now_us)
+{
+    keyboard_t *old = kbd->sibling;
+    if (old != NULL && !old->muted)
+    {
+        const uint8_t empty_report[2] = {0};
+        hid_host_keyboard_report_callback(empty_report, sizeof(empty_report), now_us, old);
+    }
+    keyboards_write_begin();
+    if (old != NULL)
+    {
+        old->muted = true;
+        old->silent_reports = 0;
+    }
+    memset(kbd->prev_keys, 0, sizeof(kbd->prev_keys));
+    kbd->prev_mod = 0;
+    kbd->muted = false;
+    kbd->silent_reports = 0;
+    keyboards_write_end();
+}
+
+// 静默接口收到报告时调用, 返回 true 表示接管输出, 这份报告照常处理.
+// 两个接口报告同一次按键变化, 输出接口正常时两份静默报告之间总有它的报告;
+// 连续 DEDUP_FAILOVER_REPORTS 次没有时认为它已停止报告:
+static bool keyboard_check_failover(keyboard_t *kbd, uint32_t now_us)
+{
+    keyboard_t *sib = kbd->sibling;
+    bool followed = sib != NULL && (int32_t)(sib->last_report_us - kbd->last_report_us) >= 0;
+    kbd->last_report_us = now_us;
+    kbd->silent_reports = followed ? 0 : kbd->silent_reports + 1;
+    if (kbd->silent_reports < DEDUP_FAILOVER_REPORTS)
+    {
+        dedup_suppressed++;
+        return false;
+    }
+    ESP_LOGW("App", "Keyboard #%d stopped reporting, #%d takes over",
+             sib != NULL ? (int)(sib - keyboards) : -1, (int)(kbd - keyboards));
+    keyboard_promote(kbd, now_us);
+    dedup_failovers++;
+    return true;
+}
+
+// Boot 格式报告中是否有新按下的键 (含修饰键). 只有这样的报告计入限速,
+// 重复的报告不产生事件, 只有释放的报告总是放行, 限速不会让键卡住:
+static bool keyboard_report_presses(const keyboard_t *kbd, const uint8_t *report, size_t report_len)
+{
+    if (report_len < 2)
+    {
+        return false;
+    }
+    if (report[0] & ~kbd->prev_mod)
+    {
+        return true;
+    }
+    size_t key_count = report_len - 2 < KEYBOARD_MAX_KEYS ? report_len - 2 : KEYBOARD_MAX_KEYS;
+    for (size_t i = 0; i < key_count; i++)
+    {
+        if (report[2 + i] != 0 && memchr(kbd->prev_keys, report[2 + i], KEYBOARD_MAX_KEYS) == NULL)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 隔离持续超限的接口: 按住的键补发释放, 之后的报告直接丢弃, 槽位保留到设备拔出.
+// 在报告回调中调用, 接口的 IN 传输由 hid_events_task 在本次事件处理返回之后停止:
+static void keyboard_quarantine(keyboard_t *kbd, uint32_t now_us)
+{
+    const uint8_t empty_report[2] = {0};
+    hid_host_keyboard_report_callback(empty_report, sizeof(empty_report), now_us, kbd);
+    keyboards_write_begin();
+    kbd->quarantined = true;
+    kbd->stop_pending = true;
+    kbd->stop_handle = kbd->handle;
+    kbd->stop_generation = kbd->generation;
+    keyboards_write_end();
+    rate_quarantined++;
+    ESP_LOGW("App", "Keyboard #%d keeps exceeding %d reports/s, quarantined",
+             (int)(kbd - keyboards), RATE_LIMIT_PER_SEC);
+}
+
+// 处理一份输入报告, 逐份回调与批量投递共用:
+static void keyboard_input_report(keyboard_t *kbd, const uint8_t *report, size_t report_len, uint32_t now_us)
+{
+    // HID 任务停止接口之前, 以及停止前已完成的传输仍在批量投递中时:
+    if (kbd->quarantined)
+    {
+        return;
+    }
+    // 兄弟接口负责输出时只记录报告时间, 不做跨接口的报告比较:
+    if (kbd->muted && !keyboard_check_failover(kbd, now_us))
+    {
+        return;
+    }
+    kbd->last_report_us = now_us;
+    uint8_t boot[2 + KEYBOARD_MAX_KEYS];
+    if (NKRO_ENABLE)
+    {
+        // 按连接时解析的布局转换为 Boot 格式, NKRO 接口上的其他报告 (如多媒体键) 忽略:
+        report_len = hid_report_decode_keyboard(&kbd->layout, report, report_len, boot, sizeof(boot));
+        if (report_len == 0)
+        {
+            return;
+        }
+        report = boot;
+    }
+    if (RATE_LIMIT_ENABLE && keyboard_report_presses(kbd, report, report_len))
+    {
+        // 丢弃的报告相当于与下一份合并, 下一份报告仍与最后处理的报告比较:
+        rate_limit_result_t result = rate_limit_charge(&kbd->limit, &rate_limit_config, now_us);
+        if (result == RATE_LIMIT_QUARANTINE)
+        {
+            keyboard_quarantine(kbd, now_us);
+            return;
+        }
+        if (result == RATE_LIMIT_DROP)
+        {
+            rate_dropped++;
+            return;
+        }
+    }
+    hid_host_keyboard_report_callback(report, report_len, now_us, kbd);
+}
+
+// 批量投递: 报告直接指向驱动的传输缓冲区, 不再逐份取数据和校验句柄:
+static void hid_report_batch_callback(const hid_host_report_t *reports, size_t count, void *arg)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reports[i].data != NULL)
+        {
+            keyboard_input_report((keyboard_t *)reports[i].arg, reports[i].data, reports[i].length,
+                                  (uint32_t)reports[i].timestamp_us);
+        }
+    }
+}
+
 // 设备打开后的回调
 void hid_host_interface_callback(hid_host_device_handle_t hid_device_handle, const hid_host_interface_event_t event, void *arg)
 {
+    keyboard_t *kbd = (keyboard_t *)arg;
     if (event == HID_HOST_INTERFACE_EVENT_INPUT_REPORT)
     {
         size_t report_read_len;
-        uint8_t report[8]; // 键盘标准报告是8字节
+        uint8_t report[64]; // Boot 键盘报告是8字节, NKRO 位图报告更长
 
         // 获取实际产生该事件的数据:
         esp_err_t err = hid_host_device_get_raw_input_report_data(
@@ -141,15 +1046,113 @@ void hid_host_interface_callback(hid_host_device_handle_t hid_device_handle, con
             sizeof(report),
             &report_read_len);
 
+        // 传输完成时驱动记录的时间, 不受回调之前其他处理的延迟影响:
+        int64_t done_us = 0;
         if (err == ESP_OK)
         {
-            hid_host_keyboard_report_callback(report, report_read_len, NULL);
+            err = hid_host_device_get_input_report_timestamp(hid_device_handle, &done_us);
         }
-        else
+        if (err != ESP_OK)
         {
             ESP_LOGE("HID", "Failed to get input report data");
+            return;
+        }
+        keyboard_input_report(kbd, report, report_read_len, (uint32_t)done_us);
+    }
+    else if (event == HID_HOST_INTERFACE_EVENT_DISCONNECTED)
+    {
+        // 设备拔出: 按住的键补发释放, 关闭接口并释放键盘槽位:
+        uint32_t now_us = (uint32_t)esp_timer_get_time();
+        if (!kbd->muted)
+        {
+            const uint8_t empty_report[8] = {0};
+            hid_host_keyboard_report_callback(empty_report, sizeof(empty_report), now_us, kbd);
+        }
+        ESP_LOGI("App", "Keyboard %d disconnected.", (int)(kbd - keyboards));
+        hid_host_device_close(hid_device_handle);
+        keyboard_t *sib = kbd->sibling;
+        if (sib != NULL)
+        {
+            // 只关闭了一个接口时由兄弟接口继续输出:
+            sib->sibling = NULL;
+            if (sib->muted)
+            {
+                keyboard_promote(sib, now_us);
+            }
+        }
+        keyboards_write_begin();
+        kbd->handle = NULL;
+        kbd->sibling = NULL;
+        kbd->muted = false;
+        keyboards_write_end();
+    }
+}
+
+// 为新打开的接口分配键盘槽位, 没有空闲槽位返回 NULL:
+static keyboard_t *keyboard_alloc(hid_host_device_handle_t hid_device_handle)
+{
+    for (int i = 0; i < MAX_KEYBOARDS; i++)
+    {
+        if (keyboards[i].handle == NULL)
+        {
+            // 事件队列的读写位置不复位, 发送任务可能仍在读取上一个设备的剩余事件:
+            keyboards_write_begin();
+            memset(keyboards[i].prev_keys, 0, sizeof(keyboards[i].prev_keys));
+            keyboards[i].prev_mod = 0;
+            keyboards[i].handle = hid_device_handle;
+            keyboards[i].sibling = NULL;
+            keyboards[i].muted = false;
+            keyboards[i].silent_reports = 0;
+            keyboards[i].last_report_us = 0;
+            keyboards[i].quarantined = false;
+            keyboards[i].stop_pending = false;
+            keyboards[i].generation++;
+            keyboards_write_end();
+            if (RATE_LIMIT_ENABLE)
+            {
+                rate_limit_init(&keyboards[i].limit, &rate_limit_config, (uint32_t)esp_timer_get_time());
+            }
+            return &keyboards[i];
         }
     }
+    return NULL;
+}
+
+// 释放打开失败或不是键盘的接口占用的槽位:
+static void keyboard_free(keyboard_t *kbd)
+{
+    keyboards_write_begin();
+    kbd->handle = NULL;
+    keyboards_write_end();
+}
+
+// 同一设备上的键盘接口配对, 连接时决定由哪个输出: 能同时报告更多按键的接口输出,
+// 另一个静默备用. 之后每份报告只需检查 muted:
+static void keyboard_pair(keyboard_t *kbd)
+{
+    for (int i = 0; i < MAX_KEYBOARDS; i++)
+    {
+        keyboard_t *sib = &keyboards[i];
+        if (sib == kbd || sib->handle == NULL || sib->addr != kbd->addr || sib->sibling != NULL)
+        {
+            continue;
+        }
+        kbd->sibling = sib;
+        sib->sibling = kbd;
+        if (kbd->layout.rollover > sib->layout.rollover)
+        {
+            keyboard_promote(kbd, (uint32_t)esp_timer_get_time());
+        }
+        else
+        {
+            keyboards_write_begin();
+            kbd->muted = true;
+            keyboards_write_end();
+        }
+        ESP_LOGI("App", "Keyboard #%d and #%d are interfaces of one device, #%d reports",
+                 (int)(kbd - keyboards), i, kbd->muted ? i : (int)(kbd - keyboards));
+        return;
+    }
 }
 
 // 处理 HID 协议栈事件的回调:
@@ -160,46 +1163,317 @@ void hid_host_device_event_callback(hid_host_device_handle_t hid_device_handle,
         // 发现新设备:
         hid_host_dev_params_t dev_params;
         hid_host_device_get_params(hid_device_handle, &dev_params);
-        // 只打开子类为 1 (Boot) 且协议为 1 (Keyboard) 的接口:
-        if (dev_params.sub_class == HID_SUBCLASS_BOOT_INTERFACE && dev_params.proto == HID_PROTOCOL_KEYBOARD)
+        // 打开子类为 1 (Boot) 且协议为 1 (Keyboard) 的接口,
+        // NKRO 模式下还打开非 Boot 接口, 报告描述符中有键盘报告时保留:
+        bool boot = dev_params.sub_class == HID_SUBCLASS_BOOT_INTERFACE && dev_params.proto == HID_PROTOCOL_KEYBOARD;
+        bool nkro = NKRO_ENABLE && dev_params.sub_class != HID_SUBCLASS_BOOT_INTERFACE;
+        if (boot || nkro)
         {
+            keyboard_t *kbd = keyboard_alloc(hid_device_handle);
+            if (kbd == NULL)
+            {
+                ESP_LOGW("App", "Too many keyboards, ignore interface %d", dev_params.iface_num);
+                return;
+            }
             hid_host_device_config_t dev_config = {
                 .callback = hid_host_interface_callback,
-                .callback_arg = NULL};
+                .callback_arg = kbd};
             esp_err_t err = hid_host_device_open(hid_device_handle, &dev_config);
             if (err != ESP_OK)
             {
                 ESP_LOGE("App", "Failed to open HID device");
+                keyboard_free(kbd);
                 return;
             }
+            kbd->layout = hid_boot_layout;
+            kbd->addr = dev_params.addr;
+            if (nkro)
+            {
+                // 报告描述符只能在打开后读取:
+                size_t desc_len = 0;
+                const uint8_t *desc = hid_host_get_report_descriptor(hid_device_handle, &desc_len);
+                if (desc == NULL || !hid_report_parse_keyboard(desc, desc_len, &kbd->layout))
+                {
+                    hid_host_device_close(hid_device_handle);
+                    keyboard_free(kbd);
+                    return;
+                }
+            }
             err = hid_host_device_start(hid_device_handle);
             if (err != ESP_OK)
             {
-                ESP_LOGE("App", "Failed to start HID device");
+                ESP_LOGE("App", "Failed to start HID device: %s", esp_err_to_name(err));
+                hid_host_device_close(hid_device_handle);
+                keyboard_free(kbd);
                 return;
             }
-            ESP_LOGI("App", "Keyboard %d connected and opened.", dev_params.iface_num);
+            // 启动成功后再配对, 失败时不必撤销兄弟接口的状态. 报告在本任务中投递, 配对之前不会到达:
+            keyboard_pair(kbd);
+            ESP_LOGI("App", "Keyboard %d connected and opened as #%d, %d-key rollover.",
+                     dev_params.iface_num, (int)(kbd - keyboards), kbd->layout.rollover);
+            if (STATE_STREAM_ENABLE)
+            {
+                state_request_keyframe();
+            }
         }
     }
 }
 
+// 停止被隔离的接口. 报告回调 (逐份与批量) 中不能停止接口 (见 hid_host_batch.h), 在
+// hid_host_handle_events() 返回之后调用. 槽位的分配与释放都在本任务中, 句柄与代数仍与隔离时
+// 相同才停止, 接口已关闭或槽位已分给新设备时放弃:
+static void keyboard_stop_quarantined(void)
+{
+    for (int i = 0; i < MAX_KEYBOARDS; i++)
+    {
+        keyboard_t *kbd = &keyboards[i];
+        if (!kbd->stop_pending)
+        {
+            continue;
+        }
+        kbd->stop_pending = false;
+        if (kbd->handle != kbd->stop_handle || kbd->generation != kbd->stop_generation)
+        {
+            continue;
+        }
+        esp_err_t err = hid_host_device_stop(kbd->handle);
+        if (err != ESP_OK)
+        {
+            ESP_LOGW("App", "Keyboard #%d: failed to stop quarantined interface: %s", i, esp_err_to_name(err));
+        }
+    }
+}
+
+// HID 驱动的事件处理任务, 代替驱动的后台任务, 以便在每次处理之后停止隔离的接口 (MIDI 模式也适用):
+static void hid_events_task(void *pvParameters)
+{
+    while (hid_host_handle_events(portMAX_DELAY) == ESP_OK)
+    {
+        if (RATE_LIMIT_ENABLE)
+        {
+            keyboard_stop_quarantined();
+        }
+    }
+    vTaskDelete(NULL);
+}
+
+// 读取编码表定义: 优先使用数据表中的定义, 其次仿真时读取环境变量 SIM_ENCODER 指定的文件,
+// 否则读取 NVS, 返回长度, 没有定义时返回 0:
+static size_t read_encoder_def(char *def)
+{
+    size_t len = table_store_read(TABLE_SECTION_ENCODER, def, ENCODER_DEF_MAX);
+    if (len > 0)
+    {
+        def[len] = 0;
+        return len;
+    }
+#if CONFIG_IDF_TARGET_LINUX
+    const char *path = getenv("SIM_ENCODER");
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (f != NULL)
+    {
+        len = fread(def, 1, ENCODER_DEF_MAX, f);
+        fclose(f);
+    }
+#else
+    nvs_handle_t nvs;
+    if (nvs_flash_init() == ESP_OK && nvs_open(ENCODER_NVS_NAMESPACE, NVS_READONLY, &nvs) == ESP_OK)
+    {
+        len = ENCODER_DEF_MAX;
+        esp_err_t err = nvs_get_blob(nvs, ENCODER_NVS_KEY, def, &len);
+        if (err != ESP_OK)
+        {
+            ESP_LOGW("ENCODER", "Read definition failed: %s", esp_err_to_name(err));
+            len = 0;
+        }
+        nvs_close(nvs);
+    }
+#endif
+    def[len] = 0;
+    return len;
+}
+
+// 编码表的内存记入应用子系统:
+static void *encoder_alloc(size_t size)
+{
+    return mem_malloc(MEM_TAG_APP, size);
+}
+
+// 加载并编译编码表, 定义有误时记录错误行并使用默认定义:
+static void load_encoder(void)
+{
+    const encoder_allocator_t allocator = {encoder_alloc, mem_free};
+    encoder_set_allocator(&allocator);
+    char *def = mem_malloc(MEM_TAG_APP, ENCODER_DEF_MAX + 1);
+    if (def != NULL && read_encoder_def(def) > 0)
+    {
+        if (encoder_compile(&encoder, def))
+        {
+            ESP_LOGI("ENCODER", "Loaded %u rules, %u planes, %d bytes", encoder.rules, encoder.planes,
+                     (int)encoder_memory(&encoder));
+            mem_free(def);
+            return;
+        }
+        ESP_LOGE("ENCODER", "Definition line %d: %s", encoder.error_line, encoder.error);
+    }
+    mem_free(def);
+    encoder_compile(&encoder, ENCODER_DEFAULT);
+    ESP_LOGW("ENCODER", "Using default definition, %d bytes", (int)encoder_memory(&encoder));
+}
+
+// 写入任务中执行: 新的数据表生效后编译其中的编码表, 交给发送任务切换. 编译失败时保留当前的表:
+static void table_committed(uint32_t generation)
+{
+    if (OUTPUT_MODE != OUTPUT_MODE_TABLE)
+    {
+        return;
+    }
+    char *def = mem_malloc(MEM_TAG_APP, ENCODER_DEF_MAX + 1);
+    size_t len = def != NULL ? table_store_read(TABLE_SECTION_ENCODER, def, ENCODER_DEF_MAX) : 0;
+    if (len == 0)
+    {
+        ESP_LOGW("ENCODER", "Table generation %" PRIu32 " has no encoder definition, keeping current", generation);
+        mem_free(def);
+        return;
+    }
+    def[len] = 0;
+    encoder_t next;
+    bool ok = encoder_compile(&next, def);
+    mem_free(def);
+    if (!ok)
+    {
+        ESP_LOGE("ENCODER", "Table generation %" PRIu32 " definition line %d: %s, keeping current", generation,
+                 next.error_line, next.error);
+        return;
+    }
+    // 上一次切换还没被发送任务取走时等待一个周期:
+    while (__atomic_load_n(&encoder_swap, __ATOMIC_ACQUIRE))
+    {
+        vTaskDelay(pdMS_TO_TICKS(TIMER_INTERVAL_MS));
+    }
+    encoder_next = next;
+    __atomic_store_n(&encoder_swap, true, __ATOMIC_RELEASE);
+}
+
 // 初始化 UART:
 void init_uart()
 {
     const uart_config_t uart_config = {
         .baud_rate = UART_BUAD_RATE,
-        .data_bits = UART_DATA_8_BITS,
+        .data_bits = OUTPUT_MODE == OUTPUT_MODE_BAUDOT ? UART_DATA_5_BITS : UART_DATA_8_BITS,
         .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
+        .stop_bits = OUTPUT_MODE == OUTPUT_MODE_BAUDOT ? UART_STOP_BITS_1_5 : UART_STOP_BITS_1,
         .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
+        // 电传打字机的波特率低于 APB 时钟分频的下限, 改用 40 MHz 晶振时钟:
+        .source_clk = OUTPUT_MODE == OUTPUT_MODE_BAUDOT ? UART_SCLK_XTAL : UART_SCLK_DEFAULT,
     };
-    uart_driver_install(UART_PORT, 1024 * 2, 0, 0, NULL, 0);
+    uart_driver_install(UART_PORT, UART_RX_BUFFER_SIZE, UART_TX_BUFFER_SIZE, 0, NULL, 0);
+    uart_tx_init(UART_PORT, UART_TX_BUFFER_SIZE);
     uart_param_config(UART_PORT, &uart_config);
-    uart_set_pin(UART_PORT, TXD_PIN, RXD_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    uart_set_pin(UART_PORT, TXD_PIN, RXD_PIN, RS485_ENABLE ? RS485_DE_PIN : UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (RS485_ENABLE)
+    {
+        rs485_init(UART_PORT, UART_BUAD_RATE, RS485_ACK_ENABLE);
+    }
     ESP_LOGI("UART", "UART %d initialized ok, TXD_PIN = %d, RXD_PIN = %d", UART_PORT, TXD_PIN, RXD_PIN);
 }
 
+#if CONFIG_IDF_TARGET_LINUX
+// Linux 仿真: 测量本配置的流水线耗时, 从输入报告 (keyboard_input_report) 到取出发往传输层的字节
+// (tx_queue_drain, FEC 模式含编码), 不含 UART 写入与 RS-485/可靠传输的协议处理.
+// 设置 SIM_BENCH 时在其他基准之前运行, SIM_BENCH=pipeline 时只运行这一项, 见 tools/pipeline_report.sh:
+#define PIPELINE_BENCH_REPORTS 200000
+
+static uint64_t pipeline_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void pipeline_bench(void)
+{
+    static const char *modes[] = {"ascii", "midi", "binary", "table", "baudot"};
+    static const struct
+    {
+        bool enabled;
+        const char *name;
+    } stages[] = {{NKRO_ENABLE, "nkro"},       {HID_BATCH_ENABLE, "hid_batch"}, {RATE_LIMIT_ENABLE, "rate_limit"},
+                  {MATRIX_ENABLE, "matrix"},   {RS485_ENABLE, "rs485"},         {RS485_ACK_ENABLE, "rs485_ack"},
+                  {CHAIN_ENABLE, "chain"},     {FEC_ENABLE, "fec"},             {STATE_STREAM_ENABLE, "state_stream"},
+                  {CMD_ENABLE, "cmd"},         {RELIABLE_ENABLE, "reliable"},   {TABLE_UPLOAD_ENABLE, "table_upload"},
+                  {MEM_STATS_ENABLE, "mem_stats"}};
+    char names[160] = "";
+    for (size_t i = 0; i < sizeof(stages) / sizeof(stages[0]); i++)
+    {
+        if (stages[i].enabled)
+        {
+            strcat(names, names[0] ? "," : "");
+            strcat(names, stages[i].name);
+        }
+    }
+
+    // 第一个槽位作为 Boot 键盘在线, handle 只用于表示在线:
+    keyboard_t *kbd = &keyboards[0];
+    kbd->handle = (hid_host_device_handle_t)kbd;
+    kbd->layout = hid_boot_layout;
+    if (RATE_LIMIT_ENABLE)
+    {
+        rate_limit_init(&kbd->limit, &rate_limit_config, 0);
+    }
+    event_queue_t *queues[KEYBOARD_SLOTS];
+    bool active[KEYBOARD_SLOTS] = {true};
+    for (int i = 0; i < KEYBOARD_SLOTS; i++)
+    {
+        queues[i] = &keyboards[i].queue;
+    }
+    esp_log_level_set("*", ESP_LOG_ERROR);
+
+    // 交替按下与释放, 输入时间每份报告前进 10 ms, 限速按正常打字处理:
+    uint8_t report[8] = {0};
+    uint8_t out[256];
+    key_event_t merged[TX_BATCH_SIZE];
+    uint64_t total_ns = 0;
+    uint64_t max_ns = 0;
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < PIPELINE_BENCH_REPORTS; i++)
+    {
+        report[0] = (i / 2) % 7 == 0 ? 0x02 : 0;
+        report[2] = i % 2 == 0 ? (uint8_t)(0x04 + (i / 2) % 26) : 0;
+        uint64_t start = pipeline_now_ns();
+        keyboard_input_report(kbd, report, sizeof(report), i * 10000);
+        uint32_t now_us = (uint32_t)esp_timer_get_time();
+        size_t count;
+        while ((count = event_merge(queues, active, KEYBOARD_SLOTS, now_us, REORDER_WINDOW_MS * 1000, merged,
+                                    TX_BATCH_SIZE)) > 0)
+        {
+            queue_events(merged, count, now_us);
+        }
+        size_t len = tx_queue_drain(out, sizeof(out), now_us);
+        if (FEC_ENABLE && len > 0)
+        {
+            len = fec_encode_frames(out, len, fec_out);
+        }
+        uint64_t ns = pipeline_now_ns() - start;
+        total_ns += ns;
+        max_ns = ns > max_ns ? ns : max_ns;
+        bytes += len;
+    }
+
+    esp_log_level_set("*", ESP_LOG_INFO);
+    memset(kbd->prev_keys, 0, sizeof(kbd->prev_keys));
+    kbd->prev_mod = 0;
+    kbd->handle = NULL;
+    printf("BENCH pipeline: output %s, stages %s: %.1f ns/report (max %.1f us), %" PRIu64 " bytes to transport\n",
+           modes[OUTPUT_MODE], names[0] ? names : "none", (double)total_ns / PIPELINE_BENCH_REPORTS, max_ns / 1000.0,
+           bytes);
+    if (strcmp(getenv("SIM_BENCH"), "pipeline") == 0)
+    {
+        exit(0);
+    }
+}
+#endif
+
 void app_main(void)
 {
     ESP_LOGW("App", "Start USB keyboard to serial...");
@@ -209,22 +1483,123 @@ void app_main(void)
 
     // 初始化串口
     init_uart();
+    keymap_init();
+    if (OUTPUT_MODE == OUTPUT_MODE_MIDI)
+    {
+        midi_out_init();
+    }
+    if (OUTPUT_MODE == OUTPUT_MODE_TABLE || TABLE_UPLOAD_ENABLE)
+    {
+        table_store_init();
+    }
+    if (OUTPUT_MODE == OUTPUT_MODE_TABLE)
+    {
+        load_encoder();
+    }
+    if (FEC_ENABLE)
+    {
+        fec_init(FEC_INTERLEAVE);
+    }
+    if (OUTPUT_MODE == OUTPUT_MODE_BAUDOT)
+    {
+        const ita2_config_t ita2_config = {
+            .baud = BAUDOT_BAUD,
+            .us_tty = BAUDOT_US_TTY,
+            .usos = BAUDOT_USOS,
+            .reorder_us = BAUDOT_REORDER_MS * 1000,
+            .resync_us = BAUDOT_RESYNC_MS * 1000,
+            .tick_us = TIMER_INTERVAL_MS * 1000};
+        ita2_init(&ita2_config);
+    }
+    if (STATE_STREAM_ENABLE)
+    {
+        state_init(STATE_KEYFRAME_INTERVAL_MS, STATE_KEYFRAME_MAX_PERCENT, UART_BUAD_RATE / 10);
+    }
+
+#if CONFIG_IDF_TARGET_LINUX
+    // Linux 仿真: 可选运行基准测试, 然后创建 uhid 虚拟键盘并接管 USB Host mock:
+    if (getenv("SIM_BENCH") != NULL)
+    {
+        pipeline_bench();
+    }
+    sim_bench_run();
+    sim_uhid_start();
+    if (RS485_ENABLE)
+    {
+        sim_rs485_start(UART_PORT, RS485_ACK_ENABLE);
+    }
+#endif
 
     // 初始化 USB Host 栈:
     const usb_host_config_t host_config = {.intr_flags = ESP_INTR_FLAG_LEVEL1};
+    // USB Host 库内部的分配无法逐个统计, 按安装前后的空闲内存差记入 USB:
+    size_t heap_before = mem_heap_free();
     usb_host_install(&host_config);
+    mem_account(MEM_TAG_USB, (int32_t)(heap_before - mem_heap_free()));
 
     // 初始化 USB Host:
     const hid_host_driver_config_t hid_config = {
-        .create_background_task = true,
-        .stack_size = 4096,
-        .task_priority = 10,
+        .create_background_task = false,            // 事件由 hid_events_task 处理
         .callback = hid_host_device_event_callback, // 必须注册这个监听连接事件
         .callback_arg = NULL};
     hid_host_install(&hid_config);
+    if (HID_BATCH_ENABLE)
+    {
+        hid_host_set_report_batch_callback(hid_report_batch_callback, NULL, HID_BATCH_THRESHOLD);
+    }
+    xTaskCreate(hid_events_task, "hid_events_task", 4096, NULL, 10, NULL);
 
-    // 创建重复发送任务:
-    xTaskCreate(uart_repeat_send_task, "uart_repeat_send_task", 4096, NULL, 10, NULL);
+    if (OUTPUT_MODE != OUTPUT_MODE_MIDI)
+    {
+        if (RELIABLE_ENABLE)
+        {
+            reliable_init(RELIABLE_WINDOW, RELIABLE_TIMEOUT_MS * 1000, RELIABLE_RETRIES);
+        }
+        // 创建重复发送任务:
+        xTaskCreate(uart_repeat_send_task, "uart_repeat_send_task", 4096, NULL, 10, &send_task);
+        if (CHAIN_ENABLE)
+        {
+            chain_start(UART_PORT, UART_BUAD_RATE, send_task);
+        }
+        if (CMD_ENABLE)
+        {
+            cmd_register(FRAME_TYPE_QUERY, cmd_query);
+            if (RELIABLE_ENABLE)
+            {
+                cmd_register(FRAME_TYPE_RELIABLE_ACK, cmd_reliable_ack);
+            }
+            if (TABLE_UPLOAD_ENABLE)
+            {
+                table_store_start(table_committed, send_task);
+                cmd_register(FRAME_TYPE_UPLOAD, table_upload_queue);
+            }
+            cmd_start(UART_PORT);
+        }
+    }
+
+    if (MATRIX_ENABLE)
+    {
+        // 矩阵占用最后一个槽位, handle 只用于表示在线, 指向矩阵本身, 不会传给 HID 驱动:
+        static const int row_pins[] = MATRIX_ROW_PINS;
+        static const int col_pins[] = MATRIX_COL_PINS;
+        static const uint8_t keymap[] = MATRIX_KEYMAP;
+        _Static_assert(sizeof(keymap) == sizeof(row_pins) / sizeof(int) * (sizeof(col_pins) / sizeof(int)),
+                       "MATRIX_KEYMAP must have rows * cols entries");
+        const matrix_config_t matrix_config = {
+            .row_pins = row_pins,
+            .col_pins = col_pins,
+            .rows = sizeof(row_pins) / sizeof(int),
+            .cols = sizeof(col_pins) / sizeof(int),
+            .keymap = keymap,
+            .scan_hz = MATRIX_SCAN_HZ,
+            .debounce_ms = MATRIX_DEBOUNCE_MS,
+            .max_keys = KEYBOARD_MAX_KEYS};
+        keyboard_t *kbd = &keyboards[KEYBOARD_SLOTS - 1];
+        kbd->handle = (hid_host_device_handle_t)&matrix;
+        kbd->layout = hid_boot_layout;
+        matrix_init(&matrix, &matrix_config, hid_host_keyboard_report_callback, kbd);
+        matrix_start(&matrix);
+    }
 
     ESP_LOGW("App", "System ready, waiting for USB keyboard events...");
 
@@ -0,0 +1,66 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdbool.h>
+#include "keymap.h"
+
+// 批量转换查找表: [修饰键类别][键码], 类别 bit0 = Ctrl, bit1 = Shift
+static char s_ascii_lut[4][256];
+
+// 将 USB HID 键码转换为 ASCII 字符:
+char usb_keycode_to_ascii(uint8_t key_code, uint8_t modifier)
+{
+    // 映射表 (索引 0 对应 Keycode 0x04)
+    // 注意：\\ 是反斜杠，\" 是双引号
+    // 位置：A-Z, 1-0, Enter, Esc, Backspace, Tab, Space, - = [ ] \ (non) ; ' ` , . /
+    const static char *lut_shift = "ABCDEFGHIJKLMNOPQRSTUVWXYZ!@#$%^&*()\n\x1B\b\t _+{}| :\"~<>?";
+    const static char *lut_plain = "abcdefghijklmnopqrstuvwxyz1234567890\n\x1B\b\t -=[]\\ ;'`,./";
+
+    // 基础偏移量：HID 键码是从 0x04 (字母A) 开始的
+    if (key_code < 0x04 || key_code > 0x38)
+    {
+        return 0;
+    }
+
+    bool shift = (modifier & 0x02) || (modifier & 0x20);
+    bool ctrl = (modifier & 0x01) || (modifier & 0x10);
+
+    // 索引计算:
+    uint8_t idx = key_code - 0x04;
+
+    // 处理 Ctrl 组合键 (仅针对 A-Z):
+    if (ctrl && idx <= 25)
+    {
+        return idx + 1; // Ctrl+A = 0x01 ...
+    }
+
+    // 返回对应的 ASCII:
+    return shift ? lut_shift[idx] : lut_plain[idx];
+}
+
+void keymap_init(void)
+{
+    // 左右 Ctrl / Shift 合并后只有 4 种组合, 用单键转换结果填表保证与逐个转换一致:
+    for (int cls = 0; cls < 4; cls++)
+    {
+        for (int key = 0; key < 256; key++)
+        {
+            s_ascii_lut[cls][key] = usb_keycode_to_ascii((uint8_t)key, (uint8_t)cls);
+        }
+    }
+}
+
+size_t usb_keycode_to_ascii_bulk(const key_input_t *keys, size_t count, char *out)
+{
+    // ESP32-S3 PIE 没有按字节查表 (gather/shuffle) 指令, 这种不规则映射无法向量化,
+    // 因此各平台统一使用无分支查表: 每个按键一次查表, 结果总是写入, 只有非 0 时输出指针才前进.
+    size_t n = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t mod = keys[i].modifier;
+        char c = s_ascii_lut[(mod | (mod >> 4)) & 0x03][keys[i].key_code];
+        out[n] = c;
+        n += (c != 0);
+    }
+    return n;
+}
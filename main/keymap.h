@@ -0,0 +1,24 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// 一次按键输入: 键码 + 修饰键
+typedef struct
+{
+    uint8_t key_code;
+    uint8_t modifier;
+} key_input_t;
+
+// 构建批量转换查找表, 必须在 usb_keycode_to_ascii_bulk() 之前调用:
+void keymap_init(void);
+
+// 将 USB HID 键码转换为 ASCII 字符, 无对应字符返回 0:
+char usb_keycode_to_ascii(uint8_t key_code, uint8_t modifier);
+
+// 批量转换 count 个按键, 结果直接写入 out (至少 count 字节),
+// 无对应字符的按键被跳过, 返回写入的字节数:
+size_t usb_keycode_to_ascii_bulk(const key_input_t *keys, size_t count, char *out);
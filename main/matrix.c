@@ -0,0 +1,212 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "matrix.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#endif
+
+#define KEY_MOD_FIRST 0xE0
+
+void matrix_init(matrix_t *m, const matrix_config_t *config, matrix_report_cb_t cb, void *arg)
+{
+    memset(m, 0, sizeof(*m));
+    m->config = *config;
+    m->cb = cb;
+    m->arg = arg;
+    // 去抖时间换算为扫描次数, 向上取整, 至少 1 次:
+    uint32_t scans = (config->debounce_ms * config->scan_hz + 999) / 1000;
+    m->debounce_scans = (uint8_t)(scans < 1 ? 1 : scans > 255 ? 255 : scans);
+    if (m->config.max_keys > MATRIX_MAX_ROWS * MATRIX_MAX_COLS)
+    {
+        m->config.max_keys = MATRIX_MAX_ROWS * MATRIX_MAX_COLS;
+    }
+}
+
+bool matrix_scan(matrix_t *m, const uint16_t *raw)
+{
+    bool changed = false;
+    m->stats.scans++;
+    for (int r = 0; r < m->config.rows; r++)
+    {
+        uint16_t diff = raw[r] ^ m->stable[r];
+        // 计数中途读回稳定值, 是抖动, 计数清零:
+        uint16_t bounced = m->pending[r] & ~diff;
+        while (bounced)
+        {
+            int c = __builtin_ctz(bounced);
+            m->count[r][c] = 0;
+            m->stats.chatter++;
+            bounced &= bounced - 1;
+        }
+        m->pending[r] = diff;
+        // 通常没有键在变化, 只遍历不同的位:
+        while (diff)
+        {
+            int c = __builtin_ctz(diff);
+            diff &= diff - 1;
+            if (++m->count[r][c] < m->debounce_scans)
+            {
+                continue;
+            }
+            if (!changed)
+            {
+                seqlock_write_begin(&m->lock);
+                changed = true;
+            }
+            m->stable[r] ^= (uint16_t)(1 << c);
+            m->pending[r] &= (uint16_t)~(1 << c);
+            m->count[r][c] = 0;
+        }
+    }
+    if (changed)
+    {
+        seqlock_write_end(&m->lock);
+        m->stats.changes++;
+    }
+    return changed;
+}
+
+size_t matrix_report(matrix_t *m, uint8_t *out, size_t out_max)
+{
+    uint16_t stable[MATRIX_MAX_ROWS];
+    uint32_t seq;
+    // 写者是扫描中断, 写入很短, 不会在读者重试期间长时间占用:
+    do
+    {
+        seq = seqlock_read_begin(&m->lock);
+        memcpy(stable, m->stable, sizeof(stable));
+    } while (seqlock_read_retry(&m->lock, seq));
+
+    size_t n = 2;
+    uint8_t modifier = 0;
+    for (int r = 0; r < m->config.rows; r++)
+    {
+        for (uint16_t bits = stable[r]; bits; bits &= bits - 1)
+        {
+            uint8_t key = m->config.keymap[r * m->config.cols + __builtin_ctz(bits)];
+            if (key >= KEY_MOD_FIRST && key < KEY_MOD_FIRST + 8)
+            {
+                modifier |= (uint8_t)(1 << (key - KEY_MOD_FIRST));
+            }
+            else if (key != 0 && n < out_max)
+            {
+                out[n++] = key;
+            }
+            else if (key != 0)
+            {
+                m->stats.rollover++;
+            }
+        }
+    }
+    out[0] = modifier;
+    out[1] = 0;
+    return n;
+}
+
+void matrix_log_stats(const matrix_t *m)
+{
+    ESP_LOGI("MATRIX", "scans=%" PRIu32 " changes=%" PRIu32 " chatter=%" PRIu32 " rollover=%" PRIu32
+                       " scan_max_us=%" PRIu32,
+             m->stats.scans, m->stats.changes, m->stats.chatter, m->stats.rollover, m->stats.scan_max_us);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+
+static TaskHandle_t s_report_task = NULL;
+
+// 定时器中断: 逐行拉低读取列线, 去抖后有变化时唤醒报告任务:
+static bool matrix_timer_isr(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg)
+{
+    matrix_t *m = (matrix_t *)arg;
+    int64_t start = esp_timer_get_time();
+    uint16_t raw[MATRIX_MAX_ROWS] = {0};
+    for (int r = 0; r < m->config.rows; r++)
+    {
+        gpio_set_level(m->config.row_pins[r], 0);
+        esp_rom_delay_us(MATRIX_SETTLE_US);
+        for (int c = 0; c < m->config.cols; c++)
+        {
+            raw[r] |= (uint16_t)(!gpio_get_level(m->config.col_pins[c]) << c);
+        }
+        gpio_set_level(m->config.row_pins[r], 1);
+    }
+    bool changed = matrix_scan(m, raw);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    if (elapsed > m->stats.scan_max_us)
+    {
+        m->stats.scan_max_us = elapsed;
+    }
+    BaseType_t woken = pdFALSE;
+    if (changed)
+    {
+        m->changed_us = (uint32_t)start;
+        vTaskNotifyGiveFromISR(s_report_task, &woken);
+    }
+    return woken == pdTRUE;
+}
+
+// 报告任务: 连续多次变化只生成一份最新状态的报告, 去抖时间远大于任务唤醒延迟, 不会丢失按键:
+static void matrix_report_task(void *arg)
+{
+    matrix_t *m = (matrix_t *)arg;
+    uint8_t report[2 + MATRIX_MAX_ROWS * MATRIX_MAX_COLS];
+    size_t report_max = 2 + (size_t)m->config.max_keys;
+    while (1)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        uint32_t changed_us = m->changed_us;
+        m->cb(report, matrix_report(m, report, report_max), changed_us, m->arg);
+    }
+}
+
+void matrix_start(matrix_t *m)
+{
+    for (int r = 0; r < m->config.rows; r++)
+    {
+        gpio_reset_pin(m->config.row_pins[r]);
+        gpio_set_direction(m->config.row_pins[r], GPIO_MODE_OUTPUT);
+        gpio_set_level(m->config.row_pins[r], 1);
+    }
+    for (int c = 0; c < m->config.cols; c++)
+    {
+        gpio_reset_pin(m->config.col_pins[c]);
+        gpio_set_direction(m->config.col_pins[c], GPIO_MODE_INPUT);
+        gpio_set_pull_mode(m->config.col_pins[c], GPIO_PULLUP_ONLY);
+    }
+    // 优先级与 HID 任务相同, 报告回调与 USB 键盘的处理代价相当:
+    xTaskCreate(matrix_report_task, "matrix_report_task", 4096, m, 10, &s_report_task);
+
+    gptimer_handle_t timer = NULL;
+    const gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = 1000000};
+    if (gptimer_new_timer(&timer_config, &timer) != ESP_OK)
+    {
+        ESP_LOGE("MATRIX", "No free hardware timer, matrix disabled");
+        return;
+    }
+    const gptimer_event_callbacks_t callbacks = {.on_alarm = matrix_timer_isr};
+    gptimer_register_event_callbacks(timer, &callbacks, m);
+    const gptimer_alarm_config_t alarm_config = {
+        .alarm_count = 1000000 / m->config.scan_hz,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true};
+    gptimer_set_alarm_action(timer, &alarm_config);
+    gptimer_enable(timer);
+    gptimer_start(timer);
+    ESP_LOGI("MATRIX", "Scanning %dx%d matrix at %" PRIu32 " Hz, debounce %" PRIu32 " ms (%d scans)",
+             m->config.rows, m->config.cols, m->config.scan_hz, m->config.debounce_ms, m->debounce_scans);
+}
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "seqlock.h"
+
+// GPIO 按键矩阵: 硬件定时器中断逐行拉低行线并读取列线, 每个键独立去抖,
+// 稳定状态变化时通知报告任务. 报告任务把稳定状态转换为 Boot 格式报告 (修饰键, 0, 键码...),
+// 交给与 USB 键盘相同的报告回调, 因此事件、状态、编码与按住重复的处理完全一致.
+//
+// 接线: 行为推挽输出, 空闲为高; 列为上拉输入; 每个键串一个二极管, 由列指向行.
+// 去抖: 原始读数与稳定状态不同并连续保持 debounce_ms 才改变稳定状态, 期间读回原值则重新计数,
+// 按下与释放都延迟 debounce_ms, 但抖动不会产生多余的事件.
+
+#define MATRIX_MAX_ROWS 8
+#define MATRIX_MAX_COLS 16
+#define MATRIX_SETTLE_US 2 // 拉低行线后等待列线稳定的时间
+
+// 报告回调, 在报告任务中调用. ts_us 是扫描到最近一次稳定状态变化的时间 (esp_timer_get_time()):
+typedef void (*matrix_report_cb_t)(const uint8_t *report, size_t report_len, uint32_t ts_us, void *arg);
+
+typedef struct
+{
+    const int *row_pins;
+    const int *col_pins;
+    uint8_t rows;
+    uint8_t cols;
+    const uint8_t *keymap;  // rows * cols 个键码, 按行排列, 0 表示没有键; 0xE0 ~ 0xE7 为修饰键
+    uint32_t scan_hz;       // 整个矩阵每秒扫描的次数
+    uint32_t debounce_ms;
+    uint8_t max_keys;       // 报告最多的同时按键数, 与 USB 键盘相同
+} matrix_config_t;
+
+typedef struct
+{
+    uint32_t scans;
+    uint32_t changes;   // 稳定状态变化的次数
+    uint32_t chatter;   // 未达到去抖时间就恢复的抖动
+    uint32_t rollover;  // 报告装不下而被忽略的按键
+    uint32_t scan_max_us;
+} matrix_stats_t;
+
+typedef struct
+{
+    matrix_config_t config;
+    uint8_t debounce_scans;
+    uint16_t stable[MATRIX_MAX_ROWS];  // 去抖后的状态, 按下为 1, 扫描者是唯一的写者
+    uint16_t pending[MATRIX_MAX_ROWS]; // 正在计数的键
+    uint8_t count[MATRIX_MAX_ROWS][MATRIX_MAX_COLS];
+    seqlock_t lock;
+    volatile uint32_t changed_us; // 扫描中断记录, 报告任务唤醒前可能已经过了若干毫秒
+    matrix_report_cb_t cb;
+    void *arg;
+    matrix_stats_t stats;
+} matrix_t;
+
+void matrix_init(matrix_t *m, const matrix_config_t *config, matrix_report_cb_t cb, void *arg);
+
+// 输入一次扫描的原始读数 (每行一个列位图, 按下为 1), 更新去抖状态.
+// 稳定状态变化时返回 true. 可以在中断中调用:
+bool matrix_scan(matrix_t *m, const uint16_t *raw);
+
+// 由稳定状态生成 Boot 格式报告写入 out, 返回长度 (至少 2).
+// 按行列顺序取键, 超过 out_max 的键忽略:
+size_t matrix_report(matrix_t *m, uint8_t *out, size_t out_max);
+
+// 配置 GPIO 与定时器并开始扫描, 创建报告任务. Linux 仿真由 sim_matrix.c 实现:
+void matrix_start(matrix_t *m);
+
+void matrix_log_stats(const matrix_t *m);
@@ -0,0 +1,208 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "esp_log.h"
+#include "mem_stats.h"
+#if CONFIG_IDF_TARGET_LINUX
+#include <malloc.h>
+#else
+#include "esp_heap_caps.h"
+#endif
+
+// mem_malloc() 的块头部, 8 字节保持返回指针的对齐:
+typedef struct
+{
+    uint32_t size;
+    uint32_t tag;
+} mem_header_t;
+
+static hid_host_mem_usage_t usage[MEM_TAG_COUNT]; // 本模块记录的部分, 原子更新
+static uint32_t trend[MEM_TREND_SAMPLES];          // 最近几次采样的最大空闲块
+static uint32_t trend_count = 0;
+static uint32_t largest_min = UINT32_MAX;
+
+static void account_alloc(hid_host_mem_usage_t *u, size_t size)
+{
+    size_t current = __atomic_add_fetch(&u->current, size, __ATOMIC_RELAXED);
+    size_t peak = __atomic_load_n(&u->peak, __ATOMIC_RELAXED);
+    while (current > peak && !__atomic_compare_exchange_n(&u->peak, &peak, current, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+    __atomic_add_fetch(&u->allocs, 1, __ATOMIC_RELAXED);
+}
+
+static void account_free(hid_host_mem_usage_t *u, size_t size)
+{
+    __atomic_sub_fetch(&u->current, size, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&u->frees, 1, __ATOMIC_RELAXED);
+}
+
+void *mem_malloc(mem_tag_t tag, size_t size)
+{
+    mem_header_t *header = malloc(sizeof(mem_header_t) + size);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+    header->size = (uint32_t)size;
+    header->tag = tag;
+    account_alloc(&usage[tag], size);
+    return header + 1;
+}
+
+void *mem_calloc(mem_tag_t tag, size_t count, size_t size)
+{
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+    void *ptr = mem_malloc(tag, count * size);
+    if (ptr != NULL)
+    {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void mem_free(void *ptr)
+{
+    if (ptr == NULL)
+    {
+        return;
+    }
+    mem_header_t *header = (mem_header_t *)ptr - 1;
+    account_free(&usage[header->tag], header->size);
+    free(header);
+}
+
+void mem_account(mem_tag_t tag, int32_t bytes)
+{
+    if (bytes >= 0)
+    {
+        account_alloc(&usage[tag], (size_t)bytes);
+    }
+    else
+    {
+        account_free(&usage[tag], (size_t)-bytes);
+    }
+}
+
+#if CONFIG_IDF_TARGET_LINUX
+// Linux 仿真: glibc 分配器的空闲字节数, 最大空闲块取堆顶可以归还系统的连续空间:
+static uint32_t free_min = UINT32_MAX;
+
+size_t mem_heap_free(void)
+{
+    return mallinfo2().fordblks;
+}
+
+static void heap_read(mem_report_t *report)
+{
+    struct mallinfo2 info = mallinfo2();
+    report->heap_free = (uint32_t)info.fordblks;
+    report->largest_free = (uint32_t)info.keepcost;
+    free_min = report->heap_free < free_min ? report->heap_free : free_min;
+    report->heap_min_free = free_min;
+}
+#else
+size_t mem_heap_free(void)
+{
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+static void heap_read(mem_report_t *report)
+{
+    report->heap_free = (uint32_t)heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    report->heap_min_free = (uint32_t)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    // 遍历所有空闲块, 只在采样时调用:
+    report->largest_free = (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+#endif
+
+static void usage_read(const hid_host_mem_usage_t *src, hid_host_mem_usage_t *dst)
+{
+    dst->current += __atomic_load_n(&src->current, __ATOMIC_RELAXED);
+    dst->peak += __atomic_load_n(&src->peak, __ATOMIC_RELAXED);
+    dst->allocs += __atomic_load_n(&src->allocs, __ATOMIC_RELAXED);
+    dst->frees += __atomic_load_n(&src->frees, __ATOMIC_RELAXED);
+}
+
+void mem_stats_sample(mem_report_t *report)
+{
+    memset(report, 0, sizeof(*report));
+    for (int i = 0; i < MEM_TAG_COUNT; i++)
+    {
+        usage_read(&usage[i], &report->tags[i]);
+    }
+    // HID 驱动的计数合并到对应的子系统. 峰值为各部分峰值之和, USB Host 库的部分安装后不变:
+    hid_host_mem_stats_t hid;
+    if (hid_host_get_mem_stats(&hid) == ESP_OK)
+    {
+        usage_read(&hid.usb, &report->tags[MEM_TAG_USB]);
+        usage_read(&hid.driver, &report->tags[MEM_TAG_HID]);
+        report->hid_devices = hid.devices;
+        report->hid_device_max = (uint32_t)hid.device_max_bytes;
+        report->hid_device_sum = (uint32_t)hid.device_bytes;
+        report->hid_ep0 = (uint32_t)hid.ep0_bytes;
+    }
+    heap_read(report);
+    report->largest_oldest = trend_count < MEM_TREND_SAMPLES ? (trend_count ? trend[0] : report->largest_free)
+                                                             : trend[trend_count % MEM_TREND_SAMPLES];
+    trend[trend_count % MEM_TREND_SAMPLES] = report->largest_free;
+    trend_count++;
+    largest_min = report->largest_free < largest_min ? report->largest_free : largest_min;
+    report->largest_min = largest_min;
+}
+
+static uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = (v >> 8) & 0xFF;
+    p[2] = (v >> 16) & 0xFF;
+    p[3] = v >> 24;
+    return p + 4;
+}
+
+size_t mem_stats_encode(uint8_t *out)
+{
+    mem_report_t report;
+    mem_stats_sample(&report);
+    uint8_t payload[FRAME_MEMORY_PAYLOAD_LEN];
+    uint8_t *p = payload;
+    for (int i = 0; i < MEM_TAG_COUNT; i++)
+    {
+        p = put_u32(p, (uint32_t)report.tags[i].current);
+        p = put_u32(p, (uint32_t)report.tags[i].peak);
+        p = put_u32(p, report.tags[i].allocs);
+        p = put_u32(p, report.tags[i].frees);
+    }
+    p = put_u32(p, report.heap_free);
+    p = put_u32(p, report.heap_min_free);
+    put_u32(p, report.largest_free);
+    return frame_encode(FRAME_TYPE_MEMORY, payload, sizeof(payload), out);
+}
+
+void mem_stats_log(void)
+{
+    static const char *names[MEM_TAG_COUNT] = {"usb", "hid", "app"};
+    mem_report_t report;
+    mem_stats_sample(&report);
+    for (int i = 0; i < MEM_TAG_COUNT; i++)
+    {
+        const hid_host_mem_usage_t *u = &report.tags[i];
+        ESP_LOGI("MEM", "%s: %u bytes (peak %u) in %" PRIu32 " blocks, allocs=%" PRIu32 " frees=%" PRIu32,
+                 names[i], (unsigned)u->current, (unsigned)u->peak, u->allocs - u->frees, u->allocs, u->frees);
+    }
+    ESP_LOGI("MEM", "hid: %" PRIu32 " devices, %" PRIu32 " bytes per device (max %" PRIu32 "), shared EP0 %" PRIu32 " bytes",
+             report.hid_devices, report.hid_devices ? report.hid_device_sum / report.hid_devices : 0,
+             report.hid_device_max, report.hid_ep0);
+    ESP_LOGI("MEM", "heap: free=%" PRIu32 " min=%" PRIu32 " largest block=%" PRIu32 " (%" PRIu32 " samples ago %" PRIu32
+                    ", lowest %" PRIu32 "), fragmentation %" PRIu32 "%%",
+             report.heap_free, report.heap_min_free, report.largest_free,
+             trend_count > MEM_TREND_SAMPLES ? (uint32_t)MEM_TREND_SAMPLES : trend_count - 1, report.largest_oldest,
+             report.largest_min, report.heap_free ? 100 - (uint32_t)((uint64_t)report.largest_free * 100 / report.heap_free) : 0);
+}
@@ -0,0 +1,67 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "usb/hid_host_mem.h"
+#include "frame.h"
+
+// 堆内存统计: 按子系统记录当前字节数、峰值、分配与释放次数, 并跟踪最大空闲块的变化, 用于发现
+// 长期热插拔后的泄漏与碎片.
+//   MEM_TAG_USB: USB Host 库安装时占用的内存, 以及 HID 驱动向它申请的传输 (EP0 控制与中断 IN);
+//   MEM_TAG_HID: HID 驱动的设备与接口结构、信号量、报告描述符, 由驱动自己统计 (见 usb/hid_host_mem.h),
+//                驱动同时报告每个设备的用量与所有设备共享的 EP0 控制传输;
+//   MEM_TAG_APP: 应用通过 mem_malloc() 等申请的内存 (编码表、定义文本等).
+// 计数在分配与释放时原子更新, 开销只有几条指令; 空闲内存与最大空闲块需要遍历堆,
+// 只在 mem_stats_sample() 中读取 (统计日志周期或收到查询时).
+//
+// FRAME_TYPE_MEMORY 负载 (60 字节, 全部 u32 LE):
+//   每个子系统 (USB, HID, APP): [当前字节数] [峰值] [分配次数] [释放次数]
+//   [空闲字节数] [开机以来最少空闲字节数] [最大空闲块]
+
+typedef enum
+{
+    MEM_TAG_USB,
+    MEM_TAG_HID,
+    MEM_TAG_APP,
+    MEM_TAG_COUNT,
+} mem_tag_t;
+
+#define MEM_TREND_SAMPLES 6 // 最大空闲块保留的采样数, 统计日志每 10 秒一次时为 1 分钟
+#define FRAME_MEMORY_PAYLOAD_LEN (MEM_TAG_COUNT * 16 + 12)
+#define FRAME_MEMORY_LEN (FRAME_OVERHEAD + FRAME_MEMORY_PAYLOAD_LEN)
+
+typedef struct
+{
+    hid_host_mem_usage_t tags[MEM_TAG_COUNT];
+    uint32_t heap_free;      // 当前空闲字节数
+    uint32_t heap_min_free;  // 开机以来最少空闲字节数
+    uint32_t largest_free;   // 当前最大空闲块
+    uint32_t largest_oldest; // MEM_TREND_SAMPLES 次采样之前的最大空闲块, 与当前值对比即为趋势
+    uint32_t largest_min;    // 采样到的最小的最大空闲块
+    uint32_t hid_devices;    // 已连接的 HID 设备
+    uint32_t hid_device_sum; // 所有设备的驱动内存 (结构、报告描述符、中断 IN 传输)
+    uint32_t hid_device_max; // 占用最多的设备的驱动内存
+    uint32_t hid_ep0;        // 所有设备共享的 EP0 控制传输与信号量
+} mem_report_t;
+
+// 带统计的分配与释放, 块前有 8 字节的头部记录子系统与大小:
+void *mem_malloc(mem_tag_t tag, size_t size);
+void *mem_calloc(mem_tag_t tag, size_t count, size_t size);
+void mem_free(void *ptr);
+
+// 记录不经过 mem_malloc() 的内存, bytes 为负数表示释放, 例如 USB Host 库安装前后的空闲内存差:
+void mem_account(mem_tag_t tag, int32_t bytes);
+
+// 当前空闲字节数, 不遍历堆:
+size_t mem_heap_free(void);
+
+// 汇总各子系统的计数并读取堆状态, 同时记录最大空闲块的趋势:
+void mem_stats_sample(mem_report_t *report);
+
+// 采样并编码为 FRAME_TYPE_MEMORY 帧 (FRAME_MEMORY_LEN 字节), 返回帧长度:
+size_t mem_stats_encode(uint8_t *out);
+
+void mem_stats_log(void);
@@ -0,0 +1,114 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include "midi_out.h"
+
+// --- MIDI 配置 ---
+#define MIDI_CHANNEL 0                 // MIDI 通道 (0~15)
+#define MIDI_VELOCITY 100              // Note On 力度
+#define MIDI_NOTE_OFF_AS_ZERO_VELOCITY 1 // 用力度为 0 的 Note On 表示释放, 与按下共用运行状态
+#define MIDI_STATUS_REFRESH_MS 1000    // 运行状态最长保持时间, 超时重发状态字节, 便于中途接入的接收端同步
+#define MIDI_LOWER_ROW_NOTE 48         // Z 键对应的音符 (C3)
+#define MIDI_UPPER_ROW_NOTE 60         // Q 键对应的音符 (C4)
+
+#define MIDI_STATUS_NOTE_OFF 0x80
+#define MIDI_STATUS_NOTE_ON 0x90
+
+static uint8_t key_note[256];    // 键码 -> 音符
+static uint8_t active_note[MIDI_MAX_DEVICES][256]; // 各键盘按下时实际发出的音符 (含八度偏移), 释放时使用
+static uint8_t note_holds[128];                     // 按住每个音符的键数, 降为 0 时才发出 Note Off
+static uint8_t running_status = 0;
+static uint32_t running_status_ms = 0;
+
+void midi_out_init(void)
+{
+    // Tracker 布局: 下排 Z S X D C V G B H N J M , 与上排 Q 2 W 3 E R 5 T 6 Y 7 U I 9 O 0 P
+    // 分别为两个八度的半音阶, 黑键位于上一排:
+    static const uint8_t lower_row[] = {0x1D, 0x16, 0x1B, 0x07, 0x06, 0x19, 0x0A, 0x05, 0x0B, 0x11, 0x0D, 0x10, 0x36};
+    static const uint8_t upper_row[] = {0x14, 0x1F, 0x1A, 0x20, 0x08, 0x15, 0x22, 0x17, 0x23, 0x1C, 0x24, 0x18, 0x0C,
+                                        0x26, 0x12, 0x27, 0x13};
+    memset(key_note, MIDI_NOTE_NONE, sizeof(key_note));
+    memset(active_note, MIDI_NOTE_NONE, sizeof(active_note));
+    memset(note_holds, 0, sizeof(note_holds));
+    for (size_t i = 0; i < sizeof(lower_row); i++)
+    {
+        key_note[lower_row[i]] = MIDI_LOWER_ROW_NOTE + i;
+    }
+    for (size_t i = 0; i < sizeof(upper_row); i++)
+    {
+        key_note[upper_row[i]] = MIDI_UPPER_ROW_NOTE + i;
+    }
+    running_status = 0;
+}
+
+void midi_set_key_note(uint8_t key_code, uint8_t note)
+{
+    key_note[key_code] = note > 127 ? MIDI_NOTE_NONE : note;
+}
+
+size_t midi_encode_key(uint8_t dev, uint8_t key_code, uint8_t modifier, bool pressed, uint32_t now_ms, uint8_t *out)
+{
+    uint8_t status;
+    uint8_t note;
+    uint8_t velocity;
+    if (pressed)
+    {
+        if (key_note[key_code] == MIDI_NOTE_NONE)
+        {
+            return 0;
+        }
+        // 八度偏移: Shift 升一个八度, Ctrl 降一个八度:
+        int shifted = key_note[key_code];
+        if (modifier & 0x22)
+        {
+            shifted += 12;
+        }
+        if (modifier & 0x11)
+        {
+            shifted -= 12;
+        }
+        if (shifted < 0 || shifted > 127)
+        {
+            return 0;
+        }
+        note = (uint8_t)shifted;
+        active_note[dev][key_code] = note;
+        note_holds[note]++;
+        status = MIDI_STATUS_NOTE_ON | MIDI_CHANNEL;
+        velocity = MIDI_VELOCITY;
+    }
+    else
+    {
+        // 释放时使用按下时的音符, 即使修饰键已经变化:
+        note = active_note[dev][key_code];
+        if (note == MIDI_NOTE_NONE)
+        {
+            return 0;
+        }
+        active_note[dev][key_code] = MIDI_NOTE_NONE;
+        // 其他键仍按住同一个音符:
+        if (--note_holds[note] > 0)
+        {
+            return 0;
+        }
+#if MIDI_NOTE_OFF_AS_ZERO_VELOCITY
+        status = MIDI_STATUS_NOTE_ON | MIDI_CHANNEL;
+        velocity = 0;
+#else
+        status = MIDI_STATUS_NOTE_OFF | MIDI_CHANNEL;
+        velocity = 64;
+#endif
+    }
+
+    size_t len = 0;
+    if (status != running_status || now_ms - running_status_ms >= MIDI_STATUS_REFRESH_MS)
+    {
+        out[len++] = status;
+        running_status = status;
+        running_status_ms = now_ms;
+    }
+    out[len++] = note;
+    out[len++] = velocity;
+    return len;
+}
@@ -0,0 +1,22 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MIDI_NOTE_NONE 0xFF // 键码未映射音符
+#define MIDI_MAX_DEVICES 8  // 分别记录每个键盘按住的音符
+
+// 加载默认键位-音符映射 (Tracker 布局), 清除运行状态:
+void midi_out_init(void);
+
+// 修改单个键码对应的音符, note 为 MIDI_NOTE_NONE 时取消映射:
+void midi_set_key_note(uint8_t key_code, uint8_t note);
+
+// 将键盘 dev (< MIDI_MAX_DEVICES) 的一次按下/释放编码为 MIDI 消息, 写入 out (至少 3 字节), 返回写入的字节数,
+// 未映射的键返回 0. 同一状态字节连续出现时使用运行状态省略.
+// 多个键盘 (或同一键盘的不同八度) 按住同一个音符时, 最后一个释放才发出 Note Off:
+size_t midi_encode_key(uint8_t dev, uint8_t key_code, uint8_t modifier, bool pressed, uint32_t now_ms, uint8_t *out);
@@ -0,0 +1,113 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include "sdkconfig.h"
+
+// 流水线阶段在 menuconfig 的 Keyboard Pipeline 菜单中选择 (main/Kconfig.projbuild), 这里转换为 0/1 常量.
+// keyboard_main.c 中各阶段都写成 if (X_ENABLE) 直接调用, 未选择的阶段连同对模块的引用被编译器整段删除,
+// 模块的源文件也不参与编译 (main/CMakeLists.txt); 选择的阶段直接调用, 不经过函数指针.
+
+#define OUTPUT_MODE_ASCII 0  // ASCII 字符, 按住重复发送
+#define OUTPUT_MODE_MIDI 1   // MIDI Note On/Off, 用于键盘演奏
+#define OUTPUT_MODE_BINARY 2 // 二进制事件帧 (按下/释放, 带全局序号), 见 frame.h
+#define OUTPUT_MODE_TABLE 3  // 按 NVS 中的编码表定义输出, 见 encoder.h
+#define OUTPUT_MODE_BAUDOT 4 // 5 位 Baudot (ITA2) 码, 驱动电传打字机, 见 ita2.h
+
+#if defined(CONFIG_PIPELINE_OUTPUT_MIDI)
+#define OUTPUT_MODE OUTPUT_MODE_MIDI
+#elif defined(CONFIG_PIPELINE_OUTPUT_BINARY)
+#define OUTPUT_MODE OUTPUT_MODE_BINARY
+#elif defined(CONFIG_PIPELINE_OUTPUT_TABLE)
+#define OUTPUT_MODE OUTPUT_MODE_TABLE
+#elif defined(CONFIG_PIPELINE_OUTPUT_BAUDOT)
+#define OUTPUT_MODE OUTPUT_MODE_BAUDOT
+#else
+#define OUTPUT_MODE OUTPUT_MODE_ASCII
+#endif
+
+#ifdef CONFIG_PIPELINE_NKRO
+#define NKRO_ENABLE 1
+#else
+#define NKRO_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_HID_BATCH
+#define HID_BATCH_ENABLE 1
+#else
+#define HID_BATCH_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_RATE_LIMIT
+#define RATE_LIMIT_ENABLE 1
+#else
+#define RATE_LIMIT_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_MATRIX
+#define MATRIX_ENABLE 1
+#else
+#define MATRIX_ENABLE 0
+#endif
+
+// 多设备事件重排窗口 (毫秒), 0 表示按回调顺序输出:
+#ifdef CONFIG_PIPELINE_REORDER_WINDOW_MS
+#define REORDER_WINDOW_MS CONFIG_PIPELINE_REORDER_WINDOW_MS
+#else
+#define REORDER_WINDOW_MS (MATRIX_ENABLE ? 10 : 0)
+#endif
+
+#ifdef CONFIG_PIPELINE_RS485
+#define RS485_ENABLE 1
+#else
+#define RS485_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_RS485_ACK
+#define RS485_ACK_ENABLE 1
+#else
+#define RS485_ACK_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_CHAIN
+#define CHAIN_ENABLE 1
+#else
+#define CHAIN_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_FEC
+#define FEC_ENABLE 1
+#else
+#define FEC_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_STATE_STREAM
+#define STATE_STREAM_ENABLE 1
+#else
+#define STATE_STREAM_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_CMD
+#define CMD_ENABLE 1
+#else
+#define CMD_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_RELIABLE
+#define RELIABLE_ENABLE 1
+#else
+#define RELIABLE_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_TABLE_UPLOAD
+#define TABLE_UPLOAD_ENABLE 1
+#else
+#define TABLE_UPLOAD_ENABLE 0
+#endif
+
+#ifdef CONFIG_PIPELINE_MEM_STATS
+#define MEM_STATS_ENABLE 1
+#else
+#define MEM_STATS_ENABLE 0
+#endif
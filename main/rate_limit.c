@@ -0,0 +1,48 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include "rate_limit.h"
+
+#define TOKEN_ONE 256
+#define GAP_UNIT_US 100
+#define GAP_AVG_MAX 255
+
+void rate_limit_init(rate_limit_t *limit, const rate_limit_config_t *config, uint32_t now_us)
+{
+    limit->last_us = now_us;
+    limit->tokens = (uint16_t)(config->burst * TOKEN_ONE);
+    limit->gap_avg = GAP_AVG_MAX;
+    limit->strikes = 0;
+}
+
+rate_limit_result_t rate_limit_charge(rate_limit_t *limit, const rate_limit_config_t *config, uint32_t now_us)
+{
+    uint32_t gap_us = now_us - limit->last_us;
+    limit->last_us = now_us;
+
+    // 补充令牌, 间隔超过装满所需时间时直接装满, 避免乘法溢出:
+    uint32_t full = (uint32_t)config->burst * TOKEN_ONE;
+    uint32_t fill_us = (uint32_t)((uint64_t)full * 1000000 / config->rate);
+    uint32_t tokens = gap_us >= fill_us ? full : limit->tokens + (uint32_t)((uint64_t)gap_us * config->rate * TOKEN_ONE / 1000000);
+    tokens = tokens > full ? full : tokens;
+
+    // 间隔的指数平均 (权重 1/8), 单位 100 微秒:
+    uint32_t gap = gap_us / GAP_UNIT_US > GAP_AVG_MAX ? GAP_AVG_MAX : gap_us / GAP_UNIT_US;
+    limit->gap_avg = (uint8_t)((limit->gap_avg * 7 + gap + 7) / 8);
+
+    if (tokens >= TOKEN_ONE)
+    {
+        limit->tokens = (uint16_t)(tokens - TOKEN_ONE);
+        if (limit->strikes > 0 && limit->gap_avg >= config->flood_gap)
+        {
+            limit->strikes--;
+        }
+        return RATE_LIMIT_PASS;
+    }
+    limit->tokens = (uint16_t)tokens;
+    if (limit->strikes < UINT8_MAX)
+    {
+        limit->strikes++;
+    }
+    return limit->strikes >= config->strikes_max ? RATE_LIMIT_QUARANTINE : RATE_LIMIT_DROP;
+}
@@ -0,0 +1,43 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 每个输入接口的令牌桶限速与隔离判断.
+// 每份计费报告消耗一个令牌, 令牌按 rate 每秒补充, 最多积累 burst 个, 没有令牌时报告被丢弃并记一次违规.
+// 异常检测: 计费报告间隔的指数平均低于 flood_gap 时 (失控的按键或程序注入, 人手达不到),
+// 通过的报告不再抵消违规; 否则每通过一份抵消一次. 违规累计达到 strikes_max 时应隔离接口.
+// 偶尔超过限速的快速输入只会丢弃少数报告, 持续以远超限速的频率报告的接口在几十毫秒内被隔离.
+
+typedef struct
+{
+    uint16_t rate;       // 每秒补充的令牌数
+    uint8_t burst;       // 令牌上限
+    uint8_t strikes_max; // 隔离前允许的违规次数
+    uint16_t flood_gap;  // 平均间隔低于此值视为异常, 单位 100 微秒
+} rate_limit_config_t;
+
+// 每个接口的状态, 8 字节:
+typedef struct
+{
+    uint32_t last_us;  // 上一份计费报告的时间
+    uint16_t tokens;   // 剩余令牌, 低 8 位为小数
+    uint8_t gap_avg;   // 计费报告间隔的指数平均, 单位 100 微秒, 饱和于 255 (25.5 ms)
+    uint8_t strikes;   // 未抵消的违规次数
+} rate_limit_t;
+
+typedef enum
+{
+    RATE_LIMIT_PASS,
+    RATE_LIMIT_DROP,       // 超过限速, 丢弃这份报告
+    RATE_LIMIT_QUARANTINE, // 持续超限, 丢弃并隔离接口
+} rate_limit_result_t;
+
+// 令牌桶装满, 间隔按正常输入初始化:
+void rate_limit_init(rate_limit_t *limit, const rate_limit_config_t *config, uint32_t now_us);
+
+// 为一份报告计费, now_us 允许回绕:
+rate_limit_result_t rate_limit_charge(rate_limit_t *limit, const rate_limit_config_t *config, uint32_t now_us);
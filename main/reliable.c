@@ -0,0 +1,304 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "reliable.h"
+
+typedef struct
+{
+    uint8_t wire[RELIABLE_SEGMENT_WIRE_MAX]; // 已编码的帧, 重发时直接复制
+    uint8_t len;
+    bool retransmitted;                      // 重发过的段不计入应答延迟
+    uint32_t sent_us;                        // 首次发送的时间
+} segment_t;
+
+static segment_t ring[RELIABLE_WINDOW_MAX];
+static uint8_t window = 8;
+static uint32_t timeout_us = 40000;
+static uint8_t retries = 5;
+// 序号按 256 回绕: base <= resend <= next_seq, 之间的差不超过 window:
+static uint8_t base = 0;         // 最早未应答的段
+static uint8_t resend = 0;       // 下一个要发出的段, 小于 next_seq 时有段等待重发
+static uint8_t next_seq = 0;     // 下一个新段
+static uint8_t sent_end = 0;     // 已发出过的段之后的序号, 之前的段再发出即为重发
+static uint32_t timer_us = 0;    // 最早未应答的段最近一次发出的时间
+static uint8_t timeouts = 0;     // 连续超时次数
+static bool link_down = false;
+static volatile uint8_t ack_next = 0; // 最近收到的累计应答, 由命令任务写入
+static volatile uint8_t ack_count = 0; // 收到的应答数, 用来识别重复应答
+static uint8_t ack_seen = 0;
+static bool fast_done = false;        // 当前 base 已经因重复应答重发过
+static reliable_stats_t stats;
+
+void reliable_init(uint8_t win, uint32_t timeout, uint8_t max_retries)
+{
+    window = win < 1 ? 1 : win > RELIABLE_WINDOW_MAX ? RELIABLE_WINDOW_MAX : win;
+    timeout_us = timeout;
+    retries = max_retries;
+    base = resend = next_seq = sent_end = ack_next = ack_count = ack_seen = 0;
+    fast_done = false;
+    timeouts = 0;
+    link_down = false;
+    memset(&stats, 0, sizeof(stats));
+    ESP_LOGI("RELIABLE", "Go-back-N window %d segments, ACK timeout %" PRIu32 " us, %d retries",
+             window, timeout_us, retries);
+}
+
+bool reliable_ack(const uint8_t *payload, size_t len)
+{
+    if (len != 2 || (payload[0] ^ payload[1]) != 0xFF)
+    {
+        stats.bad_acks++;
+        return false;
+    }
+    ack_next = payload[0];
+    ack_count++;
+    return true;
+}
+
+// 处理最近的累计应答, 确认的段移出窗口:
+static void process_ack(uint32_t now_us)
+{
+    uint8_t count = ack_count;
+    uint8_t ack = ack_next;
+    bool fresh = count != ack_seen;
+    ack_seen = count;
+    uint8_t acked = (uint8_t)(ack - base);
+    if (acked == 0 && fresh && !fast_done && base != sent_end)
+    {
+        // 重复应答: 接收端收到了 base 之后的段, base 已经丢失, 不等超时立即从 base 重发.
+        // 同一窗口的后续段会带来更多重复应答, 每个 base 只重发一次:
+        fast_done = true;
+        resend = base;
+        timer_us = now_us;
+        stats.fast_retransmits++;
+        return;
+    }
+    // 重复或过期的应答:
+    if (acked == 0 || acked > (uint8_t)(next_seq - base))
+    {
+        return;
+    }
+    for (uint8_t seq = base; seq != ack; seq++)
+    {
+        const segment_t *seg = &ring[seq % RELIABLE_WINDOW_MAX];
+        if (!seg->retransmitted)
+        {
+            uint32_t latency = now_us - seg->sent_us;
+            stats.ack_latency_sum_us += latency;
+            stats.ack_latency_count++;
+            stats.ack_latency_max_us = latency > stats.ack_latency_max_us ? latency : stats.ack_latency_max_us;
+        }
+    }
+    // 重发途中收到应答时, 已确认的段不必再发:
+    if ((uint8_t)(resend - base) < acked)
+    {
+        resend = ack;
+    }
+    base = ack;
+    fast_done = false;
+    stats.acks++;
+    timer_us = now_us;
+    timeouts = 0;
+    if (link_down)
+    {
+        link_down = false;
+        ESP_LOGW("RELIABLE", "Link restored at seq %d", ack);
+    }
+}
+
+size_t reliable_poll(uint32_t now_us, uint8_t *out, size_t budget)
+{
+    process_ack(now_us);
+    if (base == next_seq)
+    {
+        return 0;
+    }
+    bool expired = now_us - timer_us >= timeout_us;
+    if (expired)
+    {
+        // 超时: 从最早未应答的段起全部重发 (链路断开时只发最早的段), 重新计时:
+        stats.timeouts++;
+        resend = base;
+        timer_us = now_us;
+        if (!link_down && ++timeouts > retries)
+        {
+            link_down = true;
+            stats.link_down++;
+            ESP_LOGW("RELIABLE", "No ACK after %d retries, link down at seq %d", retries, base);
+        }
+    }
+    if (link_down)
+    {
+        // 探测: 每次超时只发最早的段, 其余等链路恢复后按序重发:
+        segment_t *seg = &ring[base % RELIABLE_WINDOW_MAX];
+        if (!expired || seg->len > budget)
+        {
+            return 0;
+        }
+        memcpy(out, seg->wire, seg->len);
+        seg->retransmitted = true;
+        stats.retransmits++;
+        return seg->len;
+    }
+    size_t n = 0;
+    while (resend != next_seq)
+    {
+        segment_t *seg = &ring[resend % RELIABLE_WINDOW_MAX];
+        if (n + seg->len > budget)
+        {
+            break;
+        }
+        memcpy(&out[n], seg->wire, seg->len);
+        n += seg->len;
+        if ((uint8_t)(resend - base) < (uint8_t)(sent_end - base))
+        {
+            seg->retransmitted = true;
+            stats.retransmits++;
+        }
+        else
+        {
+            // 排在重发之后的新段, 首次发出:
+            seg->sent_us = now_us;
+            sent_end = (uint8_t)(resend + 1);
+        }
+        resend++;
+    }
+    return n;
+}
+
+size_t reliable_room(void)
+{
+    uint8_t free = (uint8_t)(window - (uint8_t)(next_seq - base));
+    if (free == 0)
+    {
+        stats.window_full++;
+    }
+    return (size_t)free * RELIABLE_SEGMENT_MIN;
+}
+
+// 把 payload 编码为序号 next_seq 的段:
+static void seal_segment(uint8_t *payload, size_t len, uint32_t now_us)
+{
+    segment_t *seg = &ring[next_seq % RELIABLE_WINDOW_MAX];
+    payload[0] = next_seq;
+    seg->len = (uint8_t)frame_encode(FRAME_TYPE_RELIABLE, payload, len, seg->wire);
+    seg->retransmitted = false;
+    seg->sent_us = now_us;
+    if (base == next_seq)
+    {
+        timer_us = now_us;
+    }
+    next_seq++;
+    stats.segments++;
+    uint8_t in_flight = (uint8_t)(next_seq - base);
+    stats.in_flight_max = in_flight > stats.in_flight_max ? in_flight : stats.in_flight_max;
+}
+
+size_t reliable_send(const uint8_t *frames, size_t len, uint32_t now_us, uint8_t *out)
+{
+    bool immediate = resend == next_seq;
+    uint8_t first = next_seq;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    size_t fill = 1;
+    size_t pos = 0;
+    while (pos + FRAME_OVERHEAD <= len && (uint8_t)(next_seq - base) < window)
+    {
+        size_t frame_len = frames[pos + 2] + FRAME_OVERHEAD;
+        if (frame_len > RELIABLE_SEGMENT_MAX)
+        {
+            // 输出队列的帧不超过 TX_ITEM_MAX, 不会出现:
+            break;
+        }
+        if (fill + frame_len > FRAME_MAX_PAYLOAD)
+        {
+            seal_segment(payload, fill, now_us);
+            fill = 1;
+            continue;
+        }
+        memcpy(&payload[fill], &frames[pos], frame_len);
+        fill += frame_len;
+        pos += frame_len;
+    }
+    if (fill > 1 && (uint8_t)(next_seq - base) < window)
+    {
+        seal_segment(payload, fill, now_us);
+    }
+    if (!immediate)
+    {
+        return 0;
+    }
+    size_t n = 0;
+    for (uint8_t seq = first; seq != next_seq; seq++)
+    {
+        const segment_t *seg = &ring[seq % RELIABLE_WINDOW_MAX];
+        memcpy(&out[n], seg->wire, seg->len);
+        n += seg->len;
+    }
+    resend = sent_end = next_seq;
+    return n;
+}
+
+const reliable_stats_t *reliable_get_stats(void)
+{
+    return &stats;
+}
+
+void reliable_log_stats(void)
+{
+    ESP_LOGI("RELIABLE", "segments=%" PRIu32 " retransmits=%" PRIu32 " timeouts=%" PRIu32 " fast=%" PRIu32 " link_down=%" PRIu32
+                         " window_full=%" PRIu32 " in_flight_max=%d/%d",
+             stats.segments, stats.retransmits, stats.timeouts, stats.fast_retransmits, stats.link_down, stats.window_full,
+             stats.in_flight_max, window);
+    ESP_LOGI("RELIABLE", "ack latency: avg=%" PRIu32 " us max=%" PRIu32 " us (%" PRIu32 " segments), bad_acks=%" PRIu32,
+             stats.ack_latency_count ? (uint32_t)(stats.ack_latency_sum_us / stats.ack_latency_count) : 0,
+             stats.ack_latency_max_us, stats.ack_latency_count, stats.bad_acks);
+}
+
+// 段中的帧首尾相接恰好填满, 且每帧的 CRC 正确:
+static bool segment_valid(const uint8_t *data, size_t len)
+{
+    size_t pos = 0;
+    while (pos < len)
+    {
+        if (len - pos < FRAME_OVERHEAD || data[pos] != FRAME_SOF)
+        {
+            return false;
+        }
+        size_t frame_len = data[pos + 2] + FRAME_OVERHEAD;
+        if (frame_len > len - pos || frame_crc8(0, &data[pos + 1], frame_len - 2) != data[pos + frame_len - 1])
+        {
+            return false;
+        }
+        pos += frame_len;
+    }
+    return len > 0;
+}
+
+bool reliable_receive(reliable_receiver_t *rx, const frame_parser_t *frame, uint8_t *ack)
+{
+    bool in_order = frame->len >= 1 && frame->payload[0] == rx->expected;
+    if (frame->len < 1 || !segment_valid(&frame->payload[1], frame->len - 1))
+    {
+        in_order = false;
+        rx->corrupt++;
+    }
+    else if (in_order)
+    {
+        rx->expected++;
+        rx->delivered++;
+    }
+    else if (frame->len >= 1 && (uint8_t)(rx->expected - frame->payload[0]) <= RELIABLE_WINDOW_MAX)
+    {
+        rx->duplicates++;
+    }
+    else
+    {
+        rx->out_of_order++;
+    }
+    uint8_t payload[2] = {rx->expected, (uint8_t)~rx->expected};
+    frame_encode(FRAME_TYPE_RELIABLE_ACK, payload, sizeof(payload), ack);
+    return in_order;
+}
@@ -0,0 +1,81 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "frame.h"
+
+// 可靠传输 (go-back-N): 输出队列取出的二进制帧按整帧打包为带序号的段,
+// 接收端经 RX 回送累计应答 (下一个期望的序号), 只接受按序到达的段.
+//   FRAME_TYPE_RELIABLE 负载: [序号] [一个或多个完整的帧 ...]
+//   FRAME_TYPE_RELIABLE_ACK 负载: [下一个期望的序号] [序号取反]
+// 长帧的 CRC-8 每 256 个误码帧就漏检一个, 因此接收端还要求段中每个帧的 CRC 都正确且恰好填满段,
+// 应答带取反的序号, 误码的段或应答不会被当作有效.
+// 最多 window 个段等待应答, 窗口未满时新数据不等待应答直接发送; 最早的段超时未应答,
+// 或者收到重复应答 (接收端收到了后面的段) 时从它开始全部重发. 连续超时超过 retries 次认为链路断开, 此后每次超时只重发最早的段作为探测,
+// 收到应答后恢复. 窗口满时新数据留在输出队列中, 不会丢失或乱序.
+
+#define RELIABLE_WINDOW_MAX 32      // 重发环的段数, 窗口不能超过它, 序号空间 256 远大于窗口
+#define RELIABLE_OVERHEAD (FRAME_OVERHEAD + 1)
+#define RELIABLE_SEGMENT_MAX (FRAME_MAX_PAYLOAD - 1)  // 每段的数据字节数上限
+#define RELIABLE_SEGMENT_WIRE_MAX (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+// 每段至少能装下的数据: 帧不拆分, 最坏时剩余不足一个最大队列项 (16 字节) 的空间:
+#define RELIABLE_SEGMENT_MIN (RELIABLE_SEGMENT_MAX - 15)
+
+typedef struct
+{
+    uint32_t segments;           // 发出的新段
+    uint32_t retransmits;        // 重发的段
+    uint32_t timeouts;           // 最早的段等待应答超时的次数
+    uint32_t fast_retransmits;   // 收到重复应答, 不等超时就从最早的段重发的次数
+    uint32_t link_down;          // 进入链路断开状态的次数
+    uint32_t window_full;        // 窗口已满, 新数据留在队列中的周期
+    uint32_t acks;               // 确认了新段的应答
+    uint32_t bad_acks;           // 校验字节不符的应答
+    uint32_t ack_latency_max_us; // 首次发送到收到应答, 重发过的段不计入
+    uint64_t ack_latency_sum_us;
+    uint32_t ack_latency_count;
+    uint8_t in_flight_max;       // 同时等待应答的最大段数
+} reliable_stats_t;
+
+// window: 1 ~ RELIABLE_WINDOW_MAX 个段; timeout_us: 等待应答的时间; retries: 链路断开前的连续超时次数.
+// 同时清空所有段与统计:
+void reliable_init(uint8_t window, uint32_t timeout_us, uint8_t retries);
+
+// 可以在任意任务中调用 (命令任务收到应答帧时), 由下一次 reliable_poll() 处理.
+// payload 为 FRAME_TYPE_RELIABLE_ACK 帧的负载, 格式不对时返回 false:
+bool reliable_ack(const uint8_t *payload, size_t len);
+
+// 发送任务每个周期先调用: 处理应答, 把到期重发的段写入 out, 不超过 budget 字节, 返回字节数:
+size_t reliable_poll(uint32_t now_us, uint8_t *out, size_t budget);
+
+// 窗口剩余空间保证能装下的数据字节数, 窗口已满时为 0:
+size_t reliable_room(void);
+
+// 把 frames (完整的帧, 总长不超过 reliable_room()) 打包为新段放入重发环.
+// 没有等待重发的段时新段立即写入 out (至少 window * RELIABLE_SEGMENT_WIRE_MAX 字节), 返回字节数;
+// 否则排在重发之后, 由 reliable_poll() 发出:
+size_t reliable_send(const uint8_t *frames, size_t len, uint32_t now_us, uint8_t *out);
+
+const reliable_stats_t *reliable_get_stats(void);
+
+void reliable_log_stats(void);
+
+// 参考接收端, 用于主机测试:
+typedef struct
+{
+    uint8_t expected;      // 下一个期望的序号
+    uint32_t delivered;    // 按序接受的段
+    uint32_t duplicates;   // 已接受过的段
+    uint32_t out_of_order; // 前面有段丢失而丢弃的段
+    uint32_t corrupt;      // 外层 CRC 正确但段内的帧校验失败
+} reliable_receiver_t;
+
+#define RELIABLE_ACK_LEN (FRAME_OVERHEAD + 2)
+
+// 处理一个 FRAME_TYPE_RELIABLE 帧, 在 ack 中写入累计应答帧 (RELIABLE_ACK_LEN 字节).
+// 按序到达时返回 true, 段中的帧为 frame->payload[1] 起的 frame->len - 1 字节:
+bool reliable_receive(reliable_receiver_t *rx, const frame_parser_t *frame, uint8_t *ack);
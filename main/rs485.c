@@ -0,0 +1,259 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "rs485.h"
+#include "uart_tx.h"
+
+static uart_port_t bus_port = UART_NUM_1;
+static bool bus_ack = false;
+static uint32_t char_us = 87;          // 一个字符 (10 位) 的传输时间
+static uint8_t bus_seq = 0;
+static uint32_t wrap_us[256];          // 按总线序号记录的入队时间, 用于计算延迟
+static frame_parser_t rx_parser;
+static int64_t last_rx_us = 0;
+
+static rs485_dest_stats_t dest_stats[RS485_ADDR_MAX];
+static rs485_dest_stats_t broadcast_stats;
+static uint64_t busy_us = 0;           // 总线上发送与接收占用的时间
+static int64_t window_start_us = 0;
+static uint32_t deferred = 0;          // 因总线忙推迟发送的次数
+static uint32_t stray_acks = 0;        // 不匹配当前等待帧的应答
+
+// 开启应答时单播帧发出后的状态, 由 rs485_bus_idle() 每个周期推进, 发送任务不阻塞:
+typedef enum
+{
+    BUS_READY,      // 可以发送积压中的下一帧
+    BUS_WAIT_TX,    // 等待帧的最后一位发出
+    BUS_WAIT_ACK,   // 等待应答, state_until_us 为超时时刻
+    BUS_TURNAROUND, // 收到应答后等待接收端释放总线, state_until_us 为结束时刻
+} bus_state_t;
+
+static uint8_t backlog[RS485_BACKLOG_SIZE]; // rs485_transmit() 交来的帧, 尚未发出或尚未应答的部分
+static size_t backlog_len = 0;
+static size_t backlog_pos = 0;              // 下一个要发送 (或正在等待应答) 的帧
+static bus_state_t bus_state = BUS_READY;
+static int attempt = 0;                     // 当前帧的重发次数
+static int64_t state_until_us = 0;
+
+static rs485_dest_stats_t *dest_entry(uint8_t dst)
+{
+    if (dst == RS485_ADDR_BROADCAST)
+    {
+        return &broadcast_stats;
+    }
+    return dst < RS485_ADDR_MAX ? &dest_stats[dst] : NULL;
+}
+
+static void record_latency(rs485_dest_stats_t *st, uint32_t latency_us)
+{
+    if (st == NULL)
+    {
+        return;
+    }
+    st->latency_sum_us += latency_us;
+    st->latency_count++;
+    if (latency_us > st->latency_max_us)
+    {
+        st->latency_max_us = latency_us;
+    }
+}
+
+void rs485_init(uart_port_t port, int baud_rate, bool ack)
+{
+    bus_port = port;
+    bus_ack = ack;
+    char_us = 10000000u / (uint32_t)baud_rate;
+    uart_set_mode(port, UART_MODE_RS485_HALF_DUPLEX);
+    window_start_us = esp_timer_get_time();
+    ESP_LOGI("RS485", "Half duplex on UART %d, char time %" PRIu32 " us, ACK %s",
+             port, char_us, ack ? "on" : "off");
+}
+
+size_t rs485_wrap(uint8_t dst, const uint8_t *data, size_t len, uint32_t now_us, uint8_t *out)
+{
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint8_t seq = bus_seq++;
+    payload[0] = dst;
+    payload[1] = seq;
+    memcpy(&payload[2], data, len);
+    wrap_us[seq] = now_us;
+    return frame_encode(FRAME_TYPE_BUS, payload, len + 2, out);
+}
+
+// 处理已收到的数据, 匹配当前等待的 (dst, seq) 的应答结束等待:
+static void bus_receive(void)
+{
+    uint8_t buf[FRAME_OVERHEAD + 2];
+    size_t pending = 0;
+    while (uart_get_buffered_data_len(bus_port, &pending) == ESP_OK && pending > 0)
+    {
+        int n = uart_read_bytes(bus_port, buf, sizeof(buf), 0);
+        if (n <= 0)
+        {
+            return;
+        }
+        last_rx_us = esp_timer_get_time();
+        busy_us += (uint64_t)n * char_us;
+        for (int i = 0; i < n; i++)
+        {
+            if (!frame_parse_byte(&rx_parser, buf[i]) || rx_parser.type != FRAME_TYPE_ACK || rx_parser.len != 2)
+            {
+                continue;
+            }
+            bool waiting = bus_state == BUS_WAIT_TX || bus_state == BUS_WAIT_ACK;
+            const uint8_t *frame = &backlog[backlog_pos];
+            if (!waiting || rx_parser.payload[0] != frame[3] || rx_parser.payload[1] != frame[4])
+            {
+                stray_acks++;
+                continue;
+            }
+            rs485_dest_stats_t *st = dest_entry(frame[3]);
+            if (st != NULL)
+            {
+                st->acked++;
+            }
+            record_latency(st, (uint32_t)last_rx_us - wrap_us[frame[4]]);
+            backlog_pos += frame[2] + FRAME_OVERHEAD;
+            attempt = 0;
+            // 接收端释放驱动器之前不能发送下一帧:
+            bus_state = BUS_TURNAROUND;
+            state_until_us = last_rx_us + RS485_TURNAROUND_CHARS * char_us;
+        }
+    }
+}
+
+// 推进应答等待的状态, 然后逐帧发送积压的帧, TX 环形缓冲区放不下整帧或需要等待应答时停止:
+static void bus_service(void)
+{
+    bus_receive();
+    int64_t now = esp_timer_get_time();
+    if (bus_state == BUS_WAIT_TX && uart_wait_tx_done(bus_port, 0) == ESP_OK)
+    {
+        // 最后一个停止位发出后硬件才释放驱动器, 接收端此时开始应答:
+        bus_state = BUS_WAIT_ACK;
+        state_until_us = now + RS485_ACK_TIMEOUT_MS * 1000;
+    }
+    else if (bus_state == BUS_WAIT_ACK && now >= state_until_us)
+    {
+        const uint8_t *frame = &backlog[backlog_pos];
+        if (attempt < RS485_ACK_RETRIES)
+        {
+            attempt++;
+        }
+        else
+        {
+            rs485_dest_stats_t *st = dest_entry(frame[3]);
+            if (st != NULL)
+            {
+                st->lost++;
+            }
+            ESP_LOGW("RS485", "No ACK from 0x%02X for seq %d", frame[3], frame[4]);
+            backlog_pos += frame[2] + FRAME_OVERHEAD;
+            attempt = 0;
+        }
+        bus_state = BUS_READY;
+    }
+    else if (bus_state == BUS_TURNAROUND && now >= state_until_us)
+    {
+        bus_state = BUS_READY;
+    }
+
+    while (bus_state == BUS_READY && backlog_pos + FRAME_OVERHEAD + 2 <= backlog_len)
+    {
+        const uint8_t *frame = &backlog[backlog_pos];
+        size_t frame_len = frame[2] + FRAME_OVERHEAD;
+        uint8_t dst = frame[3];
+        uint8_t seq = frame[4];
+        if (backlog_pos + frame_len > backlog_len)
+        {
+            backlog_len = backlog_pos;
+            break;
+        }
+        // 只写入完整的帧, 放不下时留到下一个周期, 总线上不会出现半帧:
+        if (uart_tx_free() < frame_len || uart_tx_write(frame, frame_len) < frame_len)
+        {
+            break;
+        }
+        busy_us += (uint64_t)frame_len * char_us;
+        rs485_dest_stats_t *st = dest_entry(dst);
+        if (st != NULL)
+        {
+            st->frames++;
+            st->retries += attempt > 0;
+        }
+        if (bus_ack && dst != RS485_ADDR_BROADCAST)
+        {
+            bus_state = BUS_WAIT_TX;
+            break;
+        }
+        // 不等待应答: 延迟按写入时刻加上帧的线上传输时间估算:
+        record_latency(st, (uint32_t)esp_timer_get_time() - wrap_us[seq] + frame_len * char_us);
+        backlog_pos += frame_len;
+    }
+}
+
+bool rs485_bus_idle(void)
+{
+    bus_service();
+    if (bus_state != BUS_READY || backlog_pos + FRAME_OVERHEAD + 2 <= backlog_len)
+    {
+        return false;
+    }
+    if (esp_timer_get_time() - last_rx_us < (int64_t)RS485_IDLE_CHARS * char_us)
+    {
+        deferred++;
+        return false;
+    }
+    return true;
+}
+
+void rs485_transmit(const uint8_t *frames, size_t len)
+{
+    // 调用者只在总线空闲 (积压已发完) 时取出新的帧:
+    len = len < sizeof(backlog) ? len : sizeof(backlog);
+    memcpy(backlog, frames, len);
+    backlog_len = len;
+    backlog_pos = 0;
+    bus_service();
+}
+
+const rs485_dest_stats_t *rs485_get_stats(uint8_t dst)
+{
+    return dest_entry(dst);
+}
+
+static void log_dest(const char *name, const rs485_dest_stats_t *st)
+{
+    ESP_LOGI("RS485", "%s: frames=%" PRIu32 " retries=%" PRIu32 " acked=%" PRIu32 " lost=%" PRIu32
+                      " latency us avg/max=%" PRIu64 "/%" PRIu32,
+             name, st->frames, st->retries, st->acked, st->lost,
+             st->latency_count ? st->latency_sum_us / st->latency_count : 0, st->latency_max_us);
+}
+
+void rs485_log_stats(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t window = now - window_start_us;
+    ESP_LOGI("RS485", "bus: utilisation=%d%% deferred=%" PRIu32 " stray_acks=%" PRIu32 " crc_errors=%" PRIu32,
+             window > 0 ? (int)(busy_us * 100 / window) : 0, deferred, stray_acks, rx_parser.crc_errors);
+    busy_us = 0;
+    window_start_us = now;
+    char name[8];
+    for (int i = 0; i < RS485_ADDR_MAX; i++)
+    {
+        if (dest_stats[i].frames > 0)
+        {
+            snprintf(name, sizeof(name), "0x%02X", i);
+            log_dest(name, &dest_stats[i]);
+        }
+    }
+    if (broadcast_stats.frames > 0)
+    {
+        log_dest("bcast", &broadcast_stats);
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/uart.h"
+#include "frame.h"
+
+// RS-485 多点总线: 每个输出帧带目的地址, 帧格式见 frame.h:
+//   FRAME_TYPE_BUS 负载: [目的地址] [总线序号] [数据 ...]
+//   FRAME_TYPE_ACK 负载: [接收端地址] [总线序号]
+// 数据为 ASCII 字符或二进制事件帧. 广播地址的帧不应答.
+
+#define RS485_ADDR_BROADCAST 0xFF
+#define RS485_ADDR_MAX 16           // 单播地址 0 ~ 15, 每个地址单独统计
+#define RS485_OVERHEAD (FRAME_OVERHEAD + 2)
+#define RS485_IDLE_CHARS 4          // 至少 3.5 个字符时间没有收到数据, 认为总线空闲
+#define RS485_TURNAROUND_CHARS 2    // 收到应答后, 等待接收端释放总线再发送
+#define RS485_ACK_TIMEOUT_MS 20     // 等待应答的时间, 至少一个 FreeRTOS tick
+#define RS485_ACK_RETRIES 2         // 未收到应答时的重发次数
+#define RS485_BACKLOG_SIZE 512      // rs485_transmit() 一次交来的帧的最大字节数
+
+typedef struct
+{
+    uint32_t frames;          // 发出的帧, 含重发
+    uint32_t retries;         // 重发次数
+    uint32_t acked;           // 收到应答的帧
+    uint32_t lost;            // 重发后仍未应答的帧
+    uint32_t latency_max_us;  // 入队到发送完成 (开启应答时为收到应答) 的最大延迟
+    uint64_t latency_sum_us;
+    uint32_t latency_count;
+} rs485_dest_stats_t;
+
+// 切换到 RS-485 半双工模式 (RTS 管脚自动控制驱动器使能), 驱动必须已安装:
+void rs485_init(uart_port_t port, int baud_rate, bool ack);
+
+// 将 data 封装为发往 dst 的帧写入 out (至少 len + RS485_OVERHEAD 字节), 返回帧长度:
+size_t rs485_wrap(uint8_t dst, const uint8_t *data, size_t len, uint32_t now_us, uint8_t *out);
+
+// 每个周期调用: 处理收到的应答与超时, 继续发送积压的帧. 积压已发完且应答都已结束,
+// 并且最近 RS485_IDLE_CHARS 个字符时间内没有收到数据时返回 true:
+bool rs485_bus_idle(void);
+
+// 接管 rs485_wrap() 生成的帧 (最多 RS485_BACKLOG_SIZE 字节), 只在 rs485_bus_idle() 返回 true 后调用.
+// 每帧在 TX 环形缓冲区放得下整帧时才写入; 开启应答时单播帧发出后进入等待状态, 不阻塞调用者,
+// 由之后的 rs485_bus_idle() 检查应答, 超时重发:
+void rs485_transmit(const uint8_t *frames, size_t len);
+
+// dst 为 RS485_ADDR_BROADCAST 时返回广播帧的统计:
+const rs485_dest_stats_t *rs485_get_stats(uint8_t dst);
+
+// 输出总线利用率 (自上次输出以来) 和每个目的地址的计数与延迟:
+void rs485_log_stats(void);
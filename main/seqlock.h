@@ -0,0 +1,41 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// 单写者 seqlock: 写者从不等待读者, 读者在写入期间或读到一半被改写时重试.
+// 序号为奇数表示正在写入. 用法:
+//   写者: seqlock_write_begin(&lock); 修改数据; seqlock_write_end(&lock);
+//   读者: do { s = seqlock_read_begin(&lock); 复制数据; } while (seqlock_read_retry(&lock, s));
+// 读者不自旋等待写入结束: 写者可能在同一核上被读者抢占, 重试前应让出 CPU.
+
+typedef struct
+{
+    uint32_t seq;
+} seqlock_t;
+
+static inline void seqlock_write_begin(seqlock_t *lock)
+{
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline void seqlock_write_end(seqlock_t *lock)
+{
+    __atomic_store_n(&lock->seq, lock->seq + 1, __ATOMIC_RELEASE);
+}
+
+static inline uint32_t seqlock_read_begin(const seqlock_t *lock)
+{
+    return __atomic_load_n(&lock->seq, __ATOMIC_ACQUIRE);
+}
+
+// 读取开始时正在写入, 或读取期间数据被改写时返回 true, 需要重新读取:
+static inline bool seqlock_read_retry(const seqlock_t *lock, uint32_t seq)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return (seq & 1) || __atomic_load_n(&lock->seq, __ATOMIC_RELAXED) != seq;
+}
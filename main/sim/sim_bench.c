@@ -0,0 +1,1339 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+#include <pthread.h>
+#include "keymap.h"
+#include "chain.h"
+#include "fec.h"
+#include "state_stream.h"
+#include "seqlock.h"
+#include "hid_report.h"
+#include "encoder.h"
+#include "matrix.h"
+#include "rate_limit.h"
+#include "reliable.h"
+#include "table_store.h"
+#include "ita2.h"
+#include "mem_stats.h"
+#include "mbedtls/sha256.h"
+#include "sim_bench.h"
+#include "sim_uhid.h"
+#include "sim_table.h"
+
+#define BENCH_KEYS (1u << 20)
+#define BENCH_ROUNDS 20
+#define BENCH_CHAIN_EVENTS 100000
+#define BENCH_CHAIN_HOP_US 500 // 每一跳模拟的停留时间
+#define BENCH_FEC_FRAMES 10000
+#define BENCH_STATE_EVENTS 200000
+#define BENCH_STATE_DEVICES 4
+#define BENCH_STATE_LOSS 5     // 丢帧百分比
+#define BENCH_SEQLOCK_READS 2000000
+#define BENCH_HID_REPORTS 1000000
+#define BENCH_ENCODER_EVENTS (1u << 16)
+#define BENCH_MATRIX_SCANS 200000      // 1000 Hz 扫描, 约 200 秒
+#define BENCH_MATRIX_DEBOUNCE_MS 5
+#define BENCH_MATRIX_BOUNCE_SCANS 3    // 边沿后读数抖动的扫描次数
+#define BENCH_RATE_PRESSES 100000
+#define BENCH_RELIABLE_EVENTS 20000
+#define BENCH_RELIABLE_BAUD 115200
+#define BENCH_TABLE_BYTES (200 * 1024)
+#define BENCH_TABLE_LOSS 1     // 上传丢帧百分比
+#define BENCH_ITA2_BAUD 45
+#define BENCH_ITA2_TYPING_S 60  // 打字时间, 之后等待打印机打完
+#define BENCH_ITA2_MAX 4096     // 每个设备输入的最大字符数
+#define BENCH_HID_CHURN 5000    // 虚拟键盘插拔次数
+#define BENCH_HID_BUDGET 12288  // 16 个键盘的 HID 驱动内存预算, 字节
+
+static uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static int bench_fail(const char *name)
+{
+    printf("BENCH %s: FAILED\n", name);
+    exit(1);
+}
+
+// 键码批量转换: 逐个调用 usb_keycode_to_ascii() 与 usb_keycode_to_ascii_bulk() 对比:
+static void bench_keymap(void)
+{
+    key_input_t *keys = malloc(BENCH_KEYS * sizeof(key_input_t));
+    char *ref = malloc(BENCH_KEYS);
+    char *out = malloc(BENCH_KEYS);
+    if (keys == NULL || ref == NULL || out == NULL)
+    {
+        bench_fail("keymap");
+    }
+    srand(1);
+    for (uint32_t i = 0; i < BENCH_KEYS; i++)
+    {
+        // 大部分落在可打印范围, 少量覆盖越界键码, 修饰键覆盖全部 8 位:
+        keys[i].key_code = (rand() % 8) ? 0x04 + rand() % 0x35 : rand() % 256;
+        keys[i].modifier = rand() % 256;
+    }
+
+    keymap_init();
+    size_t ref_len = 0;
+    uint64_t t0 = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        ref_len = 0;
+        for (uint32_t i = 0; i < BENCH_KEYS; i++)
+        {
+            char c = usb_keycode_to_ascii(keys[i].key_code, keys[i].modifier);
+            if (c != 0)
+            {
+                ref[ref_len++] = c;
+            }
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    size_t out_len = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        out_len = usb_keycode_to_ascii_bulk(keys, BENCH_KEYS, out);
+    }
+    uint64_t t2 = bench_now_ns();
+
+    if (out_len != ref_len || memcmp(out, ref, ref_len) != 0)
+    {
+        bench_fail("keymap");
+    }
+    double n = (double)BENCH_KEYS * BENCH_ROUNDS;
+    printf("BENCH keymap: scalar %.2f ns/key, bulk %.2f ns/key, %zu chars, equivalent\n",
+           (t1 - t0) / n, (t2 - t1) / n, out_len);
+    free(keys);
+    free(ref);
+    free(out);
+}
+
+// 8 个桥的级联: 事件从桥 0 出发, 逐跳编码、逐字节解析、再编码, 末端校验内容、跳数与累计延迟:
+static void bench_chain(void)
+{
+    frame_parser_t parser = {0};
+    uint8_t frame[FRAME_CHAIN_EVENT_LEN];
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_CHAIN_EVENTS; i++)
+    {
+        const key_event_t origin = {
+            .ts_us = i * 1000, .dev = i % 4, .key_code = 0x04 + i % 0x35, .modifier = i % 256,
+            .flags = i % 2 ? KEY_EVENT_PRESS : 0};
+        key_event_t event = origin;
+        size_t len = 0;
+        for (int hop = 0; hop < CHAIN_MAX_BRIDGES; hop++)
+        {
+            len = chain_encode_event(&event, (uint16_t)i, event.ts_us + BENCH_CHAIN_HOP_US, 0, frame);
+            bool ready = false;
+            for (size_t b = 0; b < len; b++)
+            {
+                ready = frame_parse_byte(&parser, frame[b]);
+            }
+            if (!ready || !chain_decode_event(&parser, event.ts_us + 2 * BENCH_CHAIN_HOP_US, &event))
+            {
+                bench_fail("chain");
+            }
+        }
+        if (event.bridge != 0 || event.hops != CHAIN_MAX_BRIDGES || event.dev != origin.dev ||
+            event.key_code != origin.key_code || event.modifier != origin.modifier || event.flags != origin.flags ||
+            event.seq != (uint16_t)i || event.age != CHAIN_MAX_BRIDGES * BENCH_CHAIN_HOP_US / 100)
+        {
+            bench_fail("chain");
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    uint32_t per_link = 115200 / 10 / FRAME_CHAIN_EVENT_LEN;
+    printf("BENCH chain: %.2f ns/hop encode+parse, %d hops verified; at 115200 baud a link carries %" PRIu32
+           " events/s, %" PRIu32 " per bridge in a chain of %d\n",
+           (t1 - t0) / (double)(BENCH_CHAIN_EVENTS * CHAIN_MAX_BRIDGES), CHAIN_MAX_BRIDGES, per_link,
+           per_link / CHAIN_MAX_BRIDGES, CHAIN_MAX_BRIDGES);
+}
+
+// 按 ber 翻转随机位; burst > 1 时每个错误事件翻转连续 burst 位, 总误码率不变:
+static void bench_inject(uint8_t *data, size_t len, double ber, int burst)
+{
+    double p = ber / burst;
+    for (size_t bit = 0; bit < len * 8; bit++)
+    {
+        if (rand() / (RAND_MAX + 1.0) < p)
+        {
+            for (int b = 0; b < burst && bit + b < len * 8; b++)
+            {
+                data[(bit + b) / 8] ^= (uint8_t)(1 << ((bit + b) % 8));
+            }
+        }
+    }
+}
+
+// 统计与原始帧一致的帧, 以及通过了 CRC 但内容错误的帧:
+static void bench_count(const uint8_t *frame, size_t len, const uint8_t *frames, uint32_t *good, uint32_t *bad)
+{
+    uint16_t seq = frame[3] | frame[4] << 8;
+    if (len == FRAME_EVENT_LEN && seq < BENCH_FEC_FRAMES && memcmp(frame, &frames[seq * FRAME_EVENT_LEN], len) == 0)
+    {
+        (*good)++;
+    }
+    else
+    {
+        (*bad)++;
+    }
+}
+
+// 前向纠错: 无误码时解码结果必须与原始帧完全一致, 再按一组误码率注入随机与突发错误,
+// 比较未编码、不交织和 8 路交织的帧送达率:
+static void bench_fec(void)
+{
+    static const double bers[] = {1e-4, 1e-3, 3e-3, 1e-2, 3e-2};
+    static const int depths[] = {1, 8};
+    size_t raw_len = BENCH_FEC_FRAMES * FRAME_EVENT_LEN;
+    uint8_t *frames = malloc(raw_len);
+    uint8_t *raw = malloc(raw_len);
+    uint8_t *coded = malloc(BENCH_FEC_FRAMES * FEC_CODED_LEN(FRAME_EVENT_LEN));
+    uint8_t *noisy = malloc(BENCH_FEC_FRAMES * FEC_CODED_LEN(FRAME_EVENT_LEN));
+    if (frames == NULL || raw == NULL || coded == NULL || noisy == NULL)
+    {
+        bench_fail("fec");
+    }
+    srand(2);
+    for (uint32_t i = 0; i < BENCH_FEC_FRAMES; i++)
+    {
+        const key_event_t event = {
+            .dev = rand() % 4, .key_code = rand() % 256, .modifier = rand() % 256, .flags = rand() % 2};
+        frame_encode_event(&event, (uint16_t)i, &frames[i * FRAME_EVENT_LEN]);
+    }
+
+    size_t coded_len[2];
+    for (int d = 0; d < 2; d++)
+    {
+        fec_init(depths[d]);
+        uint64_t t0 = bench_now_ns();
+        coded_len[d] = fec_encode_frames(frames, raw_len, coded);
+        uint64_t t1 = bench_now_ns();
+        fec_decoder_t dec = {0};
+        uint32_t good = 0, bad = 0;
+        for (size_t i = 0; i < coded_len[d]; i++)
+        {
+            if (fec_decode_byte(&dec, coded[i]))
+            {
+                bench_count(dec.frame, dec.frame_len, frames, &good, &bad);
+            }
+        }
+        if (good != BENCH_FEC_FRAMES || bad != 0 || dec.corrected != 0)
+        {
+            bench_fail("fec");
+        }
+        printf("BENCH fec: depth %d encode %.2f ns/frame, %zu -> %zu bytes, lossless round trip\n",
+               depths[d], (t1 - t0) / (double)BENCH_FEC_FRAMES, raw_len, coded_len[d]);
+    }
+
+    for (int burst = 1; burst <= 4; burst += 3)
+    {
+        for (size_t b = 0; b < sizeof(bers) / sizeof(bers[0]); b++)
+        {
+            // 未编码: 用普通帧解析器接收:
+            memcpy(raw, frames, raw_len);
+            bench_inject(raw, raw_len, bers[b], burst);
+            frame_parser_t parser = {0};
+            uint32_t raw_good = 0, raw_bad = 0;
+            uint8_t frame[FRAME_EVENT_LEN];
+            for (size_t i = 0; i < raw_len; i++)
+            {
+                if (frame_parse_byte(&parser, raw[i]) && parser.len == FRAME_EVENT_PAYLOAD_LEN)
+                {
+                    frame_encode(parser.type, parser.payload, parser.len, frame);
+                    bench_count(frame, sizeof(frame), frames, &raw_good, &raw_bad);
+                }
+            }
+            uint32_t good[2] = {0}, bad[2] = {0}, corrected[2] = {0};
+            for (int d = 0; d < 2; d++)
+            {
+                fec_init(depths[d]);
+                fec_encode_frames(frames, raw_len, coded);
+                memcpy(noisy, coded, coded_len[d]);
+                bench_inject(noisy, coded_len[d], bers[b], burst);
+                fec_decoder_t dec = {0};
+                for (size_t i = 0; i < coded_len[d]; i++)
+                {
+                    if (fec_decode_byte(&dec, noisy[i]))
+                    {
+                        bench_count(dec.frame, dec.frame_len, frames, &good[d], &bad[d]);
+                    }
+                }
+                corrected[d] = dec.corrected;
+            }
+            printf("BENCH fec: ber %.0e burst %d: delivered raw %.2f%%, fec %.2f%% (depth 1), %.2f%% (depth 8);"
+                   " corrupted raw/d1/d8 %" PRIu32 "/%" PRIu32 "/%" PRIu32 ", corrected d1/d8 %" PRIu32 "/%" PRIu32 "\n",
+                   bers[b], burst, raw_good * 100.0 / BENCH_FEC_FRAMES, good[0] * 100.0 / BENCH_FEC_FRAMES,
+                   good[1] * 100.0 / BENCH_FEC_FRAMES, raw_bad, bad[0], bad[1], corrected[0], corrected[1]);
+        }
+    }
+    free(frames);
+    free(raw);
+    free(coded);
+    free(noisy);
+}
+
+// 把帧交给接收端, 按 loss 百分比随机丢弃:
+static void bench_state_feed(state_receiver_t *rx, const uint8_t *frames, size_t len, int loss)
+{
+    frame_parser_t parser = {0};
+    for (size_t i = 0; i < len; i++)
+    {
+        if (frame_parse_byte(&parser, frames[i]) && rand() % 100 >= loss)
+        {
+            state_receive(rx, &parser);
+        }
+    }
+}
+
+// 状态流: 随机按键在有损链路上传输, 比较只有增量和带关键帧两种接收端与发送端状态
+// 不一致的时间比例; 最后一轮无损关键帧之后两者必须完全一致:
+static void bench_state(void)
+{
+    static state_receiver_t rx_delta, rx_keyframe;
+    const bool active[BENCH_STATE_DEVICES] = {true, true, true, true};
+    uint8_t frame[FRAME_KEYFRAME_LEN * BENCH_STATE_DEVICES];
+    uint32_t diverged_delta = 0, diverged_keyframe = 0;
+    uint16_t seq = 0;
+    uint32_t now_ms = 0;
+    srand(3);
+    state_init(1000, 5, 11520);
+    for (uint32_t i = 0; i < BENCH_STATE_EVENTS; i++)
+    {
+        key_event_t event = {.dev = rand() % BENCH_STATE_DEVICES, .key_code = 0x04 + rand() % 0x50};
+        const key_state_t *st = state_get(event.dev);
+        event.flags = (st->keys[event.key_code >> 3] & (1 << (event.key_code & 7))) ? 0 : KEY_EVENT_PRESS;
+        size_t len = frame_encode_event(&event, seq++, frame);
+        state_apply(&event, len);
+        bench_state_feed(&rx_delta, frame, len, BENCH_STATE_LOSS);
+        bench_state_feed(&rx_keyframe, frame, len, BENCH_STATE_LOSS);
+        now_ms += 20;
+        len = state_poll(now_ms, seq, active, BENCH_STATE_DEVICES, frame, sizeof(frame));
+        bench_state_feed(&rx_keyframe, frame, len, BENCH_STATE_LOSS);
+        for (int d = 0; d < BENCH_STATE_DEVICES; d++)
+        {
+            diverged_delta += memcmp(state_get(d), &rx_delta.state[d], sizeof(key_state_t)) != 0;
+            diverged_keyframe += memcmp(state_get(d), &rx_keyframe.state[d], sizeof(key_state_t)) != 0;
+        }
+    }
+    state_request_keyframe();
+    size_t len = state_poll(now_ms, seq, active, BENCH_STATE_DEVICES, frame, sizeof(frame));
+    bench_state_feed(&rx_keyframe, frame, len, 0);
+    for (int d = 0; d < BENCH_STATE_DEVICES; d++)
+    {
+        if (memcmp(state_get(d), &rx_keyframe.state[d], sizeof(key_state_t)) != 0)
+        {
+            bench_fail("state");
+        }
+    }
+    const state_stats_t *st = state_get_stats();
+    double samples = (double)BENCH_STATE_EVENTS * BENCH_STATE_DEVICES;
+    printf("BENCH state: %d%% frame loss, receiver out of sync %.1f%% of the time with deltas only, %.1f%% with"
+           " keyframes every %" PRIu32 " ms (overhead %.1f%%), resynchronised\n",
+           BENCH_STATE_LOSS, diverged_delta * 100 / samples, diverged_keyframe * 100 / samples, st->interval_ms,
+           st->keyframe_bytes * 100.0 / (st->keyframe_bytes + st->delta_bytes));
+}
+
+// seqlock: 写线程不停改写 (所有字节相同的) 键盘状态, 读线程读到的每份快照必须一致:
+static seqlock_t bench_lock;
+static uint8_t bench_keys[4][8];
+static volatile bool bench_stop;
+
+static void *bench_seqlock_writer(void *arg)
+{
+    uint64_t *writes = arg;
+    uint8_t v = 0;
+    while (!bench_stop)
+    {
+        v++;
+        seqlock_write_begin(&bench_lock);
+        memset(bench_keys, v, sizeof(bench_keys));
+        seqlock_write_end(&bench_lock);
+        (*writes)++;
+    }
+    return NULL;
+}
+
+static void bench_seqlock(void)
+{
+    uint64_t writes = 0, retries = 0;
+    pthread_t writer;
+    bench_stop = false;
+    pthread_create(&writer, NULL, bench_seqlock_writer, &writes);
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_SEQLOCK_READS; i++)
+    {
+        uint8_t copy[4][8];
+        uint32_t seq;
+        while (1)
+        {
+            seq = seqlock_read_begin(&bench_lock);
+            memcpy(copy, bench_keys, sizeof(copy));
+            if (!seqlock_read_retry(&bench_lock, seq))
+            {
+                break;
+            }
+            retries++;
+        }
+        for (size_t b = 1; b < sizeof(copy); b++)
+        {
+            if (((uint8_t *)copy)[b] != copy[0][0])
+            {
+                bench_fail("seqlock");
+            }
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    bench_stop = true;
+    pthread_join(writer, NULL);
+    printf("BENCH seqlock: %u consistent snapshots, %.1f ns/read, %" PRIu64 " retries, %" PRIu64
+           " concurrent writes never blocked\n",
+           BENCH_SEQLOCK_READS, (t1 - t0) / (double)BENCH_SEQLOCK_READS, retries, writes);
+}
+
+// 报告描述符解析与 NKRO 报告转换: Boot 键盘, 以及两种常见的 NKRO 描述符,
+// 第二种的键盘报告排在多媒体键报告之后, 位图从键码 0x04 开始:
+static const uint8_t bench_boot_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x01, 0x95, 0x05, 0x75, 0x01,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x01, 0x95, 0x06,
+    0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00, 0xC0};
+static const uint8_t bench_nkro_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00,
+    0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x19, 0x00, 0x29, 0x77, 0x95, 0x78, 0x81, 0x02, 0xC0};
+static const uint8_t bench_nkro2_desc[] = {
+    0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02, 0x15, 0x00, 0x26, 0xFF, 0x03, 0x19, 0x00, 0x2A,
+    0xFF, 0x03, 0x75, 0x10, 0x95, 0x01, 0x81, 0x00, 0xC0,
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x03, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00,
+    0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x19, 0x04, 0x29, 0x73, 0x95, 0x70, 0x81, 0x02,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x95, 0x05, 0x91, 0x02, 0x95, 0x03, 0x91, 0x01, 0xC0};
+
+static void bench_hid_report(void)
+{
+    hid_kbd_layout_t boot, nkro, nkro2;
+    if (!hid_report_parse_keyboard(bench_boot_desc, sizeof(bench_boot_desc), &boot) ||
+        !hid_report_parse_keyboard(bench_nkro_desc, sizeof(bench_nkro_desc), &nkro) ||
+        !hid_report_parse_keyboard(bench_nkro2_desc, sizeof(bench_nkro2_desc), &nkro2))
+    {
+        bench_fail("hid_report");
+    }
+    if (boot.rollover != 6 || boot.mod_bit != 0 || boot.array_bit != hid_boot_layout.array_bit ||
+        nkro.report_id != 1 || nkro.rollover != 120 || nkro.bitmap_bit != 8 ||
+        nkro2.report_id != 3 || nkro2.rollover != 112 || nkro2.bitmap_first != 0x04)
+    {
+        bench_fail("hid_report");
+    }
+    // 随机按键组合编码为位图报告, 转换回来必须得到相同的修饰键与按键:
+    const uint8_t consumer[3] = {0x02, 0xE9, 0x00};
+    uint8_t out[2 + 16];
+    if (hid_report_decode_keyboard(&nkro2, consumer, sizeof(consumer), out, sizeof(out)) != 0)
+    {
+        bench_fail("hid_report");
+    }
+    srand(7);
+    uint64_t keys = 0;
+    uint64_t elapsed = 0;
+    for (uint32_t r = 0; r < BENCH_HID_REPORTS; r++)
+    {
+        uint8_t report[16] = {0x03, (uint8_t)rand()};
+        uint8_t want[256] = {0};
+        int n = rand() % 11;
+        for (int k = 0; k < n; k++)
+        {
+            uint8_t key = (uint8_t)(0x04 + rand() % 112);
+            want[key] = 1;
+            report[2 + (key - 0x04) / 8] |= (uint8_t)(1 << ((key - 0x04) % 8));
+        }
+        uint64_t t0 = bench_now_ns();
+        size_t len = hid_report_decode_keyboard(&nkro2, report, sizeof(report), out, sizeof(out));
+        elapsed += bench_now_ns() - t0;
+        if (len < 2 || out[0] != report[1])
+        {
+            bench_fail("hid_report");
+        }
+        for (size_t i = 2; i < len; i++)
+        {
+            if (!want[out[i]])
+            {
+                bench_fail("hid_report");
+            }
+            want[out[i]] = 0;
+        }
+        for (int k = 0; k < 256; k++)
+        {
+            if (want[k])
+            {
+                bench_fail("hid_report");
+            }
+        }
+        keys += len - 2;
+    }
+    printf("BENCH hid_report: %u NKRO reports, %" PRIu64 " keys, %.1f ns/report\n",
+           BENCH_HID_REPORTS, keys, elapsed / (double)BENCH_HID_REPORTS);
+}
+
+// 与 tools/encoders/ 中的定义相同:
+static const char bench_encoder_binary[] =
+    "press   *  A5 01 06 {seq} {dev} 01 {mod} {key} {crc8@1}\n"
+    "release *  A5 01 06 {seq} {dev} 00 {mod} {key} {crc8@1}\n"
+    "repeat  *  A5 01 06 {seq} {dev} 03 {mod} {key} {crc8@1}\n";
+static const char bench_encoder_ascii[] = "press * {ascii}\nrepeat * {ascii}\n";
+
+// 错误的定义与应报告的行号:
+static const struct
+{
+    const char *def;
+    int line;
+} bench_encoder_invalid[] = {
+    {"", 0},
+    {"# comment only\n", 0},
+    {"press\n", 1},
+    {"hold * 41\n", 1},
+    {"press 0x1D-0x04 41\n", 1},
+    {"press 0x100 41\n", 1},
+    {"press * 4\n", 1},
+    {"press * 41\n\nrelease * \"abc\n", 3},
+    {"press * \"\\q\"\n", 1},
+    {"press * {mod} {mod}\n", 1},
+    {"press * {seq} {seq8}\n", 1},
+    {"press * {crc8}\n", 1},
+    {"press * A5 {xor@1}\n", 1},
+    {"press * 41 {xor} {sum}\n", 1},
+    {"press * {keys}\n", 1},
+    {"press * {key\n", 1},
+    {"press * \"0123456789abcdef\" 00\n", 1},
+    {"press * {key} \"0123456789abcd\"\nrelease * {key} \"0123456789abcd\"\n"
+     "repeat * {key} \"0123456789abcd\"\npress 0x2C {ascii}\n", 0},
+};
+
+// 表驱动编码: 与二进制帧和 ASCII 转换的结果逐一比较, 错误的定义必须在正确的行被拒绝:
+static void *bench_encoder_alloc(size_t size)
+{
+    return mem_malloc(MEM_TAG_APP, size);
+}
+
+static void bench_encoder(void)
+{
+    // 与固件相同, 编码表的内存记入应用子系统, 最后检查没有泄漏.
+    // 查表输出时固件自己的编码表也在应用子系统中, 只比较本测试前后的变化:
+    const encoder_allocator_t allocator = {bench_encoder_alloc, mem_free};
+    encoder_set_allocator(&allocator);
+    mem_report_t mem;
+    mem_stats_sample(&mem);
+    const hid_host_mem_usage_t before = mem.tags[MEM_TAG_APP];
+    encoder_t bin, ascii;
+    if (!encoder_compile(&bin, bench_encoder_binary) || !encoder_compile(&ascii, bench_encoder_ascii))
+    {
+        bench_fail("encoder");
+    }
+    for (int mod = 0; mod < 256; mod++)
+    {
+        for (int key = 0; key < 256; key++)
+        {
+            key_event_t event = {.key_code = (uint8_t)key, .modifier = (uint8_t)mod, .flags = KEY_EVENT_PRESS};
+            uint8_t out[ENCODER_TEMPLATE_MAX];
+            char c = usb_keycode_to_ascii((uint8_t)key, (uint8_t)mod);
+            size_t len = encoder_encode(&ascii, &event, 0, out);
+            if (len != (c != 0) || (len && out[0] != (uint8_t)c))
+            {
+                bench_fail("encoder");
+            }
+            event.flags = 0;
+            if (encoder_encode(&ascii, &event, 0, out) != 0)
+            {
+                bench_fail("encoder");
+            }
+        }
+    }
+    key_event_t *events = malloc(BENCH_ENCODER_EVENTS * sizeof(key_event_t));
+    uint8_t *out = malloc(BENCH_ENCODER_EVENTS * ENCODER_TEMPLATE_MAX);
+    uint8_t *ref = malloc(BENCH_ENCODER_EVENTS * ENCODER_TEMPLATE_MAX);
+    if (events == NULL || out == NULL || ref == NULL)
+    {
+        bench_fail("encoder");
+    }
+    srand(11);
+    for (uint32_t i = 0; i < BENCH_ENCODER_EVENTS; i++)
+    {
+        static const uint8_t flags[3] = {KEY_EVENT_PRESS, 0, KEY_EVENT_PRESS | KEY_EVENT_REPEAT};
+        events[i] = (key_event_t){
+            .dev = rand() % 4, .key_code = rand() % 256, .modifier = rand() % 256, .flags = flags[rand() % 3]};
+    }
+    uint64_t t0 = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (uint32_t i = 0; i < BENCH_ENCODER_EVENTS; i++)
+        {
+            frame_encode_event(&events[i], (uint16_t)i, &ref[i * ENCODER_TEMPLATE_MAX]);
+        }
+    }
+    uint64_t t1 = bench_now_ns();
+    for (int r = 0; r < BENCH_ROUNDS; r++)
+    {
+        for (uint32_t i = 0; i < BENCH_ENCODER_EVENTS; i++)
+        {
+            encoder_encode(&bin, &events[i], (uint16_t)i, &out[i * ENCODER_TEMPLATE_MAX]);
+        }
+    }
+    uint64_t t2 = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_ENCODER_EVENTS; i++)
+    {
+        uint8_t frame[ENCODER_TEMPLATE_MAX];
+        if (encoder_encode(&bin, &events[i], (uint16_t)i, frame) != FRAME_EVENT_LEN ||
+            memcmp(&out[i * ENCODER_TEMPLATE_MAX], &ref[i * ENCODER_TEMPLATE_MAX], FRAME_EVENT_LEN) != 0)
+        {
+            bench_fail("encoder");
+        }
+    }
+    free(events);
+    free(out);
+    free(ref);
+    size_t invalid = sizeof(bench_encoder_invalid) / sizeof(bench_encoder_invalid[0]);
+    for (size_t i = 0; i < invalid; i++)
+    {
+        encoder_t enc;
+        if (encoder_compile(&enc, bench_encoder_invalid[i].def) || enc.error_line != bench_encoder_invalid[i].line)
+        {
+            printf("BENCH encoder: definition %zu accepted or wrong line\n", i);
+            bench_fail("encoder");
+        }
+    }
+    double n = (double)BENCH_ENCODER_EVENTS * BENCH_ROUNDS;
+    printf("BENCH encoder: binary definition %.1f ns/event, frame_encode_event %.1f ns/event, equivalent; "
+           "memory binary/ascii %zu/%zu bytes, %zu invalid definitions rejected\n",
+           (t2 - t1) / n, (t1 - t0) / n,
+           encoder_memory(&bin), encoder_memory(&ascii), invalid);
+    encoder_free(&bin);
+    encoder_free(&ascii);
+    // 编译失败的定义也不能留下内存:
+    mem_stats_sample(&mem);
+    const hid_host_mem_usage_t *app = &mem.tags[MEM_TAG_APP];
+    if (app->current != before.current || app->allocs - before.allocs != app->frees - before.frees)
+    {
+        printf("BENCH encoder: %zu bytes left, %" PRIu32 " allocs %" PRIu32 " frees\n",
+               app->current - before.current, app->allocs - before.allocs, app->frees - before.frees);
+        bench_fail("encoder");
+    }
+}
+
+// 按键矩阵去抖: 8x16 矩阵按 1000 Hz 扫描, 每个键随机按下释放, 边沿后若干次扫描读数随机抖动.
+// 验证每次理想的状态变化恰好产生一次去抖后的变化, 延迟不超过抖动加去抖时间, 报告与状态一致:
+static void bench_matrix(void)
+{
+    static const int pins[MATRIX_MAX_COLS] = {0};
+    uint8_t keymap[MATRIX_MAX_ROWS * MATRIX_MAX_COLS];
+    for (int k = 0; k < MATRIX_MAX_ROWS * MATRIX_MAX_COLS; k++)
+    {
+        // 最后 8 个键为修饰键:
+        keymap[k] = k < MATRIX_MAX_ROWS * MATRIX_MAX_COLS - 8 ? 0x04 + k : 0xE0 + (k & 7);
+    }
+    const matrix_config_t config = {
+        .row_pins = pins,
+        .col_pins = pins,
+        .rows = MATRIX_MAX_ROWS,
+        .cols = MATRIX_MAX_COLS,
+        .keymap = keymap,
+        .scan_hz = 1000,
+        .debounce_ms = BENCH_MATRIX_DEBOUNCE_MS,
+        .max_keys = 6};
+    uint16_t *raw = malloc(sizeof(uint16_t) * MATRIX_MAX_ROWS * BENCH_MATRIX_SCANS);
+    uint16_t *ideal_at = malloc(sizeof(uint16_t) * MATRIX_MAX_ROWS * BENCH_MATRIX_SCANS);
+    uint32_t *edge = calloc(MATRIX_MAX_ROWS * MATRIX_MAX_COLS, sizeof(uint32_t));
+    uint16_t ideal[MATRIX_MAX_ROWS] = {0};
+    uint32_t transitions = 0;
+    srand(90);
+    for (uint32_t s = 0; s < BENCH_MATRIX_SCANS; s++)
+    {
+        uint16_t *row = &raw[s * MATRIX_MAX_ROWS];
+        for (int r = 0; r < MATRIX_MAX_ROWS; r++)
+        {
+            row[r] = 0;
+            for (int c = 0; c < MATRIX_MAX_COLS; c++)
+            {
+                uint32_t *e = &edge[r * MATRIX_MAX_COLS + c];
+                uint16_t bit = (uint16_t)(1 << c);
+                // 两次变化至少间隔抖动加去抖时间, 平均约 200 ms:
+                if (s - *e > BENCH_MATRIX_BOUNCE_SCANS + BENCH_MATRIX_DEBOUNCE_MS && rand() % 200 == 0 &&
+                    s < BENCH_MATRIX_SCANS - 100)
+                {
+                    ideal[r] ^= bit;
+                    *e = s;
+                    transitions++;
+                }
+                if (s - *e < BENCH_MATRIX_BOUNCE_SCANS && *e != 0 && rand() & 1)
+                {
+                    row[r] |= ~ideal[r] & bit;
+                }
+                else
+                {
+                    row[r] |= ideal[r] & bit;
+                }
+            }
+        }
+        memcpy(&ideal_at[s * MATRIX_MAX_ROWS], ideal, sizeof(ideal));
+    }
+
+    // 验证: 理想状态变化时记下时刻, 去抖后的变化必须在其后的窗口内且只有一次:
+    static matrix_t m;
+    matrix_init(&m, &config, NULL, NULL);
+    for (int k = 0; k < MATRIX_MAX_ROWS * MATRIX_MAX_COLS; k++)
+    {
+        edge[k] = UINT32_MAX;
+    }
+    uint32_t changes = 0, latency_max = 0;
+    for (uint32_t s = 0; s < BENCH_MATRIX_SCANS; s++)
+    {
+        const uint16_t *now = &ideal_at[s * MATRIX_MAX_ROWS];
+        const uint16_t *prev = s > 0 ? &ideal_at[(s - 1) * MATRIX_MAX_ROWS] : now;
+        uint16_t before[MATRIX_MAX_ROWS];
+        for (int r = 0; r < MATRIX_MAX_ROWS; r++)
+        {
+            for (uint16_t diff = prev[r] ^ now[r]; diff; diff &= diff - 1)
+            {
+                edge[r * MATRIX_MAX_COLS + __builtin_ctz(diff)] = s;
+            }
+            before[r] = m.stable[r];
+        }
+        matrix_scan(&m, &raw[s * MATRIX_MAX_ROWS]);
+        for (int r = 0; r < MATRIX_MAX_ROWS; r++)
+        {
+            for (uint16_t diff = before[r] ^ m.stable[r]; diff; diff &= diff - 1)
+            {
+                int k = r * MATRIX_MAX_COLS + __builtin_ctz(diff);
+                uint32_t latency = s - edge[k];
+                if (edge[k] == UINT32_MAX || latency + 1 < BENCH_MATRIX_DEBOUNCE_MS ||
+                    latency > BENCH_MATRIX_BOUNCE_SCANS + BENCH_MATRIX_DEBOUNCE_MS)
+                {
+                    printf("BENCH matrix: key %d changed %" PRIu32 " scans after its edge\n", k, latency);
+                    bench_fail("matrix");
+                }
+                latency_max = latency > latency_max ? latency : latency_max;
+                edge[k] = UINT32_MAX;
+                changes++;
+            }
+        }
+    }
+    if (changes != transitions || memcmp(m.stable, ideal, sizeof(ideal)) != 0)
+    {
+        printf("BENCH matrix: %" PRIu32 " debounced changes for %" PRIu32 " transitions\n", changes, transitions);
+        bench_fail("matrix");
+    }
+
+    // 报告: 修饰键合并为第一个字节, 其余按行列顺序, 超过 max_keys 的计入 rollover:
+    uint8_t report[2 + 6];
+    size_t len = matrix_report(&m, report, sizeof(report));
+    uint8_t modifier = 0;
+    size_t keys = 0, held = 0;
+    for (int k = 0; k < MATRIX_MAX_ROWS * MATRIX_MAX_COLS; k++)
+    {
+        if (!(ideal[k / MATRIX_MAX_COLS] & (1 << (k % MATRIX_MAX_COLS))))
+        {
+            continue;
+        }
+        if (keymap[k] >= 0xE0)
+        {
+            modifier |= (uint8_t)(1 << (keymap[k] - 0xE0));
+        }
+        else if (held++ < 6 && report[2 + keys++] != keymap[k])
+        {
+            bench_fail("matrix");
+        }
+    }
+    if (report[0] != modifier || len != 2 + keys || m.stats.rollover != held - keys)
+    {
+        bench_fail("matrix");
+    }
+
+    // 扫描耗时: 同一组读数, 另一份去抖状态:
+    matrix_init(&m, &config, NULL, NULL);
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t s = 0; s < BENCH_MATRIX_SCANS; s++)
+    {
+        matrix_scan(&m, &raw[s * MATRIX_MAX_ROWS]);
+    }
+    uint64_t t1 = bench_now_ns();
+    const uint16_t idle[MATRIX_MAX_ROWS] = {0};
+    for (uint32_t s = 0; s < BENCH_MATRIX_SCANS; s++)
+    {
+        matrix_scan(&m, idle);
+    }
+    uint64_t t2 = bench_now_ns();
+    printf("BENCH matrix: %dx%d, %" PRIu32 " transitions with %d ms bounce -> %" PRIu32 " debounced changes, "
+           "%" PRIu32 " chatter filtered, max latency %" PRIu32 " ms; scan %.1f ns active, %.1f ns idle\n",
+           MATRIX_MAX_ROWS, MATRIX_MAX_COLS, transitions, BENCH_MATRIX_BOUNCE_SCANS, changes, m.stats.chatter,
+           latency_max, (t1 - t0) / (double)BENCH_MATRIX_SCANS, (t2 - t1) / (double)BENCH_MATRIX_SCANS);
+    free(edge);
+    free(ideal_at);
+    free(raw);
+}
+
+// 以固定间隔为报告计费 duration_us, 返回通过的报告数, 被隔离时在 quarantine_us 中记下时刻:
+static uint32_t bench_rate_feed(rate_limit_t *limit, const rate_limit_config_t *config, uint32_t *now_us,
+                                uint32_t gap_us, uint32_t duration_us, uint32_t *quarantine_us)
+{
+    uint32_t passed = 0;
+    for (uint32_t t = 0; t < duration_us; t += gap_us)
+    {
+        *now_us += gap_us;
+        rate_limit_result_t result = rate_limit_charge(limit, config, *now_us);
+        passed += result == RATE_LIMIT_PASS;
+        if (result == RATE_LIMIT_QUARANTINE && *quarantine_us == 0)
+        {
+            *quarantine_us = t + gap_us;
+        }
+    }
+    return passed;
+}
+
+// 限速与隔离: 与应用相同的配置下, 人手输入 (含和弦与快速连击) 和扫码枪突发不能被丢弃,
+// 失控的接口在短时间内被隔离, 略超限速的接口只被限速:
+static void bench_rate_limit(void)
+{
+    const rate_limit_config_t config = {.rate = 60, .burst = 20, .strikes_max = 50, .flood_gap = 40};
+    rate_limit_t limit;
+    uint32_t now_us = 0;
+    rate_limit_init(&limit, &config, now_us);
+    srand(91);
+    uint32_t dropped = 0;
+    for (uint32_t i = 0; i < BENCH_RATE_PRESSES; i++)
+    {
+        // 正常打字间隔 60 ~ 400 ms, 5% 为 1 ~ 5 ms 的和弦, 每 200 次有一串 15 次 40 ms 的连击:
+        uint32_t gap_ms = rand() % 20 == 0 ? 1 + rand() % 5 : 60 + rand() % 340;
+        if (i % 200 < 15)
+        {
+            gap_ms = 40;
+        }
+        now_us += gap_ms * 1000;
+        dropped += rate_limit_charge(&limit, &config, now_us) != RATE_LIMIT_PASS;
+    }
+    uint32_t scanner_quarantine = 0;
+    uint32_t scanner = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        // 扫码枪: 13 位条码每位间隔 2 ms, 每秒一次:
+        scanner += bench_rate_feed(&limit, &config, &now_us, 2000, 13 * 2000, &scanner_quarantine);
+        now_us += 1000000;
+    }
+    if (dropped != 0 || scanner != 1300 || scanner_quarantine != 0)
+    {
+        printf("BENCH rate: human input lost %" PRIu32 " reports, scanner %" PRIu32 "/1300\n", dropped, scanner);
+        bench_fail("rate");
+    }
+
+    // 失控: 1000 Hz 与 300 Hz 报告都应被隔离, 80 Hz 规律报告只限速为每秒 60 份:
+    const uint32_t gaps_us[] = {1000, 3300, 12500};
+    uint32_t quarantine_us[3] = {0};
+    uint32_t passed[3];
+    for (int g = 0; g < 3; g++)
+    {
+        rate_limit_init(&limit, &config, now_us);
+        passed[g] = bench_rate_feed(&limit, &config, &now_us, gaps_us[g], 10000000, &quarantine_us[g]);
+    }
+    if (quarantine_us[0] == 0 || quarantine_us[0] > 100000 || quarantine_us[1] == 0 || quarantine_us[2] != 0 ||
+        passed[2] < 590 || passed[2] > 625)
+    {
+        bench_fail("rate");
+    }
+
+    uint64_t t0 = bench_now_ns();
+    for (uint32_t i = 0; i < BENCH_RATE_PRESSES; i++)
+    {
+        now_us += 1000 + (i & 0xFFFF);
+        rate_limit_charge(&limit, &config, now_us);
+    }
+    uint64_t t1 = bench_now_ns();
+    printf("BENCH rate: %zu bytes/device, %.1f ns/report; %d human presses and %d scanner digits, none dropped; "
+           "1000 Hz flood quarantined after %" PRIu32 " ms, 300 Hz after %" PRIu32 " ms, "
+           "80 Hz throttled to %" PRIu32 "/s\n",
+           sizeof(rate_limit_t), (t1 - t0) / (double)BENCH_RATE_PRESSES, BENCH_RATE_PRESSES, 1300,
+           quarantine_us[0] / 1000, quarantine_us[1] / 1000, passed[2] / 10);
+}
+
+// 模拟的串口线路: 按波特率每毫秒送出一部分字节, 途中注入误码:
+typedef struct
+{
+    uint8_t buf[4096];
+    size_t len;
+    uint32_t credit; // 可发送字节数, 单位 1/1000 字节
+} bench_line_t;
+
+static void bench_line_write(bench_line_t *line, const uint8_t *data, size_t len)
+{
+    if (line->len + len > sizeof(line->buf))
+    {
+        bench_fail("reliable");
+    }
+    memcpy(&line->buf[line->len], data, len);
+    line->len += len;
+}
+
+// 送出本毫秒的字节, 返回字节数, 数据在 out 中:
+static size_t bench_line_tick(bench_line_t *line, double ber, uint8_t *out)
+{
+    line->credit += BENCH_RELIABLE_BAUD / 10;
+    size_t n = line->credit / 1000 < line->len ? line->credit / 1000 : line->len;
+    line->credit = line->len > n ? line->credit - n * 1000 : 0;
+    memcpy(out, line->buf, n);
+    memmove(line->buf, &line->buf[n], line->len - n);
+    line->len -= n;
+    bench_inject(out, n, ber, 1);
+    return n;
+}
+
+// 可靠传输: 键盘事件经误码线路发送, 接收端经同样有误码的回路应答.
+// 验证所有事件按序、不重复地到达, 并统计重发次数、应答延迟与端到端延迟:
+static void bench_reliable(void)
+{
+    const double bers[] = {0, 1e-4, 1e-3};
+    // 与应用的 TX_BYTES_PER_TICK 与 TX 环形缓冲区相同:
+    const uint32_t tx_per_tick = BENCH_RELIABLE_BAUD / 10 / 100;
+    const uint32_t tx_buffer = 2 * tx_per_tick + 128;
+    uint32_t *gen_ms = malloc(BENCH_RELIABLE_EVENTS * sizeof(uint32_t));
+    uint8_t *pending = malloc(BENCH_RELIABLE_EVENTS * FRAME_EVENT_LEN);
+    for (size_t b = 0; b < sizeof(bers) / sizeof(bers[0]); b++)
+    {
+        srand(92);
+        reliable_init(8, 40000, 5);
+        static bench_line_t down, up;
+        memset(&down, 0, sizeof(down));
+        memset(&up, 0, sizeof(up));
+        reliable_receiver_t rx = {0};
+        frame_parser_t rx_parser = {0}, inner = {0}, ack_parser = {0};
+        uint32_t generated = 0, delivered = 0, raw_good = 0;
+        uint32_t wait_max_ms = 0, latency_max_ms = 0;
+        uint64_t latency_sum_ms = 0;
+        size_t head = 0; // pending 中尚未交给可靠层的第一帧
+        uint8_t out[RELIABLE_WINDOW_MAX * RELIABLE_SEGMENT_WIRE_MAX];
+        for (uint32_t ms = 1; delivered < BENCH_RELIABLE_EVENTS; ms++)
+        {
+            if (ms > BENCH_RELIABLE_EVENTS * 100)
+            {
+                printf("BENCH reliable: ber %.0e stalled at %" PRIu32 "/%d events\n", bers[b], delivered,
+                       BENCH_RELIABLE_EVENTS);
+                bench_fail("reliable");
+            }
+            // 平均每 10 ms 一个事件, 偶尔 8 个一串:
+            int burst = rand() % 100 == 0 ? 8 : rand() % 10 == 0;
+            for (int i = 0; i < burst && generated < BENCH_RELIABLE_EVENTS; i++)
+            {
+                key_event_t event = {.key_code = 0x04 + generated % 26, .flags = KEY_EVENT_PRESS};
+                uint8_t *frame = &pending[generated * FRAME_EVENT_LEN];
+                frame_encode_event(&event, (uint16_t)generated, frame);
+                gen_ms[generated++] = ms;
+                // 不经过可靠传输时同样误码下完好到达的帧:
+                uint8_t copy[FRAME_EVENT_LEN];
+                memcpy(copy, frame, sizeof(copy));
+                bench_inject(copy, sizeof(copy), bers[b], 1);
+                frame_parser_t raw = {0};
+                for (size_t j = 0; j < sizeof(copy); j++)
+                {
+                    raw_good += frame_parse_byte(&raw, copy[j]) && memcmp(raw.payload, &frame[3], 6) == 0;
+                }
+            }
+            // 应答到达时立即处理, 与命令任务唤醒发送任务相同; 其余时间每 10 ms 一个周期:
+            uint8_t bytes[64];
+            size_t n = bench_line_tick(&up, bers[b], bytes);
+            bool acked = false;
+            for (size_t i = 0; i < n; i++)
+            {
+                if (frame_parse_byte(&ack_parser, bytes[i]) && ack_parser.type == FRAME_TYPE_RELIABLE_ACK)
+                {
+                    acked |= reliable_ack(ack_parser.payload, ack_parser.len);
+                }
+            }
+            if (acked || ms % 10 == 0)
+            {
+                uint32_t now_us = ms * 1000;
+                size_t free_size = tx_buffer - down.len;
+                bench_line_write(&down, out, reliable_poll(now_us, out, free_size));
+                size_t budget = (tx_buffer - down.len) * RELIABLE_SEGMENT_MIN / (RELIABLE_SEGMENT_MIN + RELIABLE_OVERHEAD);
+                size_t room = reliable_room();
+                budget = budget < room ? budget : room;
+                budget = budget < tx_per_tick ? budget : tx_per_tick;
+                size_t take = 0;
+                while (head + take < generated && (take + 1) * FRAME_EVENT_LEN <= budget)
+                {
+                    take++;
+                }
+                if (take > 0)
+                {
+                    for (size_t i = head; i < head + take; i++)
+                    {
+                        wait_max_ms = ms - gen_ms[i] > wait_max_ms ? ms - gen_ms[i] : wait_max_ms;
+                    }
+                    bench_line_write(&down, out, reliable_send(&pending[head * FRAME_EVENT_LEN],
+                                                               take * FRAME_EVENT_LEN, now_us, out));
+                    head += take;
+                }
+            }
+            n = bench_line_tick(&down, bers[b], bytes);
+            for (size_t i = 0; i < n; i++)
+            {
+                if (!frame_parse_byte(&rx_parser, bytes[i]) || rx_parser.type != FRAME_TYPE_RELIABLE)
+                {
+                    continue;
+                }
+                uint8_t ack[RELIABLE_ACK_LEN];
+                bool in_order = reliable_receive(&rx, &rx_parser, ack);
+                bench_line_write(&up, ack, sizeof(ack));
+                for (size_t j = 1; in_order && j < rx_parser.len; j++)
+                {
+                    if (!frame_parse_byte(&inner, rx_parser.payload[j]))
+                    {
+                        continue;
+                    }
+                    uint16_t seq = (uint16_t)(inner.payload[0] | inner.payload[1] << 8);
+                    if (inner.type != FRAME_TYPE_EVENT || seq != (uint16_t)delivered)
+                    {
+                        printf("BENCH reliable: ber %.0e event %d delivered as %" PRIu32 "\n", bers[b], seq, delivered);
+                        bench_fail("reliable");
+                    }
+                    uint32_t latency = ms - gen_ms[delivered++];
+                    latency_sum_ms += latency;
+                    latency_max_ms = latency > latency_max_ms ? latency : latency_max_ms;
+                }
+            }
+        }
+        const reliable_stats_t *st = reliable_get_stats();
+        printf("BENCH reliable: ber %.0e: %d/%d events in order (unprotected %.2f%%), %" PRIu32 " segments, "
+               "%" PRIu32 " retransmits (%" PRIu32 " timeouts, %" PRIu32 " fast), %" PRIu32 " corrupt caught; "
+               "ack latency avg %" PRIu32 " max %" PRIu32 " us; delivery avg %.1f max %" PRIu32 " ms; queue wait max %" PRIu32 " ms\n",
+               bers[b], BENCH_RELIABLE_EVENTS, BENCH_RELIABLE_EVENTS, raw_good * 100.0 / BENCH_RELIABLE_EVENTS,
+               st->segments, st->retransmits, st->timeouts, st->fast_retransmits, rx.corrupt,
+               st->ack_latency_count ? (uint32_t)(st->ack_latency_sum_us / st->ack_latency_count) : 0,
+               st->ack_latency_max_us, latency_sum_ms / (double)BENCH_RELIABLE_EVENTS, latency_max_ms, wait_max_ms);
+        if (bers[b] == 0 && (st->retransmits != 0 || st->window_full != 0))
+        {
+            bench_fail("reliable");
+        }
+    }
+    free(pending);
+    free(gen_ms);
+}
+
+// 主机端上传: 按窗口发送数据帧, 按进度帧前进或回退. 发送的帧按 loss 百分比丢失,
+// 窗口已满又没有进度时视为超时, 从最近确认的偏移重发. 返回线路上的字节数, 失败时返回 0:
+static size_t bench_upload(const uint8_t *image, uint32_t len, int loss, uint8_t *status_out)
+{
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    payload[0] = TABLE_OP_BEGIN;
+    memcpy(&payload[1], &len, 4);
+    mbedtls_sha256(image, len, &payload[5], 0);
+    table_upload_frame(payload, 37);
+    size_t wire = FRAME_OVERHEAD + 37;
+    uint32_t next = 0, acked = 0;
+    for (int rounds = 0; rounds < 100000; rounds++)
+    {
+        if (next < len && next < acked + TABLE_UPLOAD_WINDOW)
+        {
+            size_t n = len - next < TABLE_DATA_MAX ? len - next : TABLE_DATA_MAX;
+            payload[0] = TABLE_OP_DATA;
+            memcpy(&payload[1], &next, 4);
+            memcpy(&payload[5], &image[next], n);
+            if (rand() % 100 >= loss)
+            {
+                table_upload_frame(payload, 5 + n);
+            }
+            wire += FRAME_OVERHEAD + 5 + n;
+            next += n;
+        }
+        else if (next == len)
+        {
+            payload[0] = TABLE_OP_COMMIT;
+            table_upload_frame(payload, 1);
+            wire += FRAME_OVERHEAD + 1;
+        }
+        bool progress = false;
+        size_t n;
+        while ((n = table_upload_status(status_out)) > 0)
+        {
+            uint8_t status = status_out[3];
+            uint32_t offset;
+            memcpy(&offset, &status_out[4], 4);
+            progress = true;
+            if (status == TABLE_STATUS_OK)
+            {
+                acked = offset > acked ? offset : acked;
+            }
+            else if (status == TABLE_STATUS_RESEND)
+            {
+                next = offset;
+            }
+            else
+            {
+                return status == TABLE_STATUS_COMMITTED ? wire : 0;
+            }
+        }
+        if (!progress && next >= acked + TABLE_UPLOAD_WINDOW)
+        {
+            next = acked;
+        }
+    }
+    return 0;
+}
+
+// 数据表上传: 约 200 KB 的镜像 (编码表定义加一个未知标签的大段) 经有丢帧的 RX 流式上传,
+// 校验切换后模拟重启确认新表生效; 再在每一次擦写之后掉电, 确认重启后总是完整的旧表或新表:
+static void bench_tables(void)
+{
+    static const char *defs[2] = {"press * {ascii}\nrepeat * {ascii}\n", "press * {key}\nrelease * 0x80 {key}\n"};
+    uint8_t *images[2];
+    uint32_t lens[2];
+    for (int v = 0; v < 2; v++)
+    {
+        size_t def_len = strlen(defs[v]);
+        uint32_t filler = BENCH_TABLE_BYTES - v * 5000;
+        images[v] = malloc(8 + def_len + filler);
+        uint8_t *p = images[v];
+        p[0] = 0x7F; // 以后的表, 当前固件跳过
+        p[1] = filler & 0xFF;
+        p[2] = (filler >> 8) & 0xFF;
+        p[3] = filler >> 16;
+        for (uint32_t i = 0; i < filler; i++)
+        {
+            p[4 + i] = (uint8_t)rand();
+        }
+        p += 4 + filler;
+        p[0] = TABLE_SECTION_ENCODER;
+        p[1] = def_len & 0xFF;
+        p[2] = def_len >> 8;
+        p[3] = 0;
+        memcpy(&p[4], defs[v], def_len);
+        lens[v] = 8 + def_len + filler;
+    }
+    uint8_t status[TABLE_STATUS_FRAME_LEN];
+    char def[256];
+    size_t size;
+    table_flash_open(&size);
+    table_flash_erase(0, size);
+    table_store_init();
+
+    // 依次上传两版, 第三次上传第一版时丢失部分帧:
+    srand(93);
+    size_t wire = bench_upload(images[0], lens[0], 0, status);
+    bool ok = wire > 0 && bench_upload(images[1], lens[1], 0, status) > 0;
+    size_t wire_lossy = bench_upload(images[0], lens[0], BENCH_TABLE_LOSS, status);
+    const table_stats_t *st = table_store_get_stats();
+    size_t def_len = table_store_read(TABLE_SECTION_ENCODER, def, sizeof(def) - 1);
+    uint32_t resends = st->resends;
+    table_store_init();
+    if (!ok || wire_lossy == 0 || table_store_generation() != 3 || def_len != strlen(defs[0]) ||
+        table_store_read(TABLE_SECTION_ENCODER, def, sizeof(def) - 1) != def_len || memcmp(def, defs[0], def_len) != 0)
+    {
+        bench_fail("tables");
+    }
+
+    // 掉电测试: 保存上传前的分区, 每次在第 k 次擦写后掉电, 重启后检查:
+    uint8_t *saved = malloc(size);
+    table_flash_read(0, saved, size);
+    uint32_t ops = 1 + 2 * ((lens[1] + TABLE_SECTOR - 1) / TABLE_SECTOR) + 2; // 头部擦除, 每扇区擦除与写入, 头部两次写入
+    int kept = 0, switched = 0;
+    for (uint32_t k = 0; k <= ops; k++)
+    {
+        if (k > 8 && k < ops - 8 && k % 16 != 0)
+        {
+            continue;
+        }
+        table_flash_erase(0, size);
+        table_flash_write(0, saved, size);
+        table_store_init();
+        sim_table_power_cut((int)k);
+        bench_upload(images[1], lens[1], 0, status);
+        sim_table_power_cut(-1);
+        table_store_init();
+        size_t n = table_store_read(TABLE_SECTION_ENCODER, def, sizeof(def) - 1);
+        int v = table_store_generation() == 3 ? 0 : table_store_generation() == 4 ? 1 : -1;
+        if (v < 0 || n != strlen(defs[v]) || memcmp(def, defs[v], n) != 0 || (v == 1) != (k == ops))
+        {
+            printf("BENCH tables: power cut after %" PRIu32 " of %" PRIu32 " flash ops -> generation %" PRIu32 "\n", k, ops,
+                   table_store_generation());
+            bench_fail("tables");
+        }
+        kept += v == 0;
+        switched += v == 1;
+    }
+    printf("BENCH tables: %" PRIu32 " byte image, %u bytes on the wire (%.1f%% overhead, %.1f s at 115200 baud); "
+           "%d%% frame loss: %" PRIu32 " resends, %u bytes; %d power cuts kept the old image, %d switched, none torn\n",
+           lens[0], (unsigned)wire, (wire - lens[0]) * 100.0 / lens[0], wire / 11520.0, BENCH_TABLE_LOSS, resends,
+           (unsigned)wire_lossy, kept, switched);
+    free(saved);
+    free(images[0]);
+    free(images[1]);
+}
+
+// 电传打字机模拟: 10 ms 周期, 每个设备按随机间隔逐字输入 texts[d] 的内容, 打印机按收到的码与档位打印到 out.
+// 返回输出的字符数, inputs[d] 为设备 d 实际输入的字符:
+static size_t bench_ita2_run(const char *const *texts, const uint32_t *gap_ms, int devices, char *out,
+                             char inputs[][BENCH_ITA2_MAX], size_t *input_lens, uint32_t *line_over)
+{
+    const ita2_config_t config = {.baud = BENCH_ITA2_BAUD, .us_tty = true, .usos = false,
+                                  .reorder_us = 2000000, .resync_us = 5000000, .tick_us = 10000};
+    ita2_init(&config);
+    uint32_t next_us[8] = {0};
+    size_t pos[8] = {0};
+    int figs = -1; // 打印机档位, -1 为未知
+    size_t n = 0;
+    uint32_t sent = 0;
+    uint32_t char_us = ITA2_BITS_X10 * 100000 / BENCH_ITA2_BAUD;
+    *line_over = 0;
+    for (int d = 0; d < devices; d++)
+    {
+        input_lens[d] = 0;
+    }
+    for (uint32_t now_us = 0;; now_us += 10000)
+    {
+        bool typing = now_us < BENCH_ITA2_TYPING_S * 1000000u;
+        for (int d = 0; d < devices && typing; d++)
+        {
+            if ((int32_t)(now_us - next_us[d]) >= 0)
+            {
+                char c = texts[d][pos[d]++ % strlen(texts[d])];
+                ita2_push(d, &c, 1, now_us);
+                inputs[d][input_lens[d]++] = c;
+                next_us[d] = now_us + (gap_ms[d] / 2 + rand() % gap_ms[d]) * 1000;
+            }
+        }
+        uint8_t codes[4];
+        size_t len = ita2_drain(now_us, codes, sizeof(codes));
+        sent += len;
+        // 交给 UART 的字符不能超过线路从 0 开始连续发送的数量加上缓冲的两个:
+        if (sent > (now_us + char_us - 1) / char_us + 2)
+        {
+            (*line_over)++;
+        }
+        for (size_t i = 0; i < len; i++)
+        {
+            if (codes[i] == ITA2_LTRS || codes[i] == ITA2_FIGS)
+            {
+                figs = codes[i] == ITA2_FIGS;
+                continue;
+            }
+            char c = ita2_char(codes[i], figs == 1);
+            if (c == 0 || (figs < 0 && c != ita2_char(codes[i], true)))
+            {
+                bench_fail("ita2");
+            }
+            out[n++] = c;
+        }
+        if (!typing && ita2_backlog() == 0)
+        {
+            return n;
+        }
+    }
+}
+
+// 打印机收到的内容: 大写, 回车键为回车加换行:
+static size_t bench_ita2_expect(const char *in, size_t len, char *out)
+{
+    size_t n = 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (in[i] == '\n')
+        {
+            out[n++] = '\r';
+        }
+        out[n++] = in[i] >= 'a' && in[i] <= 'z' ? in[i] - 'a' + 'A' : in[i];
+    }
+    return n;
+}
+
+// out 是否为 a 与 b 保持各自顺序的交错:
+static bool bench_interleaved(const char *out, size_t n, const char *a, size_t la, const char *b, size_t lb)
+{
+    if (n != la + lb)
+    {
+        return false;
+    }
+    bool *row = calloc(lb + 1, sizeof(bool));
+    // row[j]: out 的前 i + j 个字符可以由 a 的前 i 个与 b 的前 j 个交错组成:
+    row[0] = true;
+    for (size_t j = 1; j <= lb; j++)
+    {
+        row[j] = row[j - 1] && b[j - 1] == out[j - 1];
+    }
+    for (size_t i = 1; i <= la; i++)
+    {
+        row[0] = row[0] && a[i - 1] == out[i - 1];
+        for (size_t j = 1; j <= lb; j++)
+        {
+            row[j] = (row[j] && a[i - 1] == out[i + j - 1]) || (row[j - 1] && b[j - 1] == out[i + j - 1]);
+        }
+    }
+    bool ok = row[lb];
+    free(row);
+    return ok;
+}
+
+// Baudot 输出: 一个键盘低于线路速度输入时, 打印内容与输入一致, 换档与逐个发送相同;
+// 一个键盘输入文字、另一个同时输入数字, 合计超过线路速度时, 每个键盘的顺序不变, 换档明显减少:
+static void bench_ita2(void)
+{
+    static char inputs[2][BENCH_ITA2_MAX];
+    static char expect[2][2 * BENCH_ITA2_MAX];
+    static char out[4 * BENCH_ITA2_MAX];
+    size_t input_lens[2];
+    uint32_t line_over;
+    srand(94);
+    const char *single[] = {"qso 1 at 1423z on 14.070 mhz, rst 599 (73)\n"};
+    const uint32_t single_gap[] = {250};
+    size_t n = bench_ita2_run(single, single_gap, 1, out, inputs, input_lens, &line_over);
+    size_t le = bench_ita2_expect(inputs[0], input_lens[0], expect[0]);
+    ita2_stats_t one = *ita2_get_stats();
+    if (n != le || memcmp(out, expect[0], n) != 0 || one.shifts != one.shifts_fifo || line_over != 0)
+    {
+        bench_fail("ita2");
+    }
+
+    const char *dual[] = {"the quick brown fox jumps over the lazy dog\n", "1234 5678 90/12 (3.4) -56, 789?\n"};
+    const uint32_t dual_gap[] = {250, 400};
+    n = bench_ita2_run(dual, dual_gap, 2, out, inputs, input_lens, &line_over);
+    size_t la = bench_ita2_expect(inputs[0], input_lens[0], expect[0]);
+    size_t lb = bench_ita2_expect(inputs[1], input_lens[1], expect[1]);
+    const ita2_stats_t *st = ita2_get_stats();
+    if (!bench_interleaved(out, n, expect[0], la, expect[1], lb) || st->shifts * 2 > st->shifts_fifo || st->dropped != 0 ||
+        line_over != 0)
+    {
+        printf("BENCH ita2: %zu chars out of %zu, shifts %" PRIu32 " vs %" PRIu32 ", line overrun %" PRIu32 "\n",
+               n, la + lb, st->shifts, st->shifts_fifo, line_over);
+        bench_fail("ita2");
+    }
+    printf("BENCH ita2: %d baud, one keyboard: %" PRIu32 " chars, %" PRIu32 " shifts (same as arrival order), "
+           "avg latency %" PRIu32 " ms; two keyboards letters + figures: %" PRIu32 " chars in order per keyboard, "
+           "%" PRIu32 " shifts instead of %" PRIu32 ", %" PRIu32 " reordered, latency avg %" PRIu32 " ms max %" PRIu32
+           " ms, backlog max %u chars\n",
+           BENCH_ITA2_BAUD, one.chars, one.shifts, (uint32_t)(one.latency_sum_us / one.chars / 1000), st->chars,
+           st->shifts, st->shifts_fifo, st->reordered, (uint32_t)(st->latency_sum_us / st->chars / 1000),
+           st->latency_max_us / 1000, st->backlog_max);
+}
+
+void sim_bench_run(void)
+{
+    if (getenv("SIM_BENCH") == NULL)
+    {
+        return;
+    }
+    bench_keymap();
+    bench_chain();
+    bench_fec();
+    bench_state();
+    bench_seqlock();
+    bench_hid_report();
+    bench_encoder();
+    bench_matrix();
+    bench_rate_limit();
+    bench_reliable();
+    bench_tables();
+    bench_ita2();
+    sim_uhid_bench();
+    sim_uhid_churn(BENCH_HID_CHURN);
+    sim_uhid_budget(BENCH_HID_BUDGET);
+    exit(0);
+}
@@ -0,0 +1,8 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+// Linux 仿真构建的基准测试, 设置环境变量 SIM_BENCH=1 时运行并退出,
+// 每项基准同时校验优化路径与参考实现的输出一致, 不一致时以非 0 状态退出.
+void sim_bench_run(void);
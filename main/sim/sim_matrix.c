@@ -0,0 +1,96 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "matrix.h"
+
+// Linux 仿真的按键矩阵: 虚拟面板按顺序按下每个键, 按下和释放的边沿后一段时间内触点随机抖动.
+// FreeRTOS 节拍 (10 ms) 远低于扫描频率, 因此每个节拍按虚拟时间补齐这段时间内的全部扫描,
+// 去抖逻辑看到的读数序列与按 scan_hz 定时扫描完全相同.
+//
+// 环境变量:
+//   SIM_MATRIX_INTERVAL_MS  每个键按下加释放的周期 (默认 500, 按住一半时间)
+//   SIM_MATRIX_BOUNCE_MS    每个边沿之后的抖动时间 (默认 3)
+
+static const char *TAG = "SIM";
+
+static uint32_t s_interval_us = 500 * 1000;
+static uint32_t s_bounce_us = 3 * 1000;
+
+// 虚拟时间 t 时全部触点的读数:
+static void sim_matrix_read(const matrix_t *m, uint64_t t, uint16_t *raw)
+{
+    int keys = m->config.rows * m->config.cols;
+    int k = (int)((t / s_interval_us) % keys);
+    uint32_t phase = (uint32_t)(t % s_interval_us);
+    uint32_t half = s_interval_us / 2;
+    bool pressed = phase < half;
+    uint32_t since_edge = pressed ? phase : phase - half;
+    for (int r = 0; r < m->config.rows; r++)
+    {
+        raw[r] = 0;
+    }
+    if (since_edge < s_bounce_us ? rand() & 1 : pressed)
+    {
+        raw[k / m->config.cols] = (uint16_t)(1 << (k % m->config.cols));
+    }
+}
+
+static void sim_matrix_task(void *pvParameters)
+{
+    matrix_t *m = (matrix_t *)pvParameters;
+    uint8_t report[2 + MATRIX_MAX_ROWS * MATRIX_MAX_COLS];
+    size_t report_max = 2 + (size_t)m->config.max_keys;
+    uint32_t period_us = 1000000 / m->config.scan_hz;
+    uint64_t t = 0;
+    uint32_t edges = 0, latency_max_us = 0;
+    TickType_t stats_tick = xTaskGetTickCount();
+    while (1)
+    {
+        vTaskDelay(1);
+        uint64_t end = t + portTICK_PERIOD_MS * 1000;
+        for (; t < end; t += period_us)
+        {
+            uint16_t raw[MATRIX_MAX_ROWS];
+            sim_matrix_read(m, t, raw);
+            if (!matrix_scan(m, raw))
+            {
+                continue;
+            }
+            // 从无抖动的理想边沿算起的去抖延迟:
+            uint32_t latency = (uint32_t)(t % (s_interval_us / 2));
+            latency_max_us = latency > latency_max_us ? latency : latency_max_us;
+            edges++;
+            m->cb(report, matrix_report(m, report, report_max), (uint32_t)esp_timer_get_time(), m->arg);
+        }
+        if (xTaskGetTickCount() - stats_tick >= pdMS_TO_TICKS(5000))
+        {
+            stats_tick = xTaskGetTickCount();
+            ESP_LOGI(TAG, "Matrix: %" PRIu32 " debounced edges, %" PRIu32 " chatter filtered, max latency %" PRIu32 " us",
+                     edges, m->stats.chatter, latency_max_us);
+        }
+    }
+}
+
+void matrix_start(matrix_t *m)
+{
+    const char *env = getenv("SIM_MATRIX_INTERVAL_MS");
+    if (env && atoi(env) > 0)
+    {
+        s_interval_us = atoi(env) * 1000;
+    }
+    env = getenv("SIM_MATRIX_BOUNCE_MS");
+    if (env && atoi(env) >= 0)
+    {
+        s_bounce_us = atoi(env) * 1000;
+    }
+    xTaskCreate(sim_matrix_task, "sim_matrix_task", 4096, m, 10, NULL);
+    ESP_LOGW(TAG, "Matrix %dx%d simulated at %" PRIu32 " Hz, debounce %" PRIu32 " ms, bounce %" PRIu32 " ms",
+             m->config.rows, m->config.cols, m->config.scan_hz, m->config.debounce_ms, s_bounce_us / 1000);
+}
@@ -0,0 +1,161 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "frame.h"
+#include "rs485.h"
+#include "sim_uart.h"
+#include "sim_rs485.h"
+
+#define SIM_RS485_MAX_RECEIVERS 8
+
+static const char *TAG = "SIM";
+
+typedef struct
+{
+    uint8_t addr;
+    int pty_fd;
+    frame_parser_t parser;     // 每个接收端独立解析总线上的全部字节
+    int last_seq;              // 上一个接受的单播帧序号, 重发的帧只应答不重复输出
+    uint32_t frames;
+    uint32_t bytes;
+    uint32_t duplicates;
+    uint32_t acks;
+    uint32_t acks_lost;
+} sim_receiver_t;
+
+static sim_receiver_t s_receivers[SIM_RS485_MAX_RECEIVERS];
+static int s_num_receivers = 0;
+static uart_port_t s_port = UART_NUM_1;
+static bool s_ack = false;
+static int s_ack_loss = 0;
+
+static void sim_receiver_frame(sim_receiver_t *rx)
+{
+    const frame_parser_t *p = &rx->parser;
+    if (p->type != FRAME_TYPE_BUS || p->len < 2)
+    {
+        return;
+    }
+    uint8_t dst = p->payload[0];
+    uint8_t seq = p->payload[1];
+    if (dst != rx->addr && dst != RS485_ADDR_BROADCAST)
+    {
+        return;
+    }
+    if (dst == RS485_ADDR_BROADCAST || seq != rx->last_seq)
+    {
+        rx->frames++;
+        rx->bytes += p->len - 2;
+        ssize_t n = write(rx->pty_fd, &p->payload[2], p->len - 2);
+        (void)n;
+    }
+    else
+    {
+        rx->duplicates++;
+    }
+    if (dst == RS485_ADDR_BROADCAST)
+    {
+        return;
+    }
+    rx->last_seq = seq;
+    if (!s_ack)
+    {
+        return;
+    }
+    if (rand() % 100 < s_ack_loss)
+    {
+        rx->acks_lost++;
+        return;
+    }
+    const uint8_t payload[2] = {rx->addr, seq};
+    uint8_t ack[FRAME_OVERHEAD + 2];
+    size_t len = frame_encode(FRAME_TYPE_ACK, payload, sizeof(payload), ack);
+    sim_uart_inject_rx(s_port, ack, len);
+    rx->acks++;
+}
+
+// 总线上的每个字节到达所有接收端:
+static void sim_bus_tx(const uint8_t *data, size_t len, void *arg)
+{
+    for (int r = 0; r < s_num_receivers; r++)
+    {
+        sim_receiver_t *rx = &s_receivers[r];
+        for (size_t i = 0; i < len; i++)
+        {
+            if (frame_parse_byte(&rx->parser, data[i]))
+            {
+                sim_receiver_frame(rx);
+            }
+        }
+    }
+}
+
+static void sim_stats_task(void *pvParameters)
+{
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(5000));
+        sim_rs485_print_stats();
+    }
+}
+
+void sim_rs485_print_stats(void)
+{
+    for (int r = 0; r < s_num_receivers; r++)
+    {
+        const sim_receiver_t *rx = &s_receivers[r];
+        ESP_LOGI(TAG, "rs485 0x%02X: frames=%" PRIu32 " bytes=%" PRIu32 " duplicates=%" PRIu32
+                      " acks=%" PRIu32 " acks_lost=%" PRIu32 " crc_errors=%" PRIu32,
+                 rx->addr, rx->frames, rx->bytes, rx->duplicates, rx->acks, rx->acks_lost, rx->parser.crc_errors);
+    }
+}
+
+void sim_rs485_start(uart_port_t port, bool ack)
+{
+    const char *env = getenv("SIM_RS485_RECEIVERS");
+    int count = env ? atoi(env) : 4;
+    count = count < 1 ? 1 : (count > SIM_RS485_MAX_RECEIVERS ? SIM_RS485_MAX_RECEIVERS : count);
+    env = getenv("SIM_RS485_ACK_LOSS");
+    if (env)
+    {
+        s_ack_loss = atoi(env);
+    }
+    s_port = port;
+    s_ack = ack;
+
+    for (int r = 0; r < count; r++)
+    {
+        int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+        if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+        {
+            ESP_LOGE(TAG, "Failed to open pty: %d", errno);
+            break;
+        }
+        struct termios tio;
+        if (tcgetattr(fd, &tio) == 0)
+        {
+            cfmakeraw(&tio);
+            tcsetattr(fd, TCSANOW, &tio);
+        }
+        sim_receiver_t *rx = &s_receivers[r];
+        rx->addr = (uint8_t)(r + 1);
+        rx->pty_fd = fd;
+        rx->last_seq = -1;
+        s_num_receivers++;
+        ESP_LOGW(TAG, "RS-485 receiver 0x%02X on %s", rx->addr, ptsname(fd));
+    }
+    sim_uart_set_tx_hook(port, sim_bus_tx, NULL);
+    xTaskCreate(sim_stats_task, "sim_rs485_stats", 4096, NULL, 1, NULL);
+    ESP_LOGW(TAG, "%d RS-485 receiver(s), ACK %s, ACK loss %d%%", s_num_receivers, ack ? "on" : "off", s_ack_loss);
+}
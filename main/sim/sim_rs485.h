@@ -0,0 +1,20 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include "driver/uart.h"
+
+// Linux 仿真的 RS-485 共享总线: 多个虚拟接收端挂在同一个 UART 上, 各自按地址
+// 过滤 FRAME_TYPE_BUS 帧, 收到的数据写入自己的 pty, 开启应答时回送 FRAME_TYPE_ACK.
+//
+// 环境变量:
+//   SIM_RS485_RECEIVERS  虚拟接收端数量, 地址从 0x01 开始 (默认 4, 最多 8)
+//   SIM_RS485_ACK_LOSS   应答丢失的百分比, 用于测试重发 (默认 0)
+
+// 必须在 UART 驱动安装之后调用:
+void sim_rs485_start(uart_port_t port, bool ack);
+
+// 打印每个接收端收到的帧数、重复帧和应答数:
+void sim_rs485_print_stats(void);
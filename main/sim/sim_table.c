@@ -0,0 +1,111 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "table_store.h"
+#include "sim_table.h"
+
+#define SIM_TABLE_SIZE (512 * 1024) // 与 partitions.csv 中的 tables 分区相同
+
+static uint8_t *s_flash = NULL;
+static const char *s_path = NULL;
+static int s_ops_left = -1; // 掉电前剩余的操作数, -1 表示不掉电
+
+// 把修改过的范围写回文件:
+static void sim_table_sync(size_t offset, size_t len)
+{
+    FILE *f = s_path ? fopen(s_path, "r+b") : NULL;
+    if (f == NULL && s_path)
+    {
+        f = fopen(s_path, "w+b");
+        offset = 0;
+        len = SIM_TABLE_SIZE;
+    }
+    if (f != NULL)
+    {
+        fseek(f, (long)offset, SEEK_SET);
+        fwrite(&s_flash[offset], 1, len, f);
+        fclose(f);
+    }
+}
+
+// 是否还有电, 掉电后操作被忽略:
+static bool sim_table_powered(void)
+{
+    if (s_ops_left == 0)
+    {
+        return false;
+    }
+    if (s_ops_left > 0)
+    {
+        s_ops_left--;
+    }
+    return true;
+}
+
+void sim_table_power_cut(int ops)
+{
+    s_ops_left = ops < 0 ? -1 : ops;
+}
+
+bool table_flash_open(size_t *size)
+{
+    if (s_flash == NULL)
+    {
+        s_flash = malloc(SIM_TABLE_SIZE);
+        memset(s_flash, 0xFF, SIM_TABLE_SIZE);
+        s_path = getenv("SIM_TABLES");
+        FILE *f = s_path ? fopen(s_path, "rb") : NULL;
+        if (f != NULL)
+        {
+            fread(s_flash, 1, SIM_TABLE_SIZE, f);
+            fclose(f);
+        }
+    }
+    *size = SIM_TABLE_SIZE;
+    return true;
+}
+
+bool table_flash_erase(size_t offset, size_t len)
+{
+    if (offset % TABLE_SECTOR || len % TABLE_SECTOR || offset + len > SIM_TABLE_SIZE)
+    {
+        return false;
+    }
+    if (sim_table_powered())
+    {
+        memset(&s_flash[offset], 0xFF, len);
+        sim_table_sync(offset, len);
+    }
+    return true;
+}
+
+bool table_flash_write(size_t offset, const void *data, size_t len)
+{
+    if (offset + len > SIM_TABLE_SIZE)
+    {
+        return false;
+    }
+    if (sim_table_powered())
+    {
+        const uint8_t *p = data;
+        for (size_t i = 0; i < len; i++)
+        {
+            s_flash[offset + i] &= p[i];
+        }
+        sim_table_sync(offset, len);
+    }
+    return true;
+}
+
+bool table_flash_read(size_t offset, void *data, size_t len)
+{
+    if (offset + len > SIM_TABLE_SIZE)
+    {
+        return false;
+    }
+    memcpy(data, &s_flash[offset], len);
+    return true;
+}
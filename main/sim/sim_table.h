@@ -0,0 +1,14 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdint.h>
+
+// Linux 仿真的数据表分区: 内存中的 NOR flash, 擦除置 0xFF, 写入只能把 1 变为 0.
+//
+// 环境变量:
+//   SIM_TABLES  分区内容保存到这个文件, 重启仿真后仍然有效 (默认不保存)
+
+// 掉电测试: 再完成 ops 次擦除或写入后, 之后的操作不再改变内容 (仍然返回成功), ops 为负数时恢复:
+void sim_table_power_cut(int ops);
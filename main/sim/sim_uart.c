@@ -0,0 +1,160 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "driver/uart.h"
+#include "sim_uart.h"
+
+#define SIM_UART_RX_INJECT 256 // 注入接收数据的环形缓冲区, 必须是 2 的幂
+
+// 每个 UART 端口对应一个 pty 主端:
+static int s_uart_fd[UART_NUM_MAX] = {-1, -1, -1};
+static size_t s_tx_buffer_size[UART_NUM_MAX];
+static sim_uart_tx_hook_t s_tx_hook[UART_NUM_MAX];
+static void *s_tx_hook_arg[UART_NUM_MAX];
+
+// 注入的接收数据, 写入与读取都在发送任务中:
+typedef struct
+{
+    uint8_t data[SIM_UART_RX_INJECT];
+    uint32_t head;
+    uint32_t tail;
+} sim_rx_ring_t;
+
+static sim_rx_ring_t s_rx_inject[UART_NUM_MAX];
+
+esp_err_t uart_driver_install(uart_port_t uart_num, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, QueueHandle_t *uart_queue, int intr_alloc_flags)
+{
+    if (uart_num < 0 || uart_num >= UART_NUM_MAX)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    int fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0 || grantpt(fd) != 0 || unlockpt(fd) != 0)
+    {
+        ESP_LOGE("SIM", "Failed to open pty: %d", errno);
+        return ESP_FAIL;
+    }
+    // 原始模式, 字节不经行规程转换:
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    s_uart_fd[uart_num] = fd;
+    s_tx_buffer_size[uart_num] = tx_buffer_size;
+    ESP_LOGW("SIM", "UART %d simulated on %s", uart_num, ptsname(fd));
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t uart_num, const uart_config_t *uart_config)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t uart_num, int tx_io_num, int rx_io_num, int rts_io_num, int cts_io_num)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_set_mode(uart_port_t uart_num, uart_mode_t mode)
+{
+    return ESP_OK;
+}
+
+// pty 写入立即完成:
+esp_err_t uart_wait_tx_done(uart_port_t uart_num, TickType_t ticks_to_wait)
+{
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t uart_num, size_t *size)
+{
+    *size = s_rx_inject[uart_num].head - s_rx_inject[uart_num].tail;
+    return ESP_OK;
+}
+
+void sim_uart_set_tx_hook(uart_port_t uart_num, sim_uart_tx_hook_t hook, void *arg)
+{
+    s_tx_hook_arg[uart_num] = arg;
+    s_tx_hook[uart_num] = hook;
+}
+
+void sim_uart_inject_rx(uart_port_t uart_num, const void *data, size_t len)
+{
+    sim_rx_ring_t *ring = &s_rx_inject[uart_num];
+    const uint8_t *src = data;
+    for (size_t i = 0; i < len && ring->head - ring->tail < SIM_UART_RX_INJECT; i++)
+    {
+        ring->data[ring->head++ & (SIM_UART_RX_INJECT - 1)] = src[i];
+    }
+}
+
+int uart_write_bytes(uart_port_t uart_num, const void *src, size_t size)
+{
+    int fd = s_uart_fd[uart_num];
+    if (fd < 0)
+    {
+        return -1;
+    }
+    // 没有接收端时 pty 缓冲写满, 丢弃数据, 与悬空的 TX 线一致:
+    ssize_t n = write(fd, src, size);
+    (void)n;
+    if (s_tx_hook[uart_num] != NULL)
+    {
+        s_tx_hook[uart_num](src, size, s_tx_hook_arg[uart_num]);
+    }
+    return (int)size;
+}
+
+// pty 写入不会阻塞, 环形缓冲区总是空闲:
+esp_err_t uart_get_tx_buffer_free_size(uart_port_t uart_num, size_t *size)
+{
+    *size = s_tx_buffer_size[uart_num];
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t uart_num, void *buf, uint32_t length, TickType_t ticks_to_wait)
+{
+    int fd = s_uart_fd[uart_num];
+    if (fd < 0)
+    {
+        return -1;
+    }
+    sim_rx_ring_t *ring = &s_rx_inject[uart_num];
+    if (ring->head != ring->tail)
+    {
+        uint8_t *dst = buf;
+        uint32_t n = 0;
+        while (n < length && ring->head != ring->tail)
+        {
+            dst[n++] = ring->data[ring->tail++ & (SIM_UART_RX_INJECT - 1)];
+        }
+        return (int)n;
+    }
+    TickType_t start = xTaskGetTickCount();
+    while (1)
+    {
+        ssize_t n = read(fd, buf, length);
+        if (n > 0)
+        {
+            return (int)n;
+        }
+        if (xTaskGetTickCount() - start >= ticks_to_wait)
+        {
+            return 0;
+        }
+        vTaskDelay(1);
+    }
+}
@@ -0,0 +1,17 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/uart.h"
+
+// 仿真专用: 让虚拟外设接入 UART 线路.
+
+// 发送数据在写入 pty 的同时交给 hook, 在调用 uart_write_bytes() 的任务中执行:
+typedef void (*sim_uart_tx_hook_t)(const uint8_t *data, size_t len, void *arg);
+void sim_uart_set_tx_hook(uart_port_t uart_num, sim_uart_tx_hook_t hook, void *arg);
+
+// 向 UART 接收缓冲区注入数据, uart_read_bytes() 先返回注入的数据再读取 pty:
+void sim_uart_inject_rx(uart_port_t uart_num, const void *data, size_t len);
@@ -0,0 +1,982 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+#include <linux/uhid.h>
+#include <malloc.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "usb/usb_host.h"
+#include "usb/hid_host.h"
+#include "usb/hid_host_batch.h"
+#include "usb/hid_host_mem.h"
+#include "Mockusb_host.h"
+#include "sim_uhid.h"
+
+#define SIM_MAX_DEVICES 16  // mock 支持的虚拟键盘数
+#define SIM_UHID_DEVICES 8  // 通过 uhid 创建的虚拟键盘数上限
+#define SIM_VID 0x1209      // pid.codes 测试用 VID
+#define SIM_PID 0x0001
+#define SIM_EP_IN 0x81
+#define SIM_EP_NKRO 0x82    // NKRO 接口的中断 IN 端点
+#define SIM_NKRO_KEYS 120   // NKRO 位图覆盖的键码 0x00 ~ 0x77
+#define SIM_LAT_RING 64     // 在途报告的写入时间戳
+#define SIM_BENCH_DEVICES 8 // 投递开销测试的虚拟键盘数
+#define SIM_BUDGET_DEVICES 16 // 内存预算测试的虚拟键盘数
+#define SIM_BENCH_ROUNDS 20000
+#define SIM_FLOOD_BURST 5       // 失控的键盘每个节拍发送的按下与释放次数, 约 1000 份报告每秒
+
+static const char *TAG = "SIM";
+
+// 标准 Boot 键盘报告描述符 (HID 1.11 附录 B.1):
+static const uint8_t s_report_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01,
+    0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x01, 0x95, 0x05, 0x75, 0x01,
+    0x05, 0x08, 0x19, 0x01, 0x29, 0x05, 0x91, 0x02, 0x95, 0x01, 0x75, 0x03, 0x91, 0x01, 0x95, 0x06,
+    0x75, 0x08, 0x15, 0x00, 0x25, 0x65, 0x05, 0x07, 0x19, 0x00, 0x29, 0x65, 0x81, 0x00, 0xC0};
+
+// NKRO 键盘报告描述符: 报告 ID 1, 8 位修饰键, 120 位按键位图:
+static const uint8_t s_nkro_report_desc[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01, 0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00,
+    0x25, 0x01, 0x75, 0x01, 0x95, 0x08, 0x81, 0x02, 0x19, 0x00, 0x29, SIM_NKRO_KEYS - 1, 0x95, SIM_NKRO_KEYS,
+    0x81, 0x02, 0xC0};
+
+static const uint8_t s_device_desc[18] = {
+    0x12, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x08,
+    SIM_VID & 0xFF, SIM_VID >> 8, SIM_PID & 0xFF, SIM_PID >> 8, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01};
+
+// 配置描述符: 1 个 Boot 键盘接口, 1 个中断 IN 端点 (8 字节, 10 ms):
+static const uint8_t s_config_desc[34] = {
+    0x09, 0x02, 34, 0x00, 0x01, 0x01, 0x00, 0xA0, 0x32,
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x01, 0x00,
+    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, sizeof(s_report_desc), 0x00,
+    0x07, 0x05, SIM_EP_IN, 0x03, 0x08, 0x00, 0x0A};
+
+// 带 NKRO 接口的配置描述符: 接口 0 同上, 接口 1 为非 Boot 键盘 (32 字节, 1 ms):
+static const uint8_t s_config_desc_nkro[59] = {
+    0x09, 0x02, 59, 0x00, 0x02, 0x01, 0x00, 0xA0, 0x32,
+    0x09, 0x04, 0x00, 0x00, 0x01, 0x03, 0x01, 0x01, 0x00,
+    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, sizeof(s_report_desc), 0x00,
+    0x07, 0x05, SIM_EP_IN, 0x03, 0x08, 0x00, 0x0A,
+    0x09, 0x04, 0x01, 0x00, 0x01, 0x03, 0x00, 0x00, 0x00,
+    0x09, 0x21, 0x11, 0x01, 0x00, 0x01, 0x22, sizeof(s_nkro_report_desc), 0x00,
+    0x07, 0x05, SIM_EP_NKRO, 0x03, 0x20, 0x00, 0x01};
+
+typedef struct
+{
+    int uhid_fd;
+    int hidraw_fd;
+    int evdev_fd;
+    uint8_t addr;
+    bool announced;             // 是否已向 HID 驱动报告 NEW_DEV
+    bool unplugged;             // 热插拔测试: 已拔出, 下次处理事件时报告 DEV_GONE
+    usb_transfer_t *in_xfer;    // HID 驱动提交、等待完成的 IN 传输
+    usb_transfer_t *nkro_xfer;  // NKRO 接口的 IN 传输
+    char uniq[64];
+    uint64_t sent_us[SIM_LAT_RING];
+    uint32_t sent_head;
+    uint32_t sent_tail;
+    uint32_t reports;
+    uint32_t nkro_reports;
+    uint32_t dropped;           // 驱动未提交 IN 传输时到达的报告
+    uint64_t lat_sum_us;
+    uint32_t lat_min_us;
+    uint32_t lat_max_us;
+} sim_dev_t;
+
+static sim_dev_t s_devs[SIM_MAX_DEVICES];
+static int s_num_devs = 0;
+static int s_interval_ms = 20;
+static const char *s_text = "hello world\n";
+static bool s_nkro = false;     // 每个虚拟键盘同时提供 NKRO 接口
+static int s_nkro_stall_ms = 0; // NKRO 接口在启动多久后停止报告, 0 表示不停止
+static int s_flood_ms = 0;      // 最后一个虚拟键盘在启动多久后失控连续报告, 0 表示不失控
+static uint64_t s_start_us = 0;
+static bool s_bench = false;    // 投递开销测试: 不使用 uhid, 每轮为每个设备合成一份报告
+static uint32_t s_xfers_live = 0; // mock 分配尚未释放的传输
+static usb_host_client_event_cb_t s_client_cb = NULL;
+static void *s_client_arg = NULL;
+
+static uint64_t sim_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + ts.tv_nsec / 1000u;
+}
+
+static sim_dev_t *sim_dev_from_handle(usb_device_handle_t dev_hdl)
+{
+    return (sim_dev_t *)dev_hdl;
+}
+
+// ASCII 转 Boot 键盘键码, 仅覆盖文本生成器需要的字符:
+static uint8_t sim_ascii_to_keycode(char c, uint8_t *mod)
+{
+    *mod = 0;
+    if (c >= 'a' && c <= 'z')
+    {
+        return 0x04 + (c - 'a');
+    }
+    if (c >= 'A' && c <= 'Z')
+    {
+        *mod = 0x02;
+        return 0x04 + (c - 'A');
+    }
+    if (c >= '1' && c <= '9')
+    {
+        return 0x1E + (c - '1');
+    }
+    switch (c)
+    {
+    case '0':
+        return 0x27;
+    case '\n':
+        return 0x28;
+    case ' ':
+        return 0x2C;
+    case '-':
+        return 0x2D;
+    case '.':
+        return 0x37;
+    default:
+        return 0;
+    }
+}
+
+// ----------------------------- uhid -----------------------------
+
+static int sim_uhid_write(int fd, const struct uhid_event *ev)
+{
+    ssize_t n = write(fd, ev, sizeof(*ev));
+    return n == (ssize_t)sizeof(*ev) ? 0 : -1;
+}
+
+static int sim_uhid_send_report(sim_dev_t *dev, const uint8_t report[8])
+{
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_INPUT2;
+    ev.u.input2.size = 8;
+    memcpy(ev.u.input2.data, report, 8);
+    dev->sent_us[dev->sent_head % SIM_LAT_RING] = sim_now_us();
+    if (sim_uhid_write(dev->uhid_fd, &ev) != 0)
+    {
+        return -1;
+    }
+    dev->sent_head++;
+    return 0;
+}
+
+// 处理内核发往虚拟设备的请求, GET/SET_REPORT 必须应答, 否则内核会等待超时:
+static void sim_uhid_service(sim_dev_t *dev)
+{
+    struct uhid_event ev;
+    while (read(dev->uhid_fd, &ev, sizeof(ev)) > 0)
+    {
+        struct uhid_event rsp;
+        memset(&rsp, 0, sizeof(rsp));
+        if (ev.type == UHID_GET_REPORT)
+        {
+            rsp.type = UHID_GET_REPORT_REPLY;
+            rsp.u.get_report_reply.id = ev.u.get_report.id;
+            rsp.u.get_report_reply.err = EIO;
+            sim_uhid_write(dev->uhid_fd, &rsp);
+        }
+        else if (ev.type == UHID_SET_REPORT)
+        {
+            rsp.type = UHID_SET_REPORT_REPLY;
+            rsp.u.set_report_reply.id = ev.u.set_report.id;
+            sim_uhid_write(dev->uhid_fd, &rsp);
+        }
+    }
+}
+
+// 在 sysfs 中按 HID_UNIQ 找到内核为虚拟设备创建的 hidraw 节点:
+static int sim_find_hidraw(const sim_dev_t *dev, char *node, size_t node_len, char *sys, size_t sys_len)
+{
+    DIR *dir = opendir("/sys/class/hidraw");
+    if (dir == NULL)
+    {
+        return -1;
+    }
+    char want[80];
+    snprintf(want, sizeof(want), "HID_UNIQ=%s\n", dev->uniq);
+    struct dirent *de;
+    int found = -1;
+    while (found != 0 && (de = readdir(dir)) != NULL)
+    {
+        if (strncmp(de->d_name, "hidraw", 6) != 0)
+        {
+            continue;
+        }
+        char path[300];
+        snprintf(path, sizeof(path), "/sys/class/hidraw/%s/device/uevent", de->d_name);
+        FILE *f = fopen(path, "r");
+        if (f == NULL)
+        {
+            continue;
+        }
+        char line[128];
+        while (fgets(line, sizeof(line), f) != NULL)
+        {
+            if (strcmp(line, want) == 0)
+            {
+                snprintf(node, node_len, "/dev/%s", de->d_name);
+                snprintf(sys, sys_len, "/sys/class/hidraw/%s/device/input", de->d_name);
+                found = 0;
+                break;
+            }
+        }
+        fclose(f);
+    }
+    closedir(dir);
+    return found;
+}
+
+// 独占虚拟键盘对应的 evdev 节点, 防止模拟按键输入到宿主机桌面:
+static int sim_grab_evdev(const char *input_dir)
+{
+    DIR *dir = opendir(input_dir);
+    if (dir == NULL)
+    {
+        return -1;
+    }
+    struct dirent *de;
+    int fd = -1;
+    while (fd < 0 && (de = readdir(dir)) != NULL)
+    {
+        if (strncmp(de->d_name, "input", 5) != 0)
+        {
+            continue;
+        }
+        char path[300];
+        snprintf(path, sizeof(path), "%s/%s", input_dir, de->d_name);
+        DIR *sub = opendir(path);
+        if (sub == NULL)
+        {
+            continue;
+        }
+        struct dirent *ev;
+        while ((ev = readdir(sub)) != NULL)
+        {
+            if (strncmp(ev->d_name, "event", 5) == 0)
+            {
+                char node[300];
+                snprintf(node, sizeof(node), "/dev/input/%s", ev->d_name);
+                fd = open(node, O_RDONLY | O_NONBLOCK);
+                if (fd >= 0 && ioctl(fd, EVIOCGRAB, 1) != 0)
+                {
+                    close(fd);
+                    fd = -1;
+                }
+                break;
+            }
+        }
+        closedir(sub);
+    }
+    closedir(dir);
+    return fd;
+}
+
+static int sim_create_device(sim_dev_t *dev, int index)
+{
+    dev->uhid_fd = open("/dev/uhid", O_RDWR | O_CLOEXEC | O_NONBLOCK);
+    if (dev->uhid_fd < 0)
+    {
+        ESP_LOGE(TAG, "Failed to open /dev/uhid: %s", strerror(errno));
+        return -1;
+    }
+    snprintf(dev->uniq, sizeof(dev->uniq), "usbkbd-sim-%d-%d", (int)getpid(), index);
+
+    struct uhid_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.type = UHID_CREATE2;
+    snprintf((char *)ev.u.create2.name, sizeof(ev.u.create2.name), "USB Keyboard Sim %d", index);
+    snprintf((char *)ev.u.create2.uniq, sizeof(ev.u.create2.uniq), "%s", dev->uniq);
+    memcpy(ev.u.create2.rd_data, s_report_desc, sizeof(s_report_desc));
+    ev.u.create2.rd_size = sizeof(s_report_desc);
+    ev.u.create2.bus = BUS_USB;
+    ev.u.create2.vendor = SIM_VID;
+    ev.u.create2.product = SIM_PID;
+    if (sim_uhid_write(dev->uhid_fd, &ev) != 0)
+    {
+        ESP_LOGE(TAG, "UHID_CREATE2 failed: %s", strerror(errno));
+        return -1;
+    }
+
+    // 等待内核完成 hid-generic 绑定并创建 hidraw 节点:
+    char node[64];
+    char input_dir[300];
+    for (int retry = 0; retry < 100; retry++)
+    {
+        sim_uhid_service(dev);
+        if (sim_find_hidraw(dev, node, sizeof(node), input_dir, sizeof(input_dir)) == 0)
+        {
+            dev->hidraw_fd = open(node, O_RDONLY | O_NONBLOCK);
+            break;
+        }
+        usleep(10 * 1000);
+    }
+    if (dev->hidraw_fd < 0)
+    {
+        ESP_LOGE(TAG, "No hidraw node for %s", dev->uniq);
+        return -1;
+    }
+    dev->evdev_fd = sim_grab_evdev(input_dir);
+    if (dev->evdev_fd < 0)
+    {
+        ESP_LOGW(TAG, "Failed to grab evdev for %s, key events may reach the desktop", dev->uniq);
+    }
+    dev->addr = index + 1;
+    dev->lat_min_us = UINT32_MAX;
+    ESP_LOGI(TAG, "Virtual keyboard %d: %s", index, node);
+    return 0;
+}
+
+// 每个虚拟键盘一个生成任务, 按间隔循环输入文本 (按下 + 释放两份报告):
+static void sim_typing_task(void *pvParameters)
+{
+    sim_dev_t *dev = (sim_dev_t *)pvParameters;
+    const uint8_t release[8] = {0};
+    size_t pos = 0;
+    while (1)
+    {
+        sim_uhid_service(dev);
+        if (s_flood_ms > 0 && dev == &s_devs[s_num_devs - 1] &&
+            sim_now_us() - s_start_us >= (uint64_t)s_flood_ms * 1000)
+        {
+            // 失控: 同一个键以接近轮询速率的频率反复按下释放:
+            const uint8_t press[8] = {0, 0, 0x1B, 0, 0, 0, 0, 0};
+            for (int i = 0; i < SIM_FLOOD_BURST; i++)
+            {
+                sim_uhid_send_report(dev, press);
+                sim_uhid_send_report(dev, release);
+            }
+            vTaskDelay(1);
+            continue;
+        }
+        uint8_t mod;
+        uint8_t key = sim_ascii_to_keycode(s_text[pos], &mod);
+        pos = s_text[pos + 1] ? pos + 1 : 0;
+        if (key != 0)
+        {
+            uint8_t press[8] = {mod, 0, key, 0, 0, 0, 0, 0};
+            sim_uhid_send_report(dev, press);
+            vTaskDelay(pdMS_TO_TICKS(s_interval_ms));
+            sim_uhid_send_report(dev, release);
+        }
+        vTaskDelay(pdMS_TO_TICKS(s_interval_ms));
+    }
+}
+
+// ----------------------- USB Host mock 回调 -----------------------
+
+// 完成一个等待中的 IN 传输, 驱动没有提交传输时返回 false:
+static bool sim_complete_in(usb_transfer_t **slot, const uint8_t *data, size_t len)
+{
+    usb_transfer_t *xfer = *slot;
+    if (xfer == NULL)
+    {
+        return false;
+    }
+    *slot = NULL;
+    size_t n = len < xfer->data_buffer_size ? len : xfer->data_buffer_size;
+    memcpy(xfer->data_buffer, data, n);
+    xfer->actual_num_bytes = n;
+    xfer->status = USB_TRANSFER_STATUS_COMPLETED;
+    // HID 驱动在回调中重新提交传输:
+    xfer->callback(xfer);
+    return true;
+}
+
+static void sim_deliver_report(sim_dev_t *dev, const uint8_t *data, size_t len)
+{
+    uint64_t now = sim_now_us();
+    if (dev->sent_tail != dev->sent_head)
+    {
+        uint32_t lat = (uint32_t)(now - dev->sent_us[dev->sent_tail % SIM_LAT_RING]);
+        dev->sent_tail++;
+        dev->lat_sum_us += lat;
+        dev->lat_min_us = lat < dev->lat_min_us ? lat : dev->lat_min_us;
+        dev->lat_max_us = lat > dev->lat_max_us ? lat : dev->lat_max_us;
+    }
+    if (!sim_complete_in(&dev->in_xfer, data, len))
+    {
+        dev->dropped++;
+        return;
+    }
+    dev->reports++;
+    if (s_nkro && (s_nkro_stall_ms == 0 || now - s_start_us < (uint64_t)s_nkro_stall_ms * 1000))
+    {
+        // 同一次按键变化也从 NKRO 接口报告, 与真实的双接口键盘一样:
+        uint8_t nkro[2 + SIM_NKRO_KEYS / 8] = {0x01, len > 0 ? data[0] : 0};
+        for (size_t i = 2; i < len && i < 8; i++)
+        {
+            if (data[i] != 0 && data[i] < SIM_NKRO_KEYS)
+            {
+                nkro[2 + data[i] / 8] |= (uint8_t)(1 << (data[i] % 8));
+            }
+        }
+        dev->nkro_reports += sim_complete_in(&dev->nkro_xfer, nkro, sizeof(nkro));
+    }
+}
+
+static esp_err_t sim_host_install(const usb_host_config_t *config, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t sim_lib_handle_events(TickType_t timeout_ticks, uint32_t *event_flags_ret, int cmock_num_calls)
+{
+    vTaskDelay(timeout_ticks == portMAX_DELAY ? pdMS_TO_TICKS(1000) : timeout_ticks);
+    if (event_flags_ret)
+    {
+        *event_flags_ret = 0;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_client_register(const usb_host_client_config_t *client_config,
+                                     usb_host_client_handle_t *client_hdl_ret, int cmock_num_calls)
+{
+    s_client_cb = client_config->async.client_event_callback;
+    s_client_arg = client_config->async.callback_arg;
+    *client_hdl_ret = (usb_host_client_handle_t)&s_client_cb;
+    return ESP_OK;
+}
+
+static esp_err_t sim_client_ok(usb_host_client_handle_t client_hdl, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+// HID 驱动后台任务循环调用: 先通报设备的插拔, 再把 hidraw 上已到达的报告完成到 IN 传输:
+static esp_err_t sim_client_handle_events(usb_host_client_handle_t client_hdl, TickType_t timeout_ticks,
+                                          int cmock_num_calls)
+{
+    for (int i = 0; i < s_num_devs; i++)
+    {
+        if (s_devs[i].announced && s_devs[i].unplugged && s_client_cb)
+        {
+            s_devs[i].announced = false;
+            usb_host_client_event_msg_t msg = {
+                .event = USB_HOST_CLIENT_EVENT_DEV_GONE,
+                .dev_gone.dev_hdl = (usb_device_handle_t)&s_devs[i]};
+            s_client_cb(&msg, s_client_arg);
+        }
+        else if (!s_devs[i].announced && !s_devs[i].unplugged && s_client_cb)
+        {
+            s_devs[i].announced = true;
+            usb_host_client_event_msg_t msg = {
+                .event = USB_HOST_CLIENT_EVENT_NEW_DEV,
+                .new_dev.address = s_devs[i].addr};
+            s_client_cb(&msg, s_client_arg);
+        }
+    }
+
+    if (s_bench)
+    {
+        // 相当于所有键盘在同一个 1 ms 帧内都有报告, 交替按下与释放:
+        static uint8_t report[8];
+        report[2] = report[2] ? 0 : 0x04;
+        for (int i = 0; i < s_num_devs; i++)
+        {
+            if (!s_devs[i].unplugged)
+            {
+                sim_deliver_report(&s_devs[i], report, sizeof(report));
+            }
+        }
+        return ESP_OK;
+    }
+
+    struct pollfd pfd[SIM_MAX_DEVICES];
+    for (int i = 0; i < s_num_devs; i++)
+    {
+        pfd[i].fd = s_devs[i].hidraw_fd;
+        pfd[i].events = POLLIN;
+        pfd[i].revents = 0;
+    }
+    int ready = poll(pfd, s_num_devs, 0);
+    for (int i = 0; i < s_num_devs && ready > 0; i++)
+    {
+        if (pfd[i].revents & POLLIN)
+        {
+            uint8_t report[64];
+            ssize_t n;
+            while ((n = read(pfd[i].fd, report, sizeof(report))) > 0)
+            {
+                sim_deliver_report(&s_devs[i], report, (size_t)n);
+            }
+        }
+    }
+    if (ready <= 0)
+    {
+        vTaskDelay(1);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_device_open(usb_host_client_handle_t client_hdl, uint8_t dev_addr,
+                                 usb_device_handle_t *dev_hdl_ret, int cmock_num_calls)
+{
+    if (dev_addr == 0 || dev_addr > s_num_devs)
+    {
+        return ESP_ERR_NOT_FOUND;
+    }
+    *dev_hdl_ret = (usb_device_handle_t)&s_devs[dev_addr - 1];
+    return ESP_OK;
+}
+
+static esp_err_t sim_device_close(usb_host_client_handle_t client_hdl, usb_device_handle_t dev_hdl,
+                                  int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t sim_device_info(usb_device_handle_t dev_hdl, usb_device_info_t *dev_info, int cmock_num_calls)
+{
+    memset(dev_info, 0, sizeof(*dev_info));
+    dev_info->dev_addr = sim_dev_from_handle(dev_hdl)->addr;
+    dev_info->bMaxPacketSize0 = 8;
+    dev_info->bConfigurationValue = 1;
+    return ESP_OK;
+}
+
+static esp_err_t sim_get_device_descriptor(usb_device_handle_t dev_hdl, const usb_device_desc_t **device_desc,
+                                           int cmock_num_calls)
+{
+    *device_desc = (const usb_device_desc_t *)s_device_desc;
+    return ESP_OK;
+}
+
+static esp_err_t sim_get_config_descriptor(usb_device_handle_t dev_hdl, const usb_config_desc_t **config_desc,
+                                           int cmock_num_calls)
+{
+    *config_desc = (const usb_config_desc_t *)(s_nkro ? s_config_desc_nkro : s_config_desc);
+    return ESP_OK;
+}
+
+static esp_err_t sim_interface_claim(usb_host_client_handle_t client_hdl, usb_device_handle_t dev_hdl,
+                                     uint8_t bInterfaceNumber, uint8_t bAlternateSetting, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t sim_interface_release(usb_host_client_handle_t client_hdl, usb_device_handle_t dev_hdl,
+                                       uint8_t bInterfaceNumber, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+// 端点 halt/flush 取消挂起的 IN 传输, clear 不需要处理:
+static esp_err_t sim_endpoint_flush(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, int cmock_num_calls)
+{
+    if (bEndpointAddress == SIM_EP_IN)
+    {
+        sim_dev_from_handle(dev_hdl)->in_xfer = NULL;
+    }
+    else if (bEndpointAddress == SIM_EP_NKRO)
+    {
+        sim_dev_from_handle(dev_hdl)->nkro_xfer = NULL;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_endpoint_ok(usb_device_handle_t dev_hdl, uint8_t bEndpointAddress, int cmock_num_calls)
+{
+    return ESP_OK;
+}
+
+static esp_err_t sim_transfer_alloc(size_t data_buffer_size, int num_isoc_packets, usb_transfer_t **transfer,
+                                    int cmock_num_calls)
+{
+    uint8_t *buf = calloc(1, data_buffer_size);
+    usb_transfer_t *xfer = calloc(1, sizeof(usb_transfer_t));
+    if (buf == NULL || xfer == NULL)
+    {
+        free(buf);
+        free(xfer);
+        return ESP_ERR_NO_MEM;
+    }
+    // data_buffer / data_buffer_size 是 const 成员, 通过初始化后整体复制赋值:
+    usb_transfer_t init = {.data_buffer = buf, .data_buffer_size = data_buffer_size};
+    memcpy(xfer, &init, sizeof(init));
+    *transfer = xfer;
+    s_xfers_live++;
+    return ESP_OK;
+}
+
+static esp_err_t sim_transfer_free(usb_transfer_t *transfer, int cmock_num_calls)
+{
+    if (transfer)
+    {
+        free(transfer->data_buffer);
+        free(transfer);
+        s_xfers_live--;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t sim_transfer_submit(usb_transfer_t *transfer, int cmock_num_calls)
+{
+    sim_dev_t *dev = sim_dev_from_handle(transfer->device_handle);
+    if (transfer->bEndpointAddress == SIM_EP_IN)
+    {
+        dev->in_xfer = transfer;
+    }
+    else if (transfer->bEndpointAddress == SIM_EP_NKRO && s_nkro)
+    {
+        dev->nkro_xfer = transfer;
+    }
+    else
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ESP_OK;
+}
+
+// 控制传输立即完成: 仅 GET_DESCRIPTOR(Report) 按接口号返回数据, 其余类请求直接应答:
+static esp_err_t sim_transfer_submit_control(usb_host_client_handle_t client_hdl, usb_transfer_t *transfer,
+                                             int cmock_num_calls)
+{
+    const usb_setup_packet_t *setup = (const usb_setup_packet_t *)transfer->data_buffer;
+    transfer->actual_num_bytes = USB_SETUP_PACKET_SIZE;
+    if (setup->bRequest == 0x06 && (setup->wValue >> 8) == 0x22)
+    {
+        const uint8_t *desc = setup->wIndex == 1 ? s_nkro_report_desc : s_report_desc;
+        size_t size = setup->wIndex == 1 ? sizeof(s_nkro_report_desc) : sizeof(s_report_desc);
+        size_t len = setup->wLength < size ? setup->wLength : size;
+        memcpy(transfer->data_buffer + USB_SETUP_PACKET_SIZE, desc, len);
+        transfer->actual_num_bytes += len;
+    }
+    transfer->status = USB_TRANSFER_STATUS_COMPLETED;
+    transfer->callback(transfer);
+    return ESP_OK;
+}
+
+// ----------------------------- Public -----------------------------
+
+static void sim_stats_task(void *pvParameters)
+{
+    while (1)
+    {
+        vTaskDelay(pdMS_TO_TICKS(5000));
+        sim_uhid_print_stats();
+    }
+}
+
+void sim_uhid_print_stats(void)
+{
+    for (int i = 0; i < s_num_devs; i++)
+    {
+        const sim_dev_t *dev = &s_devs[i];
+        uint32_t n = dev->reports + dev->dropped;
+        ESP_LOGI(TAG, "kbd %d: reports=%" PRIu32 " nkro=%" PRIu32 " dropped=%" PRIu32
+                      " latency us min/avg/max=%" PRIu32 "/%" PRIu64 "/%" PRIu32,
+                 i, dev->reports, dev->nkro_reports, dev->dropped,
+                 n ? dev->lat_min_us : 0, n ? dev->lat_sum_us / n : 0, dev->lat_max_us);
+    }
+}
+
+static void sim_install_mock(void)
+{
+    usb_host_install_Stub(sim_host_install);
+    usb_host_lib_handle_events_Stub(sim_lib_handle_events);
+    usb_host_client_register_Stub(sim_client_register);
+    usb_host_client_deregister_Stub(sim_client_ok);
+    usb_host_client_unblock_Stub(sim_client_ok);
+    usb_host_client_handle_events_Stub(sim_client_handle_events);
+    usb_host_device_open_Stub(sim_device_open);
+    usb_host_device_close_Stub(sim_device_close);
+    usb_host_device_info_Stub(sim_device_info);
+    usb_host_get_device_descriptor_Stub(sim_get_device_descriptor);
+    usb_host_get_active_config_descriptor_Stub(sim_get_config_descriptor);
+    usb_host_interface_claim_Stub(sim_interface_claim);
+    usb_host_interface_release_Stub(sim_interface_release);
+    usb_host_endpoint_halt_Stub(sim_endpoint_ok);
+    usb_host_endpoint_flush_Stub(sim_endpoint_flush);
+    usb_host_endpoint_clear_Stub(sim_endpoint_ok);
+    usb_host_transfer_alloc_Stub(sim_transfer_alloc);
+    usb_host_transfer_free_Stub(sim_transfer_free);
+    usb_host_transfer_submit_Stub(sim_transfer_submit);
+    usb_host_transfer_submit_control_Stub(sim_transfer_submit_control);
+}
+
+// ------------------------- 报告投递开销 -------------------------
+
+static uint32_t s_bench_reports = 0;
+static uint32_t s_bench_sum = 0;
+
+// 逐份回调: 与应用相同, 先按句柄取出报告数据再处理:
+static void sim_bench_iface_cb(hid_host_device_handle_t hid_device_handle, const hid_host_interface_event_t event,
+                               void *arg)
+{
+    if (event == HID_HOST_INTERFACE_EVENT_DISCONNECTED)
+    {
+        hid_host_device_close(hid_device_handle);
+        return;
+    }
+    if (event != HID_HOST_INTERFACE_EVENT_INPUT_REPORT)
+    {
+        return;
+    }
+    uint8_t report[64];
+    size_t len;
+    if (hid_host_device_get_raw_input_report_data(hid_device_handle, report, sizeof(report), &len) == ESP_OK)
+    {
+        s_bench_sum += report[2];
+        s_bench_reports++;
+    }
+}
+
+static void sim_bench_batch_cb(const hid_host_report_t *reports, size_t count, void *arg)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (reports[i].data != NULL)
+        {
+            s_bench_sum += reports[i].data[2];
+            s_bench_reports++;
+        }
+    }
+}
+
+static void sim_bench_driver_cb(hid_host_device_handle_t hid_device_handle, const hid_host_driver_event_t event,
+                                void *arg)
+{
+    if (event == HID_HOST_DRIVER_EVENT_CONNECTED)
+    {
+        const hid_host_device_config_t config = {.callback = sim_bench_iface_cb};
+        hid_host_device_open(hid_device_handle, &config);
+        // 与键盘驱动一样在启动前发送类请求, 经过共享的 EP0 传输:
+        hid_class_request_set_idle(hid_device_handle, 0, 0);
+        hid_host_device_start(hid_device_handle);
+    }
+}
+
+// 以给定投递方式运行若干轮, 返回每份报告的平均时间 (含 mock 完成传输的开销):
+static double sim_bench_run_rounds(void)
+{
+    s_bench_reports = 0;
+    uint64_t t0 = sim_now_us();
+    for (int r = 0; r < SIM_BENCH_ROUNDS; r++)
+    {
+        hid_host_handle_events(0);
+    }
+    uint64_t t1 = sim_now_us();
+    if (s_bench_reports != (uint32_t)(SIM_BENCH_ROUNDS * s_num_devs))
+    {
+        printf("BENCH hid_delivery: FAILED, %" PRIu32 " of %d reports delivered\n",
+               s_bench_reports, SIM_BENCH_ROUNDS * s_num_devs);
+        exit(1);
+    }
+    return (t1 - t0) * 1000.0 / s_bench_reports;
+}
+
+void sim_uhid_bench(void)
+{
+    sim_install_mock();
+    s_bench = true;
+    s_num_devs = SIM_BENCH_DEVICES;
+    for (int i = 0; i < s_num_devs; i++)
+    {
+        s_devs[i].hidraw_fd = -1;
+        s_devs[i].evdev_fd = -1;
+        s_devs[i].addr = i + 1;
+    }
+    const hid_host_driver_config_t config = {
+        .create_background_task = false,
+        .callback = sim_bench_driver_cb};
+    hid_host_install(&config);
+    // 第一轮通报设备, 驱动枚举并由回调打开接口:
+    hid_host_handle_events(0);
+
+    double single_ns = sim_bench_run_rounds();
+    hid_host_set_report_batch_callback(sim_bench_batch_cb, NULL, HID_HOST_REPORT_BATCH_MAX);
+    double batch_ns = sim_bench_run_rounds();
+    hid_host_set_report_batch_callback(NULL, NULL, 1);
+    printf("BENCH hid_delivery: %d devices x %d reports, %.1f ns/report per-report callback, "
+           "%.1f ns/report batched (%.1fx)\n",
+           s_num_devs, SIM_BENCH_ROUNDS, single_ns, batch_ns, single_ns / batch_ns);
+}
+
+// ------------------------- 热插拔内存 -------------------------
+
+// 拔出所有虚拟键盘并等驱动处理完 DEV_GONE:
+static void sim_churn_unplug_all(void)
+{
+    for (int i = 0; i < s_num_devs; i++)
+    {
+        s_devs[i].unplugged = true;
+    }
+    hid_host_handle_events(0);
+}
+
+static void sim_churn_check(bool ok, const char *what)
+{
+    if (!ok)
+    {
+        printf("BENCH hid_churn: FAILED, %s\n", what);
+        exit(1);
+    }
+}
+
+void sim_uhid_churn(int cycles)
+{
+    // 基准: 所有设备拔出, 驱动只剩安装时的分配与共享的 EP0 传输:
+    sim_churn_unplug_all();
+    hid_host_mem_stats_t base;
+    hid_host_get_mem_stats(&base);
+    uint32_t xfers_base = s_xfers_live;
+    sim_churn_check(base.devices == 0 && s_xfers_live <= 2, "transfers left after unplugging all devices");
+
+    uint32_t seed = 0x2545F491;
+    uint32_t plugs = 0;
+    uint32_t nkro_switches = 0;
+    size_t heap_warm = 0;
+    size_t heap_peak = 0;
+    for (int c = 0; c < cycles; c++)
+    {
+        // xorshift32, 结果可重复:
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        sim_dev_t *dev = &s_devs[seed % s_num_devs];
+        dev->unplugged = !dev->unplugged;
+        plugs += !dev->unplugged;
+        hid_host_handle_events(0);
+        bool all_unplugged = true;
+        for (int i = 0; i < s_num_devs; i++)
+        {
+            all_unplugged = all_unplugged && s_devs[i].unplugged;
+        }
+        if (all_unplugged)
+        {
+            // 全部拔出后切换配置描述符, 接口数与报告描述符大小随之变化:
+            s_nkro = !s_nkro;
+            nkro_switches++;
+        }
+        size_t used = mallinfo2().uordblks;
+        if (c == cycles / 10)
+        {
+            heap_warm = used;
+        }
+        heap_peak = used > heap_peak ? used : heap_peak;
+    }
+
+    sim_churn_unplug_all();
+    s_nkro = false;
+    hid_host_mem_stats_t end;
+    hid_host_get_mem_stats(&end);
+    size_t heap_end = mallinfo2().uordblks;
+    sim_churn_check(end.driver.current == base.driver.current && end.usb.current == base.usb.current,
+                    "HID driver memory did not return to baseline");
+    sim_churn_check(end.driver.allocs - base.driver.allocs == end.driver.frees - base.driver.frees &&
+                        end.usb.allocs - base.usb.allocs == end.usb.frees - base.usb.frees,
+                    "allocation and free counts differ");
+    sim_churn_check(s_xfers_live == xfers_base, "transfers leaked in the USB Host mock");
+    sim_churn_check(heap_end <= heap_warm, "heap in use grew after warm-up");
+    printf("BENCH hid_churn: %d cycles (%" PRIu32 " plugs, %" PRIu32 " NKRO switches), driver %u bytes "
+           "(peak %u, %" PRIu32 " allocs = frees), transfers %u bytes (peak %u, %" PRIu32 " allocs = frees), "
+           "heap in use %zu -> %zu bytes (peak %zu)\n",
+           cycles, plugs, nkro_switches, (unsigned)end.driver.current, (unsigned)end.driver.peak,
+           end.driver.allocs - base.driver.allocs, (unsigned)end.usb.current, (unsigned)end.usb.peak,
+           end.usb.allocs - base.usb.allocs, heap_warm, heap_end, heap_peak);
+}
+
+// ------------------------- 多设备内存预算 -------------------------
+
+void sim_uhid_budget(size_t budget)
+{
+    sim_churn_unplug_all();
+    hid_host_mem_stats_t base;
+    hid_host_get_mem_stats(&base);
+
+    // 16 个双接口键盘 (Boot + NKRO) 同时连接:
+    s_num_devs = SIM_BUDGET_DEVICES;
+    s_nkro = true;
+    for (int i = 0; i < s_num_devs; i++)
+    {
+        s_devs[i].hidraw_fd = -1;
+        s_devs[i].evdev_fd = -1;
+        s_devs[i].addr = i + 1;
+        s_devs[i].unplugged = false;
+    }
+    hid_host_handle_events(0);
+    hid_host_mem_stats_t st;
+    hid_host_get_mem_stats(&st);
+    size_t used = st.driver.current + st.usb.current - (base.driver.current + base.usb.current) + base.ep0_bytes;
+    // 每个设备各自在连接时分配 EP0 传输 (HID_MIN_REPORT_DESC_LEN) 与两个信号量时的用量:
+    size_t eager = st.device_bytes + s_num_devs * (2 * sizeof(StaticSemaphore_t) + sizeof(usb_transfer_t) + 512);
+
+    sim_churn_unplug_all();
+    s_nkro = false;
+    s_num_devs = SIM_BENCH_DEVICES;
+    sim_churn_check(st.devices == SIM_BUDGET_DEVICES, "not all devices connected");
+    sim_churn_check(used == st.device_bytes + st.ep0_bytes, "per-device report does not add up");
+    if (used > budget)
+    {
+        printf("BENCH hid_budget: FAILED, %zu bytes for %d devices, budget %zu\n", used, SIM_BUDGET_DEVICES, budget);
+        exit(1);
+    }
+    printf("BENCH hid_budget: %d dual-interface devices in %zu bytes (budget %zu): %zu per device (max %zu), "
+           "shared EP0 %zu; per-device EP0 would need %zu\n",
+           SIM_BUDGET_DEVICES, used, budget, st.device_bytes / st.devices, st.device_max_bytes, st.ep0_bytes,
+           eager);
+}
+
+void sim_uhid_start(void)
+{
+    const char *env = getenv("SIM_UHID_DEVICES");
+    int count = env ? atoi(env) : 1;
+    count = count < 1 ? 1 : (count > SIM_UHID_DEVICES ? SIM_UHID_DEVICES : count);
+    env = getenv("SIM_UHID_INTERVAL_MS");
+    if (env && atoi(env) > 0)
+    {
+        s_interval_ms = atoi(env);
+    }
+    env = getenv("SIM_UHID_TEXT");
+    if (env && env[0])
+    {
+        s_text = env;
+    }
+    env = getenv("SIM_UHID_NKRO");
+    s_nkro = env && atoi(env) > 0;
+    env = getenv("SIM_UHID_NKRO_STALL_MS");
+    s_nkro_stall_ms = env ? atoi(env) : 0;
+    env = getenv("SIM_UHID_FLOOD_MS");
+    s_flood_ms = env ? atoi(env) : 0;
+    s_start_us = sim_now_us();
+
+    sim_install_mock();
+
+    for (int i = 0; i < count; i++)
+    {
+        s_devs[i].hidraw_fd = -1;
+        s_devs[i].evdev_fd = -1;
+        if (sim_create_device(&s_devs[i], i) != 0)
+        {
+            break;
+        }
+        s_num_devs++;
+    }
+    for (int i = 0; i < s_num_devs; i++)
+    {
+        xTaskCreate(sim_typing_task, "sim_typing_task", 4096, &s_devs[i], 5, NULL);
+    }
+    xTaskCreate(sim_stats_task, "sim_stats_task", 4096, NULL, 1, NULL);
+    ESP_LOGW(TAG, "%d virtual keyboard(s)%s, report interval %d ms", s_num_devs,
+             s_nkro ? " with NKRO interface" : "", s_interval_ms);
+}
@@ -0,0 +1,32 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+// Linux 仿真测试台: 通过 /dev/uhid 创建虚拟 Boot 键盘, 从 hidraw 读回内核
+// 转发的报告, 再经 USB Host mock 交给 HID 驱动, 整条链路无需 ESP32.
+//
+// 环境变量:
+//   SIM_UHID_DEVICES      虚拟键盘数量 (默认 1, 最多 8)
+//   SIM_UHID_INTERVAL_MS  报告间隔, 单位毫秒 (默认 20)
+//   SIM_UHID_TEXT         每个键盘循环输入的文本 (默认 "hello world\n")
+//   SIM_UHID_NKRO         1: 每个虚拟键盘再提供一个 NKRO 接口, 报告相同的按键 (默认 0)
+//   SIM_UHID_NKRO_STALL_MS  NKRO 接口在启动多久后停止报告, 用于测试接管 (默认 0, 不停止)
+
+// 创建虚拟键盘并接管 USB Host mock, 必须在 usb_host_install() 之前调用:
+void sim_uhid_start(void);
+
+// 打印每个虚拟键盘的报告数和 uhid 写入到驱动回调的延迟:
+void sim_uhid_print_stats(void);
+
+// 投递开销测试 (SIM_BENCH=1): 不使用 uhid, 由 mock 直接为 8 个虚拟键盘完成 IN 传输,
+// 比较 HID 驱动逐份回调与批量投递的每报告开销:
+void sim_uhid_bench(void);
+
+// 热插拔内存测试 (SIM_BENCH=1, 在 sim_uhid_bench() 之后调用): 随机插拔虚拟键盘 cycles 次,
+// 检查 HID 驱动与 mock 传输的内存回到基准, 分配与释放次数相同, 堆占用在预热后不增长:
+void sim_uhid_churn(int cycles);
+
+// 多设备内存预算 (SIM_BENCH=1, 在 sim_uhid_churn() 之后调用): 同时连接 16 个双接口键盘,
+// 检查 HID 驱动为它们分配的内存 (含共享 EP0 传输) 不超过 budget 字节:
+void sim_uhid_budget(size_t budget);
@@ -0,0 +1,155 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "state_stream.h"
+
+#define KEY_NUM_LOCK 0x53
+#define KEY_CAPS_LOCK 0x39
+#define KEY_SCROLL_LOCK 0x47
+
+static key_state_t states[STATE_MAX_DEVICES];
+static uint32_t next_keyframe_ms[STATE_MAX_DEVICES];
+static bool keyframe_requested = true; // 启动后立即发送一次, 其他任务请求, 只用原子操作访问
+static state_stats_t stats;
+
+void state_init(uint32_t interval_ms, uint32_t max_percent, uint32_t link_bytes_per_sec)
+{
+    // 全部设备各发一个关键帧所需的带宽不能超过上限:
+    uint32_t min_interval_ms = (uint32_t)((uint64_t)FRAME_KEYFRAME_LEN * STATE_MAX_DEVICES * 1000 * 100 /
+                                          ((uint64_t)max_percent * link_bytes_per_sec));
+    stats.interval_ms = interval_ms > min_interval_ms ? interval_ms : min_interval_ms;
+    ESP_LOGI("STATE", "Keyframe interval %" PRIu32 " ms (configured %" PRIu32 " ms, overhead cap %" PRIu32 "%%)",
+             stats.interval_ms, interval_ms, max_percent);
+}
+
+static void apply_event(key_state_t *st, uint8_t key, uint8_t flags, uint8_t modifier)
+{
+    if (flags & KEY_EVENT_PRESS)
+    {
+        st->keys[key >> 3] |= (uint8_t)(1 << (key & 7));
+    }
+    else
+    {
+        st->keys[key >> 3] &= (uint8_t)~(1 << (key & 7));
+    }
+    st->modifier = modifier;
+    if ((flags & KEY_EVENT_PRESS) && !(flags & KEY_EVENT_REPEAT))
+    {
+        st->locks ^= key == KEY_NUM_LOCK ? STATE_LOCK_NUM
+                     : key == KEY_CAPS_LOCK ? STATE_LOCK_CAPS
+                     : key == KEY_SCROLL_LOCK ? STATE_LOCK_SCROLL
+                                              : 0;
+    }
+}
+
+void state_apply(const key_event_t *event, size_t bytes)
+{
+    stats.delta_bytes += bytes;
+    if (event->dev >= STATE_MAX_DEVICES)
+    {
+        return;
+    }
+    apply_event(&states[event->dev], event->key_code, event->flags, event->modifier);
+}
+
+void state_clear(uint8_t dev)
+{
+    if (dev < STATE_MAX_DEVICES)
+    {
+        memset(&states[dev], 0, sizeof(states[dev]));
+    }
+}
+
+const key_state_t *state_get(uint8_t dev)
+{
+    return &states[dev];
+}
+
+void state_request_keyframe(void)
+{
+    __atomic_store_n(&keyframe_requested, true, __ATOMIC_RELEASE);
+}
+
+static size_t encode_keyframe(uint8_t dev, uint16_t seq, uint8_t *out)
+{
+    const key_state_t *st = &states[dev];
+    uint8_t payload[FRAME_KEYFRAME_PAYLOAD_LEN] = {seq & 0xFF, seq >> 8, dev, st->modifier, st->locks};
+    memcpy(&payload[5], st->keys, STATE_BITMAP_BYTES);
+    return frame_encode(FRAME_TYPE_KEYFRAME, payload, sizeof(payload), out);
+}
+
+size_t state_poll(uint32_t now_ms, uint16_t seq, const bool *active, size_t count, uint8_t *out, size_t budget)
+{
+    // 读取与清除必须是一次操作, 否则两者之间其他任务的请求会丢失:
+    bool on_demand = __atomic_exchange_n(&keyframe_requested, false, __ATOMIC_ACQ_REL);
+    size_t len = 0;
+    for (size_t dev = 0; dev < count && dev < STATE_MAX_DEVICES; dev++)
+    {
+        if (!active[dev] || (!on_demand && (int32_t)(now_ms - next_keyframe_ms[dev]) < 0))
+        {
+            continue;
+        }
+        if (len + FRAME_KEYFRAME_LEN > budget)
+        {
+            // 下个周期再发, 按需请求保留:
+            stats.deferred++;
+            if (on_demand)
+            {
+                __atomic_store_n(&keyframe_requested, true, __ATOMIC_RELEASE);
+            }
+            break;
+        }
+        len += encode_keyframe((uint8_t)dev, seq, &out[len]);
+        next_keyframe_ms[dev] = now_ms + stats.interval_ms;
+        stats.keyframes++;
+        stats.on_demand += on_demand;
+        stats.keyframe_bytes += FRAME_KEYFRAME_LEN;
+    }
+    return len;
+}
+
+const state_stats_t *state_get_stats(void)
+{
+    return &stats;
+}
+
+void state_log_stats(void)
+{
+    uint64_t total = stats.keyframe_bytes + stats.delta_bytes;
+    ESP_LOGI("STATE", "keyframes=%" PRIu32 " on_demand=%" PRIu32 " deferred=%" PRIu32 " interval=%" PRIu32
+                      " ms, bytes keyframe/delta=%" PRIu64 "/%" PRIu64 " overhead=%d%%",
+             stats.keyframes, stats.on_demand, stats.deferred, stats.interval_ms,
+             stats.keyframe_bytes, stats.delta_bytes, total ? (int)(stats.keyframe_bytes * 100 / total) : 0);
+}
+
+void state_receive(state_receiver_t *rx, const frame_parser_t *frame)
+{
+    const uint8_t *p = frame->payload;
+    if (frame->len < 3 || p[2] >= STATE_MAX_DEVICES)
+    {
+        return;
+    }
+    uint16_t seq = p[0] | p[1] << 8;
+    uint8_t dev = p[2];
+    if (frame->type == FRAME_TYPE_KEYFRAME && frame->len == FRAME_KEYFRAME_PAYLOAD_LEN)
+    {
+        key_state_t *st = &rx->state[dev];
+        st->modifier = p[3];
+        st->locks = p[4];
+        memcpy(st->keys, &p[5], STATE_BITMAP_BYTES);
+        rx->sync_seq[dev] = seq;
+        rx->synced[dev] = true;
+    }
+    else if (frame->type == FRAME_TYPE_EVENT && frame->len == FRAME_EVENT_PAYLOAD_LEN)
+    {
+        // 关键帧已包含更早的事件:
+        if (rx->synced[dev] && (int16_t)(seq - rx->sync_seq[dev]) < 0)
+        {
+            return;
+        }
+        apply_event(&rx->state[dev], p[5], p[3], p[4]);
+    }
+}
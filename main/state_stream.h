@@ -0,0 +1,78 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "event_queue.h"
+#include "frame.h"
+
+// 状态流: 二进制事件帧作为增量, 周期性 (以及按需) 发送每个键盘的完整状态关键帧,
+// 接收端丢帧或重启后在下一个关键帧处恢复, 不会出现永远按住的键.
+//
+// 关键帧负载: 序号 (u16 LE), 设备编号, 修饰键, 锁定状态, 256 位按键位图 (32 字节).
+// 序号为关键帧之后第一个增量事件的全局序号, 关键帧包含序号更小的全部事件.
+// 接收端规则: 收到关键帧后用它替换该设备的状态, 此后忽略该设备序号小于关键帧序号的事件.
+
+#define STATE_MAX_DEVICES 8
+#define STATE_BITMAP_BYTES 32
+#define FRAME_KEYFRAME_PAYLOAD_LEN (5 + STATE_BITMAP_BYTES)
+#define FRAME_KEYFRAME_LEN (FRAME_OVERHEAD + FRAME_KEYFRAME_PAYLOAD_LEN)
+
+// 锁定状态, 与 HID LED 输出报告的位一致:
+#define STATE_LOCK_NUM 0x01
+#define STATE_LOCK_CAPS 0x02
+#define STATE_LOCK_SCROLL 0x04
+
+typedef struct
+{
+    uint8_t keys[STATE_BITMAP_BYTES]; // 按下的键码位图, 修饰键为 0xE0 ~ 0xE7
+    uint8_t modifier;
+    uint8_t locks;                    // STATE_LOCK_*, 由 Caps / Num / Scroll Lock 的按下切换
+} key_state_t;
+
+typedef struct
+{
+    uint32_t keyframes;        // 已发送的关键帧
+    uint32_t on_demand;        // 其中按需发送的关键帧
+    uint32_t deferred;         // 因发送缓冲区不足推迟的关键帧
+    uint64_t keyframe_bytes;
+    uint64_t delta_bytes;
+    uint32_t interval_ms;      // 受开销上限约束后的实际关键帧间隔
+} state_stats_t;
+
+// interval_ms: 每个设备的关键帧间隔; max_percent: 关键帧占链路带宽的上限,
+// 按全部设备同时在线计算, 需要时延长关键帧间隔:
+void state_init(uint32_t interval_ms, uint32_t max_percent, uint32_t link_bytes_per_sec);
+
+// 按输出顺序应用一个已编码发送的事件, bytes 为其帧长度:
+void state_apply(const key_event_t *event, size_t bytes);
+
+// 事件丢失后清空该设备的状态, 按住的键视为已释放, 不会卡住:
+void state_clear(uint8_t dev);
+
+// 当前按输出顺序累积的设备状态:
+const key_state_t *state_get(uint8_t dev);
+
+// 请求尽快为所有设备发送关键帧, 可以在任意任务中调用:
+void state_request_keyframe(void);
+
+// 发送任务每个周期调用: 为到期的在线设备编码关键帧写入 out, 不超过 budget 字节.
+// seq 为下一个增量事件的全局序号, 返回写入的字节数:
+size_t state_poll(uint32_t now_ms, uint16_t seq, const bool *active, size_t count, uint8_t *out, size_t budget);
+
+const state_stats_t *state_get_stats(void);
+
+void state_log_stats(void);
+
+// 参考接收端, 用于主机测试: 按上述规则由帧恢复每个设备的状态:
+typedef struct
+{
+    key_state_t state[STATE_MAX_DEVICES];
+    uint16_t sync_seq[STATE_MAX_DEVICES]; // 最近关键帧的序号
+    bool synced[STATE_MAX_DEVICES];       // 是否已收到过关键帧
+} state_receiver_t;
+
+void state_receive(state_receiver_t *rx, const frame_parser_t *frame);
@@ -0,0 +1,439 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include <inttypes.h>
+#include "sdkconfig.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mbedtls/sha256.h"
+#include "table_store.h"
+#if !CONFIG_IDF_TARGET_LINUX
+#include "esp_partition.h"
+#endif
+
+#define TABLE_QUEUE_LEN 16  // 一个扇区擦写期间 (数十毫秒) 到达的上传帧
+#define TABLE_STATUS_RING 8 // 必须是 2 的幂
+
+typedef struct
+{
+    uint8_t len;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+} table_job_t;
+
+static size_t slot_size = 0;    // 每一半的大小, 0 表示没有分区
+static int active_slot = -1;    // 当前表所在的一半, -1 表示没有有效的表
+static uint32_t active_length = 0;
+static volatile uint32_t active_generation = 0;
+
+// 上传状态, 只在写入任务中访问:
+static bool uploading = false;
+static int target_slot = 0;
+static uint32_t upload_length = 0;
+static uint8_t upload_sha256[32];
+static uint32_t received = 0;       // 下一个期望的偏移
+static uint32_t written = 0;        // 已写入分区的字节数, 扇区对齐
+static bool resend_pending = false; // 已要求重发, 在期望的数据到达之前不重复要求
+static uint8_t sector_buf[TABLE_SECTOR];
+
+static QueueHandle_t job_queue = NULL;
+static table_commit_cb_t commit_cb = NULL;
+static TaskHandle_t notify_task = NULL;
+static table_stats_t stats;
+
+// 进度帧环形缓冲区, 写入任务写入, 发送任务读取:
+static uint8_t status_ring[TABLE_STATUS_RING][TABLE_STATUS_LEN];
+static volatile uint32_t status_head = 0;
+static volatile uint32_t status_tail = 0;
+
+static void push_status(uint8_t status, uint32_t offset, uint32_t generation)
+{
+    if (status_head - status_tail >= TABLE_STATUS_RING)
+    {
+        return;
+    }
+    uint8_t *p = status_ring[status_head % TABLE_STATUS_RING];
+    p[0] = status;
+    memcpy(&p[1], &offset, 4);
+    memcpy(&p[5], &generation, 4);
+    status_head++;
+    if (notify_task != NULL)
+    {
+        xTaskNotifyGive(notify_task);
+    }
+}
+
+size_t table_upload_status(uint8_t *out)
+{
+    if (status_tail == status_head)
+    {
+        return 0;
+    }
+    size_t len = frame_encode(FRAME_TYPE_UPLOAD_STATUS, status_ring[status_tail % TABLE_STATUS_RING],
+                              TABLE_STATUS_LEN, out);
+    status_tail++;
+    return len;
+}
+
+// 计算一半中镜像的 SHA-256, 借用扇区缓冲区逐扇区读取:
+static bool slot_sha256(int slot, uint32_t length, uint8_t *sha256)
+{
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    bool ok = true;
+    for (uint32_t pos = 0; pos < length && ok; pos += TABLE_SECTOR)
+    {
+        size_t n = length - pos < TABLE_SECTOR ? length - pos : TABLE_SECTOR;
+        ok = table_flash_read(slot * slot_size + TABLE_SECTOR + pos, sector_buf, n);
+        mbedtls_sha256_update(&ctx, sector_buf, n);
+    }
+    mbedtls_sha256_finish(&ctx, sha256);
+    mbedtls_sha256_free(&ctx);
+    return ok;
+}
+
+// 读取一半的头部, 镜像完整时返回 true:
+static bool slot_valid(int slot, table_header_t *header)
+{
+    uint8_t sha256[32];
+    return table_flash_read(slot * slot_size, header, sizeof(*header)) && header->magic == TABLE_MAGIC &&
+           header->length <= slot_size - TABLE_SECTOR && slot_sha256(slot, header->length, sha256) &&
+           memcmp(sha256, header->sha256, sizeof(sha256)) == 0;
+}
+
+bool table_store_init(void)
+{
+    size_t size = 0;
+    if (!table_flash_open(&size) || size < 4 * TABLE_SECTOR)
+    {
+        ESP_LOGW("TABLES", "No \"%s\" data partition, tables stay built in", TABLE_PARTITION_LABEL);
+        slot_size = 0;
+        return false;
+    }
+    slot_size = size / 2 / TABLE_SECTOR * TABLE_SECTOR;
+    active_slot = -1;
+    active_length = 0;
+    active_generation = 0;
+    uploading = false;
+    for (int slot = 0; slot < 2; slot++)
+    {
+        table_header_t header;
+        // 代数按 32 位回绕比较:
+        if (slot_valid(slot, &header) && (active_slot < 0 || (int32_t)(header.generation - active_generation) > 0))
+        {
+            active_slot = slot;
+            active_length = header.length;
+            active_generation = header.generation;
+        }
+    }
+    if (active_slot < 0)
+    {
+        ESP_LOGI("TABLES", "Partition %u bytes, no valid table image", (unsigned)size);
+        return true;
+    }
+    ESP_LOGI("TABLES", "Using table image generation %" PRIu32 " in slot %c, %" PRIu32 " bytes",
+             active_generation, 'A' + active_slot, active_length);
+    return true;
+}
+
+uint32_t table_store_generation(void)
+{
+    return active_generation;
+}
+
+size_t table_store_read(uint8_t tag, void *out, size_t max)
+{
+    if (active_slot < 0)
+    {
+        return 0;
+    }
+    size_t base = active_slot * slot_size + TABLE_SECTOR;
+    uint32_t pos = 0;
+    while (pos + 4 <= active_length)
+    {
+        uint8_t head[4];
+        if (!table_flash_read(base + pos, head, sizeof(head)))
+        {
+            return 0;
+        }
+        uint32_t len = head[1] | head[2] << 8 | (uint32_t)head[3] << 16;
+        if (len > active_length - pos - 4)
+        {
+            ESP_LOGE("TABLES", "Section 0x%02x at %" PRIu32 " runs past the image", head[0], pos);
+            return 0;
+        }
+        if (head[0] == tag)
+        {
+            if (len > max)
+            {
+                ESP_LOGE("TABLES", "Section 0x%02x is %" PRIu32 " bytes, limit %u", tag, len, (unsigned)max);
+                return 0;
+            }
+            return table_flash_read(base + pos + 4, out, len) ? len : 0;
+        }
+        pos += 4 + len;
+    }
+    return 0;
+}
+
+// 把扇区缓冲区中的 n 字节写入目标一半的下一个扇区:
+static bool write_sector(size_t n)
+{
+    int64_t start = esp_timer_get_time();
+    size_t offset = target_slot * slot_size + TABLE_SECTOR + written;
+    if (!table_flash_erase(offset, TABLE_SECTOR) || !table_flash_write(offset, sector_buf, n))
+    {
+        return false;
+    }
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+    stats.sector_max_us = elapsed > stats.sector_max_us ? elapsed : stats.sector_max_us;
+    stats.sectors++;
+    written += n;
+    return true;
+}
+
+static void upload_fail(uint8_t status)
+{
+    uploading = false;
+    push_status(status, received, active_generation);
+}
+
+static void upload_begin(const uint8_t *payload, size_t len)
+{
+    uint32_t length;
+    received = 0;
+    if (len < 37 || slot_size == 0)
+    {
+        upload_fail(TABLE_STATUS_ERROR);
+        return;
+    }
+    memcpy(&length, &payload[1], 4);
+    if (length == 0 || length > slot_size - TABLE_SECTOR)
+    {
+        ESP_LOGE("TABLES", "Image of %" PRIu32 " bytes does not fit in %u", length, (unsigned)(slot_size - TABLE_SECTOR));
+        upload_fail(TABLE_STATUS_ERROR);
+        return;
+    }
+    // 写入非当前的一半, 先擦除头部, 中途掉电时这一半不会被当作有效:
+    target_slot = active_slot == 0 ? 1 : 0;
+    if (!table_flash_erase(target_slot * slot_size, TABLE_SECTOR))
+    {
+        upload_fail(TABLE_STATUS_ERROR);
+        return;
+    }
+    uploading = true;
+    upload_length = length;
+    memcpy(upload_sha256, &payload[5], sizeof(upload_sha256));
+    written = 0;
+    resend_pending = false;
+    stats.uploads++;
+    ESP_LOGI("TABLES", "Receiving %" PRIu32 " byte image into slot %c", length, 'A' + target_slot);
+    push_status(TABLE_STATUS_OK, 0, active_generation);
+}
+
+static void upload_data(const uint8_t *payload, size_t len)
+{
+    uint32_t offset;
+    if (!uploading || len < 5)
+    {
+        push_status(TABLE_STATUS_ERROR, 0, active_generation);
+        return;
+    }
+    memcpy(&offset, &payload[1], 4);
+    const uint8_t *data = &payload[5];
+    size_t n = len - 5;
+    if (offset != received)
+    {
+        // 之前的帧丢失或主机超出窗口, 同一个缺口只要求一次重发:
+        if (!resend_pending)
+        {
+            resend_pending = true;
+            stats.resends++;
+            push_status(TABLE_STATUS_RESEND, received, active_generation);
+        }
+        return;
+    }
+    if (n > upload_length - received)
+    {
+        upload_fail(TABLE_STATUS_ERROR);
+        return;
+    }
+    resend_pending = false;
+    while (n > 0)
+    {
+        size_t fill = received - written;
+        size_t take = TABLE_SECTOR - fill < n ? TABLE_SECTOR - fill : n;
+        memcpy(&sector_buf[fill], data, take);
+        received += take;
+        data += take;
+        n -= take;
+        if (received - written == TABLE_SECTOR)
+        {
+            if (!write_sector(TABLE_SECTOR))
+            {
+                upload_fail(TABLE_STATUS_ERROR);
+                return;
+            }
+            push_status(TABLE_STATUS_OK, written, active_generation);
+        }
+    }
+}
+
+static void upload_commit(void)
+{
+    if (!uploading)
+    {
+        push_status(TABLE_STATUS_ERROR, 0, active_generation);
+        return;
+    }
+    if (received != upload_length)
+    {
+        push_status(TABLE_STATUS_RESEND, received, active_generation);
+        return;
+    }
+    if (received > written && !write_sector(received - written))
+    {
+        upload_fail(TABLE_STATUS_ERROR);
+        return;
+    }
+    // 校验分区中实际写入的内容, 而不是收到的数据:
+    int64_t start = esp_timer_get_time();
+    uint8_t sha256[32];
+    bool ok = slot_sha256(target_slot, upload_length, sha256);
+    stats.verify_us = (uint32_t)(esp_timer_get_time() - start);
+    if (!ok || memcmp(sha256, upload_sha256, sizeof(sha256)) != 0)
+    {
+        stats.hash_failures++;
+        ESP_LOGE("TABLES", "Image hash mismatch, slot %c discarded", 'A' + target_slot);
+        upload_fail(TABLE_STATUS_HASH_MISMATCH);
+        return;
+    }
+    // 头部先写 magic 之外的字段, 最后写 magic, 写入 magic 的一刻即为切换点:
+    table_header_t header = {
+        .generation = active_generation + 1,
+        .length = upload_length,
+        .magic = TABLE_MAGIC};
+    memcpy(header.sha256, upload_sha256, sizeof(header.sha256));
+    size_t base = target_slot * slot_size;
+    if (!table_flash_write(base, &header, offsetof(table_header_t, magic)) ||
+        !table_flash_write(base + offsetof(table_header_t, magic), &header.magic, sizeof(header.magic)))
+    {
+        upload_fail(TABLE_STATUS_ERROR);
+        return;
+    }
+    uploading = false;
+    active_slot = target_slot;
+    active_length = upload_length;
+    active_generation = header.generation;
+    stats.committed++;
+    ESP_LOGI("TABLES", "Switched to generation %" PRIu32 " in slot %c, verify %" PRIu32 " us",
+             active_generation, 'A' + active_slot, stats.verify_us);
+    if (commit_cb != NULL)
+    {
+        commit_cb(active_generation);
+    }
+    push_status(TABLE_STATUS_COMMITTED, upload_length, active_generation);
+}
+
+void table_upload_frame(const uint8_t *payload, size_t len)
+{
+    if (len < 1)
+    {
+        return;
+    }
+    switch (payload[0])
+    {
+    case TABLE_OP_BEGIN:
+        upload_begin(payload, len);
+        break;
+    case TABLE_OP_DATA:
+        upload_data(payload, len);
+        break;
+    case TABLE_OP_COMMIT:
+        upload_commit();
+        break;
+    case TABLE_OP_ABORT:
+        uploading = false;
+        break;
+    }
+}
+
+void table_upload_queue(const frame_parser_t *frame)
+{
+    table_job_t job = {.len = frame->len};
+    memcpy(job.payload, frame->payload, frame->len);
+    if (job_queue == NULL || xQueueSend(job_queue, &job, 0) != pdTRUE)
+    {
+        stats.dropped++;
+    }
+}
+
+// 写入任务: 优先级低于 HID 与发送任务, 扇区擦写期间按键照常转发, 到达的上传帧在队列中等待:
+static void table_task(void *pvParameters)
+{
+    table_job_t job;
+    while (1)
+    {
+        if (xQueueReceive(job_queue, &job, portMAX_DELAY) == pdTRUE)
+        {
+            table_upload_frame(job.payload, job.len);
+        }
+    }
+}
+
+void table_store_start(table_commit_cb_t on_commit, TaskHandle_t notify)
+{
+    commit_cb = on_commit;
+    notify_task = notify;
+    job_queue = xQueueCreate(TABLE_QUEUE_LEN, sizeof(table_job_t));
+    xTaskCreate(table_task, "table_task", 4096, NULL, 5, NULL);
+    ESP_LOGI("TABLES", "Table upload ready, %u bytes per slot", (unsigned)(slot_size ? slot_size - TABLE_SECTOR : 0));
+}
+
+const table_stats_t *table_store_get_stats(void)
+{
+    return &stats;
+}
+
+void table_store_log_stats(void)
+{
+    ESP_LOGI("TABLES", "generation=%" PRIu32 " uploads=%" PRIu32 " committed=%" PRIu32 " hash_failures=%" PRIu32
+                       " resends=%" PRIu32 " dropped=%" PRIu32 " sectors=%" PRIu32 " sector_max_us=%" PRIu32,
+             active_generation, stats.uploads, stats.committed, stats.hash_failures, stats.resends, stats.dropped,
+             stats.sectors, stats.sector_max_us);
+}
+
+#if !CONFIG_IDF_TARGET_LINUX
+
+static const esp_partition_t *partition = NULL;
+
+bool table_flash_open(size_t *size)
+{
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)TABLE_PARTITION_SUBTYPE,
+                                         TABLE_PARTITION_LABEL);
+    if (partition == NULL)
+    {
+        return false;
+    }
+    *size = partition->size;
+    return true;
+}
+
+bool table_flash_erase(size_t offset, size_t len)
+{
+    return esp_partition_erase_range(partition, offset, len) == ESP_OK;
+}
+
+bool table_flash_write(size_t offset, const void *data, size_t len)
+{
+    return esp_partition_write(partition, offset, data, len) == ESP_OK;
+}
+
+bool table_flash_read(size_t offset, void *data, size_t len)
+{
+    return esp_partition_read(partition, offset, data, len) == ESP_OK;
+}
+
+#endif
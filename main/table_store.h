@@ -0,0 +1,109 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "frame.h"
+
+// 数据表存储: 编码表等数据表打包为一个镜像, 保存在数据分区中. 分区分为 A/B 两半,
+// 上传写入非当前的一半, 回读校验 SHA-256 后写入头部, 代数更大的有效一半即为当前表.
+// 头部的 magic 最后写入, 任何时刻掉电, 重启后看到的都是完整的旧表或完整的新表.
+//
+// 每一半的第一个扇区只存放头部, 镜像从第二个扇区开始, 由若干段组成:
+//   [标签] [长度 u24 LE] [内容 ...]
+// 不认识的标签被跳过, 以后增加的布局、宏、设备修正等表不影响旧固件.
+//
+// 上传帧 FRAME_TYPE_UPLOAD 的负载以操作码开始:
+//   TABLE_OP_BEGIN   [长度 u32 LE] [SHA-256 32 字节]   开始上传, 擦除目标一半的头部
+//   TABLE_OP_DATA    [偏移 u32 LE] [数据 ...]           按偏移顺序发送
+//   TABLE_OP_COMMIT                                     回读校验并切换
+//   TABLE_OP_ABORT                                      放弃本次上传
+// 每写满一个扇区回复一个进度帧 FRAME_TYPE_UPLOAD_STATUS: [状态] [偏移 u32 LE] [代数 u32 LE].
+// 主机发送的数据最多领先最近一次 TABLE_STATUS_OK 的偏移 TABLE_UPLOAD_WINDOW 字节;
+// 收到 TABLE_STATUS_RESEND 时从其中的偏移起重发. 扇区的擦写在低优先级任务中进行.
+// 擦写默认会禁用 flash cache, 不在 IRAM 中的任务与中断 (包括 USB 与 UART 驱动) 要等待整个扇区擦除
+// (数十毫秒). sdkconfig 因此启用 CONFIG_SPI_FLASH_AUTO_SUSPEND: cache 未命中时擦写被挂起,
+// 按键转发每次最多多等 CONFIG_SPI_FLASH_SUSPEND_TSUS_VAL_US. 需要 flash 芯片支持挂起, 启动日志会报告.
+
+#define TABLE_PARTITION_LABEL "tables"
+#define TABLE_PARTITION_SUBTYPE 0x40 // 自定义数据分区类型, 见 partitions.csv
+#define TABLE_SECTOR 4096            // 擦除与写入单位
+#define TABLE_MAGIC 0x31424154       // "TAB1"
+
+#define TABLE_SECTION_ENCODER 0x01   // 编码表定义文本, 见 encoder.h
+
+#define TABLE_OP_BEGIN 0x01
+#define TABLE_OP_DATA 0x02
+#define TABLE_OP_COMMIT 0x03
+#define TABLE_OP_ABORT 0x04
+#define TABLE_DATA_MAX (FRAME_MAX_PAYLOAD - 5) // 每个数据帧的字节数上限
+
+#define TABLE_STATUS_OK 0x00            // 偏移之前的数据已写入
+#define TABLE_STATUS_RESEND 0x01        // 数据不连续或丢失, 从偏移起重发
+#define TABLE_STATUS_COMMITTED 0x02     // 校验通过, 新表已生效, 带新代数
+#define TABLE_STATUS_HASH_MISMATCH 0x03 // 回读的 SHA-256 不符, 本次上传作废
+#define TABLE_STATUS_ERROR 0x04         // 没有分区、镜像太大、没有进行中的上传或写入失败
+#define TABLE_STATUS_LEN 9
+#define TABLE_STATUS_FRAME_LEN (FRAME_OVERHEAD + TABLE_STATUS_LEN)
+
+#define TABLE_UPLOAD_WINDOW (2 * TABLE_SECTOR)
+
+// 镜像头部, 位于每一半的开头. magic 之前的字段先写入, magic 最后单独写入:
+typedef struct
+{
+    uint32_t generation; // 每次提交加 1
+    uint32_t length;     // 镜像长度
+    uint8_t sha256[32];  // 镜像的 SHA-256
+    uint32_t magic;
+} table_header_t;
+
+typedef struct
+{
+    uint32_t uploads;       // 开始的上传
+    uint32_t committed;     // 校验通过并切换的上传
+    uint32_t hash_failures; // 回读校验失败
+    uint32_t resends;       // 要求主机重发的次数
+    uint32_t dropped;       // 写入任务队列满时丢弃的帧
+    uint32_t sectors;       // 擦写的扇区
+    uint32_t sector_max_us; // 单个扇区擦除加写入的最长时间
+    uint32_t verify_us;     // 最近一次提交的回读校验时间
+} table_stats_t;
+
+typedef void (*table_commit_cb_t)(uint32_t generation);
+
+// 打开数据分区, 选出有效且代数最大的一半作为当前表. 没有分区时返回 false:
+bool table_store_init(void);
+
+// 当前表的代数, 没有有效的表时为 0:
+uint32_t table_store_generation(void);
+
+// 把当前表中标签为 tag 的段复制到 out, 返回长度; 没有该段或超过 max 字节时返回 0:
+size_t table_store_read(uint8_t tag, void *out, size_t max);
+
+// 启动写入任务. 提交成功后在写入任务中调用 on_commit, 有进度要发送时通知 notify 任务:
+void table_store_start(table_commit_cb_t on_commit, TaskHandle_t notify);
+
+// 命令任务中调用: 上传帧放入写入任务的队列, 队列满时丢弃, 主机之后会收到 TABLE_STATUS_RESEND:
+void table_upload_queue(const frame_parser_t *frame);
+
+// 处理一个上传帧的负载, 由写入任务调用, 主机测试中可以直接调用:
+void table_upload_frame(const uint8_t *payload, size_t len);
+
+// 发送任务调用: 有待发送的进度时编码一个 FRAME_TYPE_UPLOAD_STATUS 帧写入 out, 返回帧长度, 否则返回 0:
+size_t table_upload_status(uint8_t *out);
+
+const table_stats_t *table_store_get_stats(void);
+
+void table_store_log_stats(void);
+
+// 存储后端: 设备上为 "tables" 数据分区, Linux 仿真为内存 (见 sim/sim_table.c).
+// 偏移与长度都相对分区开头, 擦除按 TABLE_SECTOR 对齐:
+bool table_flash_open(size_t *size);
+bool table_flash_erase(size_t offset, size_t len);
+bool table_flash_write(size_t offset, const void *data, size_t len);
+bool table_flash_read(size_t offset, void *data, size_t len);
@@ -0,0 +1,155 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <string.h>
+#include <inttypes.h>
+#include "esp_log.h"
+#include "tx_queue.h"
+
+typedef struct
+{
+    uint32_t enqueue_us;
+    uint8_t len;
+    uint8_t data[TX_ITEM_MAX];
+} tx_item_t;
+
+typedef struct
+{
+    tx_item_t items[TX_QUEUE_ITEMS];
+    uint32_t head;
+    uint32_t tail;
+    size_t bytes;
+} tx_class_queue_t;
+
+// 仅由发送任务访问, 不需要加锁:
+static tx_class_queue_t queues[TX_CLASS_MAX];
+static tx_class_stats_t stats[TX_CLASS_MAX];
+
+tx_class_t tx_classify_char(char c)
+{
+    if ((c > 0 && c < 0x20 && c != '\n' && c != '\t' && c != '\b') || c == 0x7F)
+    {
+        return TX_CLASS_CONTROL;
+    }
+    return TX_CLASS_NORMAL;
+}
+
+bool tx_queue_push(tx_class_t cls, const uint8_t *data, size_t len, uint32_t now_us)
+{
+    tx_class_queue_t *q = &queues[cls];
+    if (q->head - q->tail >= TX_QUEUE_ITEMS || len > TX_ITEM_MAX)
+    {
+        stats[cls].dropped++;
+        return false;
+    }
+    tx_item_t *item = &q->items[q->head & (TX_QUEUE_ITEMS - 1)];
+    item->enqueue_us = now_us;
+    item->len = (uint8_t)len;
+    memcpy(item->data, data, len);
+    q->head++;
+    q->bytes += len;
+    return true;
+}
+
+static void tx_record_delay(tx_class_t cls, uint32_t delay_us)
+{
+    uint32_t ms = delay_us / 1000;
+    int bucket = 0;
+    while (bucket < TX_HIST_BUCKETS - 1 && ms >= (1u << bucket))
+    {
+        bucket++;
+    }
+    stats[cls].hist[bucket]++;
+    stats[cls].sent++;
+}
+
+size_t tx_queue_drain(uint8_t *out, size_t budget, uint32_t now_us)
+{
+    size_t len = 0;
+    bool starved_served = false;
+    while (1)
+    {
+        int cls = -1;
+        // 饥饿保护: 最低优先级优先检查, 每次调用最多破例一项:
+        if (!starved_served)
+        {
+            for (int c = TX_CLASS_MAX - 1; c > TX_CLASS_CONTROL; c--)
+            {
+                tx_class_queue_t *q = &queues[c];
+                if (q->head != q->tail &&
+                    now_us - q->items[q->tail & (TX_QUEUE_ITEMS - 1)].enqueue_us >= TX_STARVATION_MS * 1000u)
+                {
+                    cls = c;
+                    break;
+                }
+            }
+        }
+        if (cls >= 0)
+        {
+            starved_served = true;
+            stats[cls].starved++;
+        }
+        else
+        {
+            // 严格优先级:
+            for (int c = TX_CLASS_CONTROL; c < TX_CLASS_MAX; c++)
+            {
+                if (queues[c].head != queues[c].tail)
+                {
+                    cls = c;
+                    break;
+                }
+            }
+        }
+        if (cls < 0)
+        {
+            break;
+        }
+        tx_class_queue_t *q = &queues[cls];
+        tx_item_t *item = &q->items[q->tail & (TX_QUEUE_ITEMS - 1)];
+        if (len + item->len > budget)
+        {
+            break;
+        }
+        memcpy(out + len, item->data, item->len);
+        len += item->len;
+        q->bytes -= item->len;
+        tx_record_delay(cls, now_us - item->enqueue_us);
+        q->tail++;
+    }
+    return len;
+}
+
+size_t tx_queue_pending(void)
+{
+    size_t bytes = 0;
+    for (int c = 0; c < TX_CLASS_MAX; c++)
+    {
+        bytes += queues[c].bytes;
+    }
+    return bytes;
+}
+
+const tx_class_stats_t *tx_queue_get_stats(tx_class_t cls)
+{
+    return &stats[cls];
+}
+
+void tx_queue_log_stats(void)
+{
+    static const char *names[TX_CLASS_MAX] = {"control", "normal", "bulk"};
+    for (int c = 0; c < TX_CLASS_MAX; c++)
+    {
+        const tx_class_stats_t *st = &stats[c];
+        if (st->sent == 0 && st->dropped == 0)
+        {
+            continue;
+        }
+        const uint32_t *h = st->hist;
+        ESP_LOGI("TXQ", "%s: sent=%" PRIu32 " dropped=%" PRIu32 " starved=%" PRIu32
+                        " delay ms <1:%" PRIu32 " <2:%" PRIu32 " <4:%" PRIu32 " <8:%" PRIu32 " <16:%" PRIu32
+                        " <32:%" PRIu32 " <64:%" PRIu32 " <128:%" PRIu32 " <256:%" PRIu32 " >=256:%" PRIu32,
+                 names[c], st->sent, st->dropped, st->starved,
+                 h[0], h[1], h[2], h[3], h[4], h[5], h[6], h[7], h[8], h[9]);
+    }
+}
@@ -0,0 +1,48 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// 发送队列的优先级类别, 数值越小优先级越高:
+typedef enum
+{
+    TX_CLASS_CONTROL = 0, // 控制字符与中断 (Ctrl+C, Esc 等)
+    TX_CLASS_NORMAL,      // 普通按键
+    TX_CLASS_BULK,        // 按住重复、批量展开
+    TX_CLASS_MAX,
+} tx_class_t;
+
+#define TX_ITEM_MAX 16        // 每个队列项最多字节数, 可容纳一个带 RS-485 地址的二进制事件帧
+#define TX_QUEUE_ITEMS 64     // 每个类别的队列项数, 必须是 2 的幂
+#define TX_STARVATION_MS 100  // 低优先级队首等待超过该时间后, 每次取出时优先服务一项
+#define TX_HIST_BUCKETS 10    // 排队延迟直方图: <1, <2, <4 ... <256, >=256 ms
+
+typedef struct
+{
+    uint32_t sent;                      // 已发送的队列项
+    uint32_t dropped;                   // 队列满丢弃的队列项
+    uint32_t starved;                   // 因饥饿保护提前发送的队列项
+    uint32_t hist[TX_HIST_BUCKETS];     // 排队延迟分布
+} tx_class_stats_t;
+
+// 控制字符归入 CONTROL 类; 回车、Tab、退格属于普通输入, 不能越过之前的字符:
+tx_class_t tx_classify_char(char c);
+
+// 追加一项数据 (len <= TX_ITEM_MAX), 队列满时丢弃并返回 false:
+bool tx_queue_push(tx_class_t cls, const uint8_t *data, size_t len, uint32_t now_us);
+
+// 按严格优先级取出不超过 budget 字节写入 out, 返回字节数.
+// 低优先级队首等待超过 TX_STARVATION_MS 时, 本次先服务该项 (每次调用最多一项):
+size_t tx_queue_drain(uint8_t *out, size_t budget, uint32_t now_us);
+
+// 所有类别中等待发送的字节数:
+size_t tx_queue_pending(void);
+
+const tx_class_stats_t *tx_queue_get_stats(tx_class_t cls);
+
+// 输出各类别的排队延迟直方图:
+void tx_queue_log_stats(void);
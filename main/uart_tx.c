@@ -0,0 +1,129 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#include <inttypes.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "uart_tx.h"
+
+// uart_get_tx_buffer_free_size() 只扣除未发出的数据字节. 每次 uart_write_bytes() 还在环形缓冲区
+// (不分割类型) 中写入一个事件项, 数据按最大项长度的一半分块, 每块一个项头并按 4 字节对齐,
+// 这些开销直到中断发完这次写入的数据才释放. 同一个周期可能有多次写入 (重发、队列、快照、关键帧等),
+// 上个周期的写入也可能还没发完, 因此按每次未发完的写入分别扣除, 否则 uart_write_bytes() 会阻塞:
+#define UART_TX_ITEM_HEADER 8                              // 环形缓冲区项头
+#define UART_TX_EVENT_ITEM (UART_TX_ITEM_HEADER + 12)      // 每次写入的 uart_tx_data_t 事件项
+#define UART_TX_CHUNK_OVERHEAD (UART_TX_ITEM_HEADER + 3)   // 每个数据块的项头与对齐
+#define UART_TX_PENDING_MAX 32 // 跟踪的未发完写入数, 跟踪满时按没有空间处理
+
+static uart_port_t tx_port = UART_NUM_1;
+static size_t tx_buffer_size = 0;
+static uart_tx_stats_t stats;
+// 未发完的写入: 按写入顺序记录每次写入结束时的累计字节数与占用的项开销:
+static uint32_t written_total = 0;
+static uint32_t pending_end[UART_TX_PENDING_MAX];
+static uint16_t pending_overhead[UART_TX_PENDING_MAX];
+static uint32_t pending_head = 0, pending_tail = 0;
+static size_t pending_overhead_sum = 0;
+
+void uart_tx_init(uart_port_t port, size_t buffer_size)
+{
+    tx_port = port;
+    tx_buffer_size = buffer_size;
+}
+
+// 驱动把数据分块写入, 每块不超过最大项长度 (约为缓冲区的一半) 的一半:
+static size_t chunk_size(void)
+{
+    return tx_buffer_size / 4 > UART_TX_ITEM_HEADER ? tx_buffer_size / 4 - UART_TX_ITEM_HEADER : 1;
+}
+
+static size_t write_overhead(size_t len)
+{
+    return UART_TX_EVENT_ITEM + (len + chunk_size() - 1) / chunk_size() * UART_TX_CHUNK_OVERHEAD;
+}
+
+// 环形缓冲区中真正空闲的字节数, 顺便移除数据已经发完的写入:
+static size_t ring_free(void)
+{
+    size_t free_size = 0;
+    if (uart_get_tx_buffer_free_size(tx_port, &free_size) != ESP_OK)
+    {
+        return 0;
+    }
+    uint32_t drained = written_total - (uint32_t)(tx_buffer_size - free_size);
+    while (pending_tail != pending_head &&
+           (int32_t)(drained - pending_end[pending_tail % UART_TX_PENDING_MAX]) >= 0)
+    {
+        pending_overhead_sum -= pending_overhead[pending_tail % UART_TX_PENDING_MAX];
+        pending_tail++;
+    }
+    return free_size > pending_overhead_sum ? free_size - pending_overhead_sum : 0;
+}
+
+size_t uart_tx_free(void)
+{
+    size_t free_size = ring_free();
+    if (pending_head - pending_tail >= UART_TX_PENDING_MAX)
+    {
+        return 0;
+    }
+    // 扣除下一次写入自己的事件项与分块开销:
+    size_t overhead = UART_TX_EVENT_ITEM + (free_size / chunk_size() + 1) * UART_TX_CHUNK_OVERHEAD;
+    return free_size > overhead ? free_size - overhead : 0;
+}
+
+size_t uart_tx_write(const void *data, size_t len)
+{
+    size_t accepted = len;
+    size_t free_size = uart_tx_free();
+    if (accepted > free_size)
+    {
+        accepted = free_size;
+        stats.partial++;
+        stats.rejected += len - accepted;
+    }
+    stats.writes++;
+    if (accepted == 0)
+    {
+        return 0;
+    }
+
+    int64_t start = esp_timer_get_time();
+    int written = uart_write_bytes(tx_port, data, accepted);
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+    stats.stall_us += elapsed;
+    if (elapsed > stats.stall_max_us)
+    {
+        stats.stall_max_us = elapsed;
+    }
+    if (elapsed > UART_TX_STALL_US)
+    {
+        stats.stalls++;
+    }
+    if (written <= 0)
+    {
+        return 0;
+    }
+    stats.bytes += written;
+    written_total += (uint32_t)written;
+    size_t overhead = write_overhead((size_t)written);
+    pending_end[pending_head % UART_TX_PENDING_MAX] = written_total;
+    pending_overhead[pending_head % UART_TX_PENDING_MAX] = (uint16_t)overhead;
+    pending_head++;
+    pending_overhead_sum += overhead;
+    return (size_t)written;
+}
+
+const uart_tx_stats_t *uart_tx_get_stats(void)
+{
+    return &stats;
+}
+
+void uart_tx_log_stats(void)
+{
+    ESP_LOGI("UART", "tx: writes=%" PRIu32 " bytes=%" PRIu32 " partial=%" PRIu32 " rejected=%" PRIu32
+                     " stalls=%" PRIu32 " stall_us total=%" PRIu64 " max=%" PRIu32 " ring=%u free=%u",
+             stats.writes, stats.bytes, stats.partial, stats.rejected, stats.stalls, stats.stall_us,
+             stats.stall_max_us, (unsigned)tx_buffer_size, (unsigned)uart_tx_free());
+}
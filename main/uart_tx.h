@@ -0,0 +1,35 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/uart.h"
+
+#define UART_TX_STALL_US 100 // 单次写入耗时超过该值计为一次阻塞
+
+typedef struct
+{
+    uint32_t writes;        // 写入次数
+    uint32_t partial;       // 只被部分接受的写入次数
+    uint32_t stalls;        // 耗时超过 UART_TX_STALL_US 的写入次数
+    uint32_t bytes;         // 已接受的字节数
+    uint32_t rejected;      // TX 环形缓冲区已满而未被接受的字节数
+    uint64_t stall_us;      // 阻塞在 uart_write_bytes() 中的总时间
+    uint32_t stall_max_us;  // 单次最长阻塞时间
+} uart_tx_stats_t;
+
+// 记录使用的 UART 端口, 驱动必须已带 TX 环形缓冲区安装:
+void uart_tx_init(uart_port_t port, size_t tx_buffer_size);
+
+// TX 环形缓冲区当前可以用一次写入无阻塞写入的字节数, 已扣除未发完的写入与本次写入的项开销.
+// 与 uart_tx_write() 只在同一个任务中调用:
+size_t uart_tx_free(void);
+
+// 非阻塞写入: 只写入 TX 环形缓冲区能容纳的部分, 返回被接受的字节数:
+size_t uart_tx_write(const void *data, size_t len);
+
+const uart_tx_stats_t *uart_tx_get_stats(void);
+
+void uart_tx_log_stats(void);
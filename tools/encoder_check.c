@@ -0,0 +1,101 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+// 编码表定义的主机端检查工具: 按固件相同的代码编译定义, 报告错误位置与表的大小,
+// 并可编码给定的事件, 写入 NVS 之前先在主机上验证.
+//
+//   cc -O2 -Imain -o encoder_check tools/encoder_check.c main/encoder.c main/keymap.c main/frame.c
+//   ./encoder_check tools/encoders/vt100.enc press:0x52 press:0x04:0x02 release:0x04
+//
+// 事件参数: <press|release|repeat>:<键码>[:<修饰键>], 设备编号 0, 序号从 0 开始递增.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "encoder.h"
+
+#define DEF_MAX 65536
+
+static bool parse_event(const char *arg, key_event_t *event)
+{
+    char kind[16];
+    unsigned key, mod = 0;
+    if (sscanf(arg, "%15[a-z]:%i:%i", kind, &key, &mod) < 2 || key > 0xFF || mod > 0xFF)
+    {
+        return false;
+    }
+    *event = (key_event_t){.key_code = (uint8_t)key, .modifier = (uint8_t)mod};
+    if (strcmp(kind, "press") == 0)
+    {
+        event->flags = KEY_EVENT_PRESS;
+    }
+    else if (strcmp(kind, "repeat") == 0)
+    {
+        event->flags = KEY_EVENT_PRESS | KEY_EVENT_REPEAT;
+    }
+    else if (strcmp(kind, "release") != 0)
+    {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s definition [press|release|repeat:key[:mod] ...]\n", argv[0]);
+        return 2;
+    }
+    FILE *f = fopen(argv[1], "rb");
+    if (f == NULL)
+    {
+        perror(argv[1]);
+        return 2;
+    }
+    static char def[DEF_MAX];
+    size_t len = fread(def, 1, sizeof(def) - 1, f);
+    fclose(f);
+    def[len] = 0;
+    if (strlen(def) != len)
+    {
+        fprintf(stderr, "%s: contains NUL bytes\n", argv[1]);
+        return 1;
+    }
+
+    encoder_t enc;
+    if (!encoder_compile(&enc, def))
+    {
+        if (enc.error_line > 0)
+        {
+            fprintf(stderr, "%s:%d: %s\n", argv[1], enc.error_line, enc.error);
+        }
+        else
+        {
+            fprintf(stderr, "%s: %s\n", argv[1], enc.error);
+        }
+        return 1;
+    }
+    printf("%s: %u rules, %u planes, table %zu bytes, pool %zu bytes\n", argv[1], enc.rules, enc.planes,
+           encoder_memory(&enc) - enc.pool_len, enc.pool_len);
+    int status = 0;
+    for (int i = 2; i < argc; i++)
+    {
+        key_event_t event;
+        if (!parse_event(argv[i], &event))
+        {
+            fprintf(stderr, "bad event: %s\n", argv[i]);
+            status = 2;
+            continue;
+        }
+        uint8_t out[ENCODER_TEMPLATE_MAX];
+        size_t n = encoder_encode(&enc, &event, (uint16_t)(i - 2), out);
+        printf("%-20s", argv[i]);
+        for (size_t j = 0; j < n; j++)
+        {
+            printf(" %02X", out[j]);
+        }
+        printf(n ? "\n" : " (no output)\n");
+    }
+    encoder_free(&enc);
+    return status;
+}
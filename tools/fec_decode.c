@@ -0,0 +1,47 @@
+/**
+ * SPDX-License-Identifier: GPLv3
+ */
+// FEC 模式的主机端解码器: 从标准输入或串口设备读取编码后的字节流, 逐帧输出.
+//
+//   cc -O2 -Imain -o fec_decode tools/fec_decode.c main/fec.c main/frame.c
+//   stty -F /dev/ttyUSB0 115200 raw && ./fec_decode 8 < /dev/ttyUSB0
+//
+// 参数为交织深度, 必须与固件的 FEC_INTERLEAVE 一致.
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include "fec.h"
+
+int main(int argc, char **argv)
+{
+    int depth = argc > 1 ? atoi(argv[1]) : 8;
+    if (depth != 1 && depth != 2 && depth != 4 && depth != 8)
+    {
+        fprintf(stderr, "usage: %s [1|2|4|8] < stream\n", argv[0]);
+        return 2;
+    }
+    fec_init(depth);
+    fec_decoder_t dec = {0};
+    int c;
+    while ((c = getchar()) != EOF)
+    {
+        if (!fec_decode_byte(&dec, (uint8_t)c))
+        {
+            continue;
+        }
+        const uint8_t *f = dec.frame;
+        if (f[1] == FRAME_TYPE_EVENT && dec.frame_len == FRAME_EVENT_LEN)
+        {
+            printf("seq=%u dev=%u %s mod=0x%02X key=0x%02X\n", f[3] | f[4] << 8, f[5],
+                   (f[6] & KEY_EVENT_PRESS) ? "press  " : "release", f[7], f[8]);
+        }
+        else
+        {
+            printf("type=0x%02X len=%u\n", f[1], f[2]);
+        }
+        fflush(stdout);
+    }
+    fprintf(stderr, "frames=%" PRIu32 " corrected=%" PRIu32 " skipped=%" PRIu32 "\n",
+            dec.frames, dec.corrected, dec.skipped);
+    return 0;
+}
@@ -0,0 +1,37 @@
+#!/bin/sh
+# SPDX-License-Identifier: GPLv3
+# 流水线配置的大小与耗时报告: tools/pipelines/ 下每个配置片段构建一次 Linux 仿真,
+#   大小: 设备构建会编译的源文件 (build 目录下的 pipeline_srcs.txt) 对应目标文件的 text + data,
+#         keyboard_main.c 中未选择的阶段已被编译器删除, 其他阶段的源文件不计入;
+#   耗时: SIM_BENCH=pipeline 测得的每份报告从输入到取出发往传输层的字节的平均耗时.
+# 需要 ESP-IDF 环境 (export.sh), 在项目根目录运行:
+#
+#   tools/pipeline_report.sh                 # 所有配置
+#   tools/pipeline_report.sh binary table    # 指定配置
+#
+# 大小是主机目标文件的大小, 用于配置之间的比较, 不等于 ESP32 上的镜像大小.
+set -e
+cd "$(dirname "$0")/.."
+if [ $# -eq 0 ]; then
+    set -- $(ls tools/pipelines | sed -n 's/\.cfg$//p')
+fi
+
+printf '%-16s %10s %12s  %s\n' config "main bytes" "ns/report" stages
+for name in "$@"; do
+    dir="build/pipeline/$name"
+    mkdir -p "$dir"
+    # 默认值只在 sdkconfig 不存在时应用, 删除上一次生成的文件, 配置片段的修改才会生效:
+    rm -f "$dir/sdkconfig"
+    idf.py --preview -B "$dir" -D IDF_TARGET=linux -D SDKCONFIG="$dir/sdkconfig" \
+        -D SDKCONFIG_DEFAULTS="tools/pipelines/$name.cfg" build > "$dir.log" 2>&1 ||
+        { echo "$name: build failed, see $dir.log" >&2; exit 1; }
+    bytes=0
+    for src in $(cat "$dir/pipeline_srcs.txt"); do
+        obj="$dir/esp-idf/main/CMakeFiles/__idf_main.dir/$src.obj"
+        bytes=$((bytes + $(size "$obj" | awk 'NR == 2 { print $1 + $2 }')))
+    done
+    line=$(SIM_BENCH=pipeline "$dir/usb-keyboard-to-serial.elf" | grep -a 'BENCH pipeline:')
+    ns=$(echo "$line" | sed -n 's/.*: \([0-9.]*\) ns\/report.*/\1/p')
+    stages=$(echo "$line" | sed -n 's/.*output \([a-z]*\), stages \([a-z0-9_,]*\):.*/\1 \2/p')
+    printf '%-16s %10d %12s  %s\n' "$name" "$bytes" "$ns" "$stages"
+done